@@ -0,0 +1,495 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the content-addressed cache of the analysis of trace files
+ */
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#if !defined(TARGET_WINDOWS)
+#include <sys/stat.h>
+#else
+#include <direct.h>
+#endif
+
+#include "analysis_cache.h"
+#include "parallel_trace.h"
+
+using namespace std;
+
+#define PATTERNS_MAGIC      0x504d4c53  ///< "SLMP": signature of cached access patterns
+#define PATTERNS_VERSION    1           ///< Version of the format of cached access patterns
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// @return Path of the entry within the directory
+static string JoinPath(const string& dir, const string& name)
+{
+    return dir.empty() ? name : (dir + "/" + name);
+}
+
+/// Read a value of type T in binary format. @return false at the end of the input
+template <typename T> static bool Load(istream& is, T& val)
+{
+    return bool(is.read(reinterpret_cast<char*>(&val), sizeof(T)));
+}
+
+/*!
+ * Read count values of type T in binary format. The vector grows with the data read, so that a corrupted count
+ * fails at the end of the input rather than allocating memory for it
+ * @return false at the end of the input
+ */
+template <typename T> static bool LoadArray(istream& is, uint64_t count, vector<T>& vals)
+{
+    static const uint64_t CHUNK_SIZE = 0x100000;
+    vals.clear();
+    for (uint64_t pos = 0; pos != count;)
+    {
+        uint64_t chunkSize = std::min(count - pos, CHUNK_SIZE);
+        vals.resize(pos + chunkSize);
+        if (!is.read(reinterpret_cast<char*>(vals.data() + pos), chunkSize * sizeof(T)))
+        {
+            return false;
+        }
+        pos += chunkSize;
+    }
+    return true;
+}
+
+/// @return 64-bit value with well-mixed bits (finalizer of MurmurHash3)
+static inline uint64_t Mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    return hash ^ (hash >> 33);
+}
+
+static inline uint64_t RotateLeft(uint64_t val, uint32_t shift)
+{
+    return (val << shift) | (val >> (64 - shift));
+}
+
+/// @return Part of the name of the cache entry that identifies the filter value
+static string FilterName(uint32_t id)
+{
+    return (id == MemTraceThreadFilter::ANY) ? string("x") : to_string(id);
+}
+
+/* ============================================================================================= */
+// PatternCollector implementation
+/* ============================================================================================= */
+void PatternCollector::OnRecord(const MemTraceRecord& record)
+{
+    uint32_t addrs[MAX_SIMD_LANES];
+    const vector<MemTracePackedMemIns>& memInstructions = record.bbl->memInstructions;
+    for (uint32_t i = 0; i != memInstructions.size(); i++)
+    {
+        const MemTracePackedMemIns& memIns = memInstructions[i];
+        uint32_t numAddrs = GetLaneAddresses(memIns, record.execMask, record.InsPayload(i), addrs);
+        if (numAddrs != 0)
+        {
+            _patterns.Add(memIns.offset, record.execMask, addrs, numAddrs);
+        }
+    }
+    uint32_t bblId = record.bbl->bblId;
+    if (bblId >= _bblExecutions.size())
+    {
+        _bblExecutions.resize(bblId + 1, 0);
+    }
+    _bblExecutions[bblId]++;
+}
+
+void PatternCollector::Merge(const PatternCollector& other)
+{
+    const PatternStore& patterns = other._patterns;
+    for (const PatternStore::Pattern& pattern : patterns.Patterns())
+    {
+        _patterns.Add(pattern.offset, pattern.execMask, patterns.Addresses(pattern.addrsId),
+                      patterns.NumAddresses(pattern.addrsId), pattern.count);
+    }
+    if (other._bblExecutions.size() > _bblExecutions.size())
+    {
+        _bblExecutions.resize(other._bblExecutions.size(), 0);
+    }
+    for (uint32_t bblId = 0; bblId != other._bblExecutions.size(); bblId++)
+    {
+        _bblExecutions[bblId] += other._bblExecutions[bblId];
+    }
+}
+
+void PatternCollector::Store(TraceFileWriter& writer) const
+{
+    writer.Store((uint32_t)_bblExecutions.size());
+    writer.Write(_bblExecutions.data(), _bblExecutions.size() * sizeof(uint64_t));
+
+    // Interned address vectors: sizes followed by concatenated addresses
+    uint32_t numAddrVectors = _patterns.NumAddressVectors();
+    writer.Store(numAddrVectors);
+    for (uint32_t addrsId = 0; addrsId != numAddrVectors; addrsId++)
+    {
+        writer.Store(_patterns.NumAddresses(addrsId));
+    }
+    for (uint32_t addrsId = 0; addrsId != numAddrVectors; addrsId++)
+    {
+        writer.Write(_patterns.Addresses(addrsId), _patterns.NumAddresses(addrsId) * sizeof(uint32_t));
+    }
+
+    const vector<PatternStore::Pattern>& patterns = _patterns.Patterns();
+    writer.Store((uint64_t)patterns.size());
+    for (const PatternStore::Pattern& pattern : patterns)
+    {
+        writer.Store(pattern.offset);
+        writer.Store(pattern.execMask);
+        writer.Store(pattern.addrsId);
+        writer.Store(pattern.count);
+    }
+}
+
+bool PatternCollector::Load(istream& is)
+{
+    uint32_t numBbls;
+    uint32_t numAddrVectors;
+    if (!::Load(is, numBbls) || !LoadArray(is, numBbls, _bblExecutions) || !::Load(is, numAddrVectors))
+    {
+        return false;
+    }
+
+    vector<uint32_t> addrBegin(1, 0);
+    vector<uint32_t> sizes;
+    vector<uint32_t> addrPool;
+    if (!LoadArray(is, numAddrVectors, sizes))
+    {
+        return false;
+    }
+    for (uint32_t size : sizes)
+    {
+        if (size > MAX_SIMD_LANES) { return false; }
+        addrBegin.push_back(addrBegin.back() + size);
+    }
+    uint64_t numPatterns;
+    if (!LoadArray(is, addrBegin.back(), addrPool) || !::Load(is, numPatterns))
+    {
+        return false;
+    }
+
+    // Patterns are added in the stored order, so that interned IDs of address vectors are preserved
+    for (uint64_t i = 0; i != numPatterns; i++)
+    {
+        PatternStore::Pattern pattern;
+        if (!::Load(is, pattern.offset) || !::Load(is, pattern.execMask) || !::Load(is, pattern.addrsId) ||
+            !::Load(is, pattern.count) || (pattern.addrsId >= numAddrVectors))
+        {
+            return false;
+        }
+        _patterns.Add(pattern.offset, pattern.execMask, addrPool.data() + addrBegin[pattern.addrsId],
+                      sizes[pattern.addrsId], pattern.count);
+    }
+    return true;
+}
+
+void MapPatterns(const PatternCollector& patterns, const vector<MemTraceBblInfo>& bbls, ConflictHistogramCollector& collector)
+{
+    // Instruction offset -> (descriptor, BBL ID)
+    unordered_map<uint32_t, pair<const MemTracePackedMemIns*, uint32_t>> instructions;
+    for (const MemTraceBblInfo& bbl : bbls)
+    {
+        for (const MemTracePackedMemIns& memIns : bbl.memInstructions)
+        {
+            instructions.emplace(memIns.offset, make_pair(&memIns, bbl.bblId));
+        }
+    }
+
+    // Address payloads are rebuilt from lane addresses: bank models read the low dwords of enabled channels only
+    const PatternStore& store = patterns.Patterns();
+    uint8_t             payload[MAX_SIMD_LANES * sizeof(uint64_t)];
+    for (const PatternStore::Pattern& pattern : store.Patterns())
+    {
+        auto it = instructions.find(pattern.offset);
+        if (it == instructions.end())
+        {
+            continue;
+        }
+        const MemTracePackedMemIns& memIns   = *it->second.first;
+        const uint32_t*             addrs    = store.Addresses(pattern.addrsId);
+        uint32_t                    numAddrs = store.NumAddresses(pattern.addrsId);
+        uint32_t                    laneMask = MemTraceLaneMask(memIns, pattern.execMask);
+        uint32_t                    addrSize = MemTraceAddrSize(memIns);
+
+        memset(payload, 0, sizeof(payload));
+        uint32_t i = 0;
+        for (uint32_t lane = 0; (laneMask != 0) && (i != numAddrs); lane++, laneMask >>= 1)
+        {
+            if ((laneMask & 1) != 0)
+            {
+                memcpy(payload + lane * addrSize, &addrs[i++], sizeof(uint32_t));
+            }
+        }
+        collector.AddAccesses(memIns, it->second.second, pattern.execMask, payload, pattern.count);
+    }
+    collector.AddBblExecutions(patterns.BblExecutions());
+}
+
+/* ============================================================================================= */
+// AnalysisCache implementation
+/* ============================================================================================= */
+string AnalysisCache::HashFile(const string& path)
+{
+    static const size_t BLOCK_SIZE = 0x100000;
+
+    ifstream is(path, ios::binary);
+    if (!is)
+    {
+        return string();
+    }
+
+    // Two independent 64-bit hashes of 8-byte words: a word-wise FNV-1a and a multiply-rotate hash
+    vector<uint64_t> block(BLOCK_SIZE / sizeof(uint64_t));
+    uint64_t         hash1 = 0xcbf29ce484222325ull;
+    uint64_t         hash2 = 0x9e3779b97f4a7c15ull;
+    uint64_t         size  = 0;
+    while (is.read(reinterpret_cast<char*>(block.data()), BLOCK_SIZE) || (is.gcount() > 0))
+    {
+        size_t numBytes = (size_t)is.gcount();
+        size_t numWords = (numBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        memset(reinterpret_cast<char*>(block.data()) + numBytes, 0, numWords * sizeof(uint64_t) - numBytes);
+        for (size_t i = 0; i != numWords; i++)
+        {
+            hash1 = RotateLeft((hash1 ^ block[i]) * 0x100000001b3ull, 29);
+            hash2 = RotateLeft(hash2 + block[i] * 0xc2b2ae3d27d4eb4full, 31) * 0x9e3779b97f4a7c15ull;
+        }
+        size += numBytes;
+    }
+    if (!is.eof())
+    {
+        return string();
+    }
+
+    ostringstream os;
+    os << std::hex << std::setfill('0') << std::setw(16) << Mix(hash1 ^ size) << std::setw(16) << Mix(hash2 + size);
+    return os.str();
+}
+
+template <typename WriteFn>
+bool AnalysisCache::StoreEntry(const string& path, WriteFn write) const
+{
+    static atomic<uint64_t> tmpCounter(0);
+
+    // The directory may exist already, which is reported as an error
+    if (!_dir.empty())
+    {
+#if !defined(TARGET_WINDOWS)
+        mkdir(_dir.c_str(), 0755);
+#else
+        _mkdir(_dir.c_str());
+#endif
+    }
+
+    // The name of the temporary file is unique in threads and processes that share the cache
+    ostringstream tmpPath;
+    tmpPath << path << ".tmp" << std::hex << std::hash<thread::id>()(this_thread::get_id()) << "_"
+            << chrono::steady_clock::now().time_since_epoch().count() << "_" << tmpCounter++;
+    if (!write(tmpPath.str()) || (std::rename(tmpPath.str().c_str(), path.c_str()) != 0))
+    {
+        std::remove(tmpPath.str().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AnalysisCache::StorePatterns(const TracePatterns& patterns, const string& path) const
+{
+    return StoreEntry(path, [&patterns](const string& tmpPath)
+    {
+        TraceFileWriter writer;
+        if (!writer.Open(tmpPath))
+        {
+            return false;
+        }
+        writer.Store((uint32_t)PATTERNS_MAGIC);
+        writer.Store((uint32_t)PATTERNS_VERSION);
+        writer.Store(patterns.grfSize);
+        writer.Store((uint32_t)patterns.bbls.size());
+        for (const MemTraceBblInfo& bbl : patterns.bbls)
+        {
+            writer.Store(bbl.bblId);
+            writer.Store((uint32_t)bbl.memInstructions.size());
+            writer.Write(bbl.memInstructions.data(), bbl.memInstructions.size() * sizeof(MemTracePackedMemIns));
+        }
+        patterns.collector.Store(writer);
+        return writer.Close();
+    });
+}
+
+bool AnalysisCache::LoadPatterns(const string& path, bool withPatterns, TracePatterns& patterns)
+{
+    ifstream is(path, ios::binary);
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numBbls;
+    if (!is || !Load(is, magic) || (magic != PATTERNS_MAGIC) || !Load(is, version) || (version != PATTERNS_VERSION) ||
+        !Load(is, patterns.grfSize) || !Load(is, numBbls))
+    {
+        return false;
+    }
+    patterns.bbls.clear();
+    for (uint32_t i = 0; i != numBbls; i++)
+    {
+        MemTraceBblInfo bbl;
+        uint32_t        numMemIns;
+        if (!Load(is, bbl.bblId) || !Load(is, numMemIns) || !LoadArray(is, numMemIns, bbl.memInstructions))
+        {
+            return false;
+        }
+        patterns.bbls.push_back(std::move(bbl));
+    }
+    return !withPatterns || patterns.collector.Load(is);
+}
+
+bool AnalysisCache::ReadTrace(const string& tracePath, uint32_t grfSize, const MemTraceThreadFilter& filter,
+                              TaskPool* pool, TracePatterns& patterns, string& error)
+{
+    MemTraceFileReader reader(grfSize);
+    if (!reader.Open(tracePath))
+    {
+        error = reader.Error();
+        return false;
+    }
+    if (!filter.IsEmpty() && !reader.HasIndex())
+    {
+        error = tracePath + ": the file has no thread index, which is required to select threads";
+        return false;
+    }
+
+    if ((pool != nullptr) && reader.HasIndex())
+    {
+        vector<PatternCollector> shares(pool->NumWorkers());
+        vector<MemTraceVisitor*> visitors;
+        for (PatternCollector& share : shares) { visitors.push_back(&share); }
+        if (!ProcessThreadsParallel(reader, reader.SelectThreads(filter), *pool, visitors, error))
+        {
+            return false;
+        }
+        for (const PatternCollector& share : shares) { patterns.collector.Merge(share); }
+    }
+    else if (!(filter.IsEmpty() ? reader.Process(patterns.collector) :
+                                  reader.ProcessThreads(patterns.collector, reader.SelectThreads(filter))))
+    {
+        error = reader.Error();
+        return false;
+    }
+    patterns.grfSize = reader.GrfSize();
+    patterns.bbls    = reader.Bbls();
+    return true;
+}
+
+bool AnalysisCache::Analyze(const string& tracePath, const string& modelName, uint32_t numBanks, uint32_t grfSize,
+                            const MemTraceThreadFilter& filter, TaskPool* pool, unique_ptr<ConflictHistogramCollector>& collector,
+                            vector<MemTraceBblInfo>& bbls, string& error) const
+{
+    string hash = HashFile(tracePath);
+    if (hash.empty())
+    {
+        error = tracePath + ": could not read the file";
+        return false;
+    }
+
+    // Patterns depend on the trace, the GRF size and the selected threads; histograms also depend on the bank model
+    string key = hash;
+    if (grfSize != 0)
+    {
+        key += "_grf" + to_string(grfSize);
+    }
+    if (!filter.IsEmpty())
+    {
+        key += "_s" + FilterName(filter.sliceId) + "_ss" + FilterName(filter.subSliceId) + "_eu" +
+               FilterName(filter.euId) + "_ts" + FilterName(filter.threadSlot);
+    }
+    string modelKey = modelName;
+    for (char& c : modelKey)
+    {
+        if (!isalnum((unsigned char)c)) { c = '_'; }
+    }
+    string patternsPath   = JoinPath(_dir, key + ".patterns");
+    string histogramsPath = JoinPath(_dir, key + "_" + modelKey + "_nb" + to_string(numBanks) + ".histograms");
+
+    // Static information about the trace is stored at the beginning of its patterns
+    TracePatterns patterns;
+    bool          isRead = false;
+    if (!LoadPatterns(patternsPath, false, patterns))
+    {
+        patterns.bbls.clear();
+        if (!ReadTrace(tracePath, grfSize, filter, pool, patterns, error))
+        {
+            return false;
+        }
+        StorePatterns(patterns, patternsPath);
+        isRead = true;
+    }
+
+    // The "auto" model depends on the GRF size of the trace
+    SlmBankConfig bankConfig;
+    if (!SlmBankConfig::FromName(modelName, patterns.grfSize, bankConfig))
+    {
+        error = "Unknown SLM bank model " + modelName;
+        return false;
+    }
+    if (numBanks != 0)
+    {
+        bankConfig.numBanks = numBanks;
+    }
+    if (!bankConfig.IsValid())
+    {
+        error = "Invalid number of SLM banks " + to_string(bankConfig.numBanks);
+        return false;
+    }
+    collector.reset(new ConflictHistogramCollector(bankConfig));
+    bbls = patterns.bbls;
+
+    ifstream histograms(histogramsPath);
+    if (histograms && collector->Load(histograms))
+    {
+        return true;
+    }
+
+    // Map cached patterns to banks of the model, or read the trace if patterns are missing or corrupted
+    collector.reset(new ConflictHistogramCollector(bankConfig));
+    if (!isRead && !LoadPatterns(patternsPath, true, patterns))
+    {
+        TracePatterns tracePatterns;
+        if (!ReadTrace(tracePath, grfSize, filter, pool, tracePatterns, error))
+        {
+            return false;
+        }
+        StorePatterns(tracePatterns, patternsPath);
+        MapPatterns(tracePatterns.collector, tracePatterns.bbls, *collector);
+    }
+    else
+    {
+        MapPatterns(patterns.collector, patterns.bbls, *collector);
+    }
+    StoreEntry(histogramsPath, [&collector](const string& tmpPath)
+    {
+        ofstream os(tmpPath);
+        collector->Store(os);
+        os.close();
+        return bool(os);
+    });
+    return true;
+}
@@ -0,0 +1,154 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Content-addressed cache of the analysis of trace files. The analysis of a trace file is split into two steps:
+ *       reading the trace into a table of distinct SLM access patterns, which does not depend on the bank model, and
+ *       mapping the patterns to banks of the model. Results of both steps are cached by the hash of the trace file,
+ *       so that the analysis with other bank parameters maps the cached patterns without reading the trace
+ */
+
+#ifndef ANALYSIS_CACHE_H_
+#define ANALYSIS_CACHE_H_
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bank_conflicts.h"
+#include "pattern_store.h"
+#include "task_pool.h"
+#include "trace_file_writer.h"
+#include "trace_reader.h"
+
+/* ============================================================================================= */
+// Class PatternCollector
+/* ============================================================================================= */
+/*!
+ * Collects distinct SLM access patterns of all analyzed instructions, including broadcasts, and executions of BBLs.
+ * Patterns are keyed by the instruction offset, execution mask and addresses of enabled channels, which is all the
+ * bank models need besides the instruction descriptor
+ */
+class PatternCollector : public MemTraceVisitor
+{
+public:
+    /// Implementation of the MemTraceVisitor interface
+    void OnRecord(const MemTraceRecord& record) override;
+
+    /// Add patterns and BBL executions collected by another collector
+    void Merge(const PatternCollector& other);
+
+    /// Write patterns and BBL executions in the binary format
+    void Store(TraceFileWriter& writer) const;
+
+    /*!
+     * Read patterns and BBL executions written by Store() into the empty collector
+     * @return false if the input is not in this format
+     */
+    bool Load(std::istream& is);
+
+    const PatternStore&         Patterns()      const { return _patterns; }
+    const BblExecutionCounts&   BblExecutions() const { return _bblExecutions; }
+
+private:
+    PatternStore        _patterns;      ///< Distinct access patterns
+    BblExecutionCounts  _bblExecutions; ///< Number of records of each BBL
+};
+
+/*!
+ * Map access patterns to banks: add all occurrences of the patterns and BBL executions to the collector.
+ * The results are identical to the collector that processed the trace
+ * @param[in]  patterns   Access patterns and BBL executions of the trace
+ * @param[in]  bbls       Memory instructions of BBLs of the trace
+ * @param[out] collector  Collector of the bank model
+ */
+void MapPatterns(const PatternCollector& patterns, const std::vector<MemTraceBblInfo>& bbls,
+                 ConflictHistogramCollector& collector);
+
+/* ============================================================================================= */
+// Class AnalysisCache
+/* ============================================================================================= */
+/*!
+ * Directory of cached analyses of trace files. Entries are named by the hash of the contents of the trace file,
+ * followed by the GRF size and the thread filter of the analysis, if specified:
+ *  - <key>.patterns     Distinct access patterns, memory instructions and BBL executions of the trace (binary)
+ *  - <key>_<model>_nb<banks>.histograms  Histograms and bank cycles of the bank model (ConflictHistogramCollector::Store)
+ * Entries are written to temporary files and renamed, so that analyses of identical traces may run concurrently
+ * in any number of threads and processes. Entries are never evicted
+ */
+class AnalysisCache
+{
+public:
+    /// @param dir  Cache directory, created if it does not exist
+    explicit AnalysisCache(const std::string& dir) : _dir(dir) {}
+
+    /*!
+     * Analyze the trace file in the bank model. Cached histograms of the bank model are returned as is; otherwise
+     * cached patterns of the trace are mapped to banks, and the trace file is read only if its patterns are not cached
+     * @param[in]  tracePath  Trace file
+     * @param[in]  modelName  Name of the SLM bank model (see SlmBankConfig::FromName)
+     * @param[in]  numBanks   Number of banks that overrides the model, or 0
+     * @param[in]  grfSize    GRF size that overrides the one detected from the trace file, or 0
+     * @param[in]  filter     Threads to analyze
+     * @param[in]  pool       Pool that reads threads of files with the thread index in parallel, or nullptr
+     * @param[out] collector  Results of the analysis
+     * @param[out] bbls       Memory instructions of BBLs of the trace. Payload offsets are not restored from the cache
+     * @param[out] error      Description of the error
+     * @return false if the trace could not be analyzed. Errors of the cache itself are not fatal: the affected entries
+     *         are recomputed
+     */
+    bool Analyze(const std::string& tracePath, const std::string& modelName, uint32_t numBanks, uint32_t grfSize,
+                 const MemTraceThreadFilter& filter, TaskPool* pool, std::unique_ptr<ConflictHistogramCollector>& collector,
+                 std::vector<MemTraceBblInfo>& bbls, std::string& error) const;
+
+    const std::string& Dir() const { return _dir; }
+
+    /*!
+     * @return Hash of the contents of the file as 32 hex digits, or an empty string if the file could not be read.
+     *         The file is hashed in large blocks at the speed of reading, without parsing
+     */
+    static std::string HashFile(const std::string& path);
+
+private:
+    /// Access patterns of a trace file: the part of the analysis that does not depend on the bank model
+    struct TracePatterns
+    {
+        uint32_t                        grfSize = 0;    ///< GRF size of the trace
+        std::vector<MemTraceBblInfo>    bbls;           ///< Memory instructions of BBLs
+        PatternCollector                collector;      ///< Distinct access patterns and BBL executions
+    };
+
+    /// Read the trace file into patterns. @return false if the trace could not be read
+    static bool ReadTrace(const std::string& tracePath, uint32_t grfSize, const MemTraceThreadFilter& filter,
+                          TaskPool* pool, TracePatterns& patterns, std::string& error);
+
+    /// Write patterns to the cache entry. @return false on errors
+    bool StorePatterns(const TracePatterns& patterns, const std::string& path) const;
+
+    /*!
+     * Read patterns of the cache entry
+     * @param[in]  path          Path of the entry
+     * @param[in]  withPatterns  Read access patterns, or only the GRF size and memory instructions of BBLs
+     * @param[out] patterns      Patterns of the entry
+     * @return false if the entry does not exist or is corrupted
+     */
+    static bool LoadPatterns(const std::string& path, bool withPatterns, TracePatterns& patterns);
+
+    /*!
+     * Write the cache entry through a temporary file, renamed to the entry once complete
+     * @param path   Path of the entry
+     * @param write  Function that writes the file at the specified path and returns false on errors
+     * @return false on errors
+     */
+    template <typename WriteFn>
+    bool StoreEntry(const std::string& path, WriteFn write) const;
+
+    std::string _dir;   ///< Cache directory
+};
+
+#endif
@@ -0,0 +1,317 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the SLM bank conflict analysis
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+
+#include "bank_conflicts.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+uint32_t GetLaneAddresses(const MemTracePackedMemIns& memIns, uint32_t execMask, const uint8_t* payload, uint32_t* addrs)
+{
+    uint32_t laneMask = MemTraceLaneMask(memIns, execMask);
+    uint32_t addrSize = MemTraceAddrSize(memIns);
+
+    uint32_t numAddrs = 0;
+    for (uint32_t lane = 0; laneMask != 0; lane++, laneMask >>= 1)
+    {
+        if ((laneMask & 1) != 0)
+        {
+            // SLM offsets are 32-bit, so the low dword of a 64-bit address is sufficient
+            memcpy(&addrs[numAddrs++], payload + lane * addrSize, sizeof(uint32_t));
+        }
+    }
+    return numAddrs;
+}
+
+uint32_t ConflictDegree(const uint32_t* addrs, uint32_t numAddrs, uint32_t numBanks)
+{
+    uint32_t bankCounts[MAX_SIMD_LANES];
+    uint32_t banks[MAX_SIMD_LANES];
+    uint32_t numBankIds = 0;
+    uint32_t degree     = 0;
+    for (uint32_t i = 0; i != numAddrs; i++)
+    {
+        uint32_t bank = (addrs[i] / 4) % numBanks;
+        uint32_t j    = 0;
+        while ((j != numBankIds) && (banks[j] != bank)) { j++; }
+        if (j == numBankIds)
+        {
+            banks[numBankIds]       = bank;
+            bankCounts[numBankIds]  = 0;
+            numBankIds++;
+        }
+        degree = std::max(degree, ++bankCounts[j]);
+    }
+    return (degree > 1) ? degree : 0;
+}
+
+bool IsBroadcast(const uint32_t* addrs, uint32_t numAddrs)
+{
+    return ((uint32_t)std::count(addrs, addrs + numAddrs, addrs[0]) == numAddrs);
+}
+
+void WriteJson(const ConflictResults& results, ostream& os)
+{
+    os << "{";
+    const char* sep = "";
+    for (const auto& entry : results)
+    {
+        uint64_t total = 0;
+        for (const auto& bin : entry.second) { total += bin.second; }
+
+        os << sep << "\n  \"" << entry.first << "\": [";
+        const char* binSep = "";
+        for (const auto& bin : entry.second)
+        {
+            double percent = std::round(double(bin.second) / double(total) * 100 * 10000) / 10000;
+            os << binSep << "[" << bin.first << ", " << percent << "]";
+            binSep = ", ";
+        }
+        os << "]";
+        sep = ",";
+    }
+    os << "\n}\n";
+}
+
+/* ============================================================================================= */
+// BankConflictAnalyzer implementation
+/* ============================================================================================= */
+void BankConflictAnalyzer::OnRecord(const MemTraceRecord& record)
+{
+    uint32_t addrs[MAX_SIMD_LANES];
+    const vector<MemTracePackedMemIns>& memInstructions = record.bbl->memInstructions;
+    for (uint32_t i = 0; i != memInstructions.size(); i++)
+    {
+        const MemTracePackedMemIns& memIns = memInstructions[i];
+        uint32_t numAddrs = GetLaneAddresses(memIns, record.execMask, record.InsPayload(i), addrs);
+        if ((numAddrs != 0) && !IsBroadcast(addrs, numAddrs))
+        {
+            _patterns.Add(memIns.offset, record.execMask, addrs, numAddrs);
+        }
+    }
+}
+
+ConflictResults BankConflictAnalyzer::Results() const
+{
+    // The conflict degree depends on lane addresses only, so it is computed once per interned address vector
+    vector<int32_t> degrees(_patterns.NumAddressVectors(), -1);
+
+    // (offset, address vector ID) pairs counted in the "unique" mode
+    unordered_set<uint64_t> uniquePatterns;
+
+    ConflictResults results;
+    for (const PatternStore::Pattern& pattern : _patterns.Patterns())
+    {
+        int32_t& degree = degrees[pattern.addrsId];
+        if (degree < 0)
+        {
+            degree = (int32_t)ConflictDegree(_patterns.Addresses(pattern.addrsId), _patterns.NumAddresses(pattern.addrsId), _numBanks);
+        }
+
+        if (!_countUnique)
+        {
+            results[pattern.offset][degree] += pattern.count;
+        }
+        else if (uniquePatterns.insert((uint64_t(pattern.offset) << 32) | pattern.addrsId).second)
+        {
+            results[pattern.offset][degree]++;
+        }
+    }
+    return results;
+}
+
+/* ============================================================================================= */
+// ConflictHistogramCollector implementation
+/* ============================================================================================= */
+void ConflictHistogramCollector::OnRecord(const MemTraceRecord& record)
+{
+    const vector<MemTracePackedMemIns>& memInstructions = record.bbl->memInstructions;
+    for (uint32_t i = 0; i != memInstructions.size(); i++)
+    {
+        AddAccesses(memInstructions[i], record.bbl->bblId, record.execMask, record.InsPayload(i), 1);
+    }
+    AddBblExecution(record.bbl->bblId);
+}
+
+void ConflictHistogramCollector::OnColumnarRecord(const MemTraceColumnarRecord& record)
+{
+    // Addresses of the column are placed at their channels, which the bank model reads as a payload of 32-bit
+    // addresses. The execution mask passed to the bank model is limited to the channels of the column, so that
+    // channels left from previous instructions are not read
+    uint32_t        laneAddrs[MAX_SIMD_LANES] = {};
+    const uint32_t* addr = record.addresses;
+    for (const MemTracePackedMemIns& memIns : record.bbl->memInstructions)
+    {
+        uint32_t laneMask = MemTraceColumnLaneMask(memIns, record.execMask, record.grfSize);
+        if (laneMask == 0) { continue; }
+        uint32_t execMask = laneMask << memIns.channelOffset;
+        for (uint32_t lane = 0; laneMask != 0; lane++, laneMask >>= 1)
+        {
+            if ((laneMask & 1) != 0) { laneAddrs[lane] = *(addr++); }
+        }
+        MemTracePackedMemIns dwordIns = memIns;
+        dwordIns.addressWidth = 0;
+        AddAccesses(dwordIns, record.bbl->bblId, execMask, (const uint8_t*)laneAddrs, 1);
+    }
+    AddBblExecution(record.bbl->bblId);
+}
+
+void ConflictHistogramCollector::AddBblExecution(uint32_t bblId)
+{
+    if (bblId >= _bblExecutions.size())
+    {
+        _bblExecutions.resize(bblId + 1, 0);
+    }
+    _bblExecutions[bblId]++;
+    _numRecords++;
+}
+
+void ConflictHistogramCollector::AddAccesses(const MemTracePackedMemIns& memIns, uint32_t bblId, uint32_t execMask,
+                                             const uint8_t* payload, uint64_t count)
+{
+    SlmAccessCost cost;
+    if (!_model.Evaluate(memIns, execMask, payload, cost))
+    {
+        return;
+    }
+    SlmInsCost& insCost = _costs[memIns.offset];
+    insCost.bblId        = bblId;
+    insCost.numAccesses += count;
+    insCost.numLanes    += cost.numLanes * count;
+    insCost.cycles      += cost.cycles * count;
+    insCost.minCycles   += cost.minCycles * count;
+    if (!cost.isBroadcast)
+    {
+        _results[memIns.offset][cost.degree] += count;
+    }
+}
+
+void ConflictHistogramCollector::AddBblExecutions(const BblExecutionCounts& bblExecutions)
+{
+    if (bblExecutions.size() > _bblExecutions.size())
+    {
+        _bblExecutions.resize(bblExecutions.size(), 0);
+    }
+    for (uint32_t bblId = 0; bblId != bblExecutions.size(); bblId++)
+    {
+        _bblExecutions[bblId] += bblExecutions[bblId];
+        _numRecords           += bblExecutions[bblId];
+    }
+}
+
+void ConflictHistogramCollector::Merge(const ConflictHistogramCollector& other)
+{
+    for (const auto& entry : other._results)
+    {
+        ConflictHistogram& histogram = _results[entry.first];
+        for (const auto& bin : entry.second) { histogram[bin.first] += bin.second; }
+    }
+    for (const auto& entry : other._costs)
+    {
+        SlmInsCost& insCost = _costs[entry.first];
+        insCost.bblId        = entry.second.bblId;
+        insCost.numAccesses += entry.second.numAccesses;
+        insCost.numLanes    += entry.second.numLanes;
+        insCost.cycles      += entry.second.cycles;
+        insCost.minCycles   += entry.second.minCycles;
+    }
+    if (other._bblExecutions.size() > _bblExecutions.size())
+    {
+        _bblExecutions.resize(other._bblExecutions.size(), 0);
+    }
+    for (uint32_t bblId = 0; bblId != other._bblExecutions.size(); bblId++)
+    {
+        _bblExecutions[bblId] += other._bblExecutions[bblId];
+    }
+    _numRecords += other._numRecords;
+}
+
+void ConflictHistogramCollector::Store(ostream& os) const
+{
+    os << "slm_histograms 1\n" << "records " << _numRecords << "\n" << "bbls " << _bblExecutions.size();
+    for (uint64_t count : _bblExecutions) { os << " " << count; }
+    os << "\n";
+    for (const auto& entry : _costs)
+    {
+        const SlmInsCost& cost = entry.second;
+        os << "ins " << entry.first << " " << cost.bblId << " " << cost.numAccesses << " " << cost.numLanes << " "
+           << cost.cycles << " " << cost.minCycles << " ";
+        auto histogram = _results.find(entry.first);
+        if (histogram == _results.end())
+        {
+            os << "-\n";
+            continue;
+        }
+        const char* sep = "";
+        for (const auto& bin : histogram->second)
+        {
+            os << sep << bin.first << ":" << bin.second;
+            sep = ",";
+        }
+        os << "\n";
+    }
+}
+
+bool ConflictHistogramCollector::Load(istream& is)
+{
+    _results.clear();
+    _costs.clear();
+    _bblExecutions.clear();
+    _numRecords = 0;
+
+    string   key;
+    uint32_t version  = 0;
+    uint32_t numBbls  = 0;
+    if (!(is >> key >> version) || (key != "slm_histograms") || (version != 1) ||
+        !(is >> key >> _numRecords) || (key != "records") || !(is >> key >> numBbls) || (key != "bbls"))
+    {
+        return false;
+    }
+    _bblExecutions.resize(numBbls);
+    for (uint64_t& count : _bblExecutions)
+    {
+        if (!(is >> count)) { return false; }
+    }
+    while (is >> key)
+    {
+        uint32_t    offset;
+        SlmInsCost  cost;
+        string      histogram;
+        if ((key != "ins") || !(is >> offset >> cost.bblId >> cost.numAccesses >> cost.numLanes >> cost.cycles >>
+                                      cost.minCycles >> histogram))
+        {
+            return false;
+        }
+        _costs[offset] = cost;
+        if (histogram == "-") { continue; }
+
+        istringstream hs(histogram);
+        uint32_t      degree;
+        uint64_t      count;
+        char          colon;
+        char          comma = ',';
+        while ((comma == ',') && (hs >> degree >> colon >> count) && (colon == ':'))
+        {
+            _results[offset][degree] += count;
+            if (!(hs >> comma)) { comma = '\0'; }
+        }
+        if (comma != '\0') { return false; }
+    }
+    return is.eof();
+}
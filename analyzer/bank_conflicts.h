@@ -0,0 +1,166 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file SLM bank conflict analysis of memory traces
+ */
+
+#ifndef BANK_CONFLICTS_H_
+#define BANK_CONFLICTS_H_
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "bank_model.h"
+#include "conflict_kernel.h"
+#include "pattern_store.h"
+#include "trace_reader.h"
+
+/*!
+ * Extract addresses accessed by enabled channels of the specified SLM instruction
+ * @param[in]  memIns     Memory instruction descriptor
+ * @param[in]  execMask   Dynamic execution mask of the record
+ * @param[in]  payload    Address payload of the instruction
+ * @param[out] addrs      Array of MAX_SIMD_LANES elements that receives the addresses
+ * @return Number of addresses stored in addrs
+ */
+uint32_t GetLaneAddresses(const MemTracePackedMemIns& memIns, uint32_t execMask, const uint8_t* payload, uint32_t* addrs);
+
+/*!
+ * @return Conflict degree of the specified SLM access: the max number of channels that access the same bank,
+ *         or 0 if all accesses go to different banks
+ */
+uint32_t ConflictDegree(const uint32_t* addrs, uint32_t numAddrs, uint32_t numBanks);
+
+/// @return true if all channels access the same address
+bool IsBroadcast(const uint32_t* addrs, uint32_t numAddrs);
+
+/// Conflict degree -> number of accesses (or distinct access patterns) with this degree
+using ConflictHistogram = std::map<uint32_t, uint64_t>;
+
+/// Instruction offset -> histogram of conflict degrees
+using ConflictResults = std::map<uint32_t, ConflictHistogram>;
+
+/*!
+ * Write conflict histograms in JSON format: { "<offset>": [[degree, percent], ...], ... }
+ * The format matches the dictionary returned by profiler.analyze_memtrace_result
+ */
+void WriteJson(const ConflictResults& results, std::ostream& os);
+
+/// Bank cycles of all dynamic executions of a SEND instruction
+struct SlmInsCost
+{
+    uint32_t    bblId       = 0;    ///< ID of the BBL that contains the instruction
+    uint64_t    numAccesses = 0;    ///< Number of executions with enabled channels
+    uint64_t    numLanes    = 0;    ///< Number of enabled channels in all executions
+    uint64_t    cycles      = 0;    ///< Bank cycles of all executions
+    uint64_t    minCycles   = 0;    ///< Bank cycles of all executions without bank conflicts
+
+    /// @return Estimated stall cycles caused by bank conflicts
+    uint64_t StallCycles() const { return cycles - minCycles; }
+};
+
+/// Instruction offset -> bank cycles of the instruction
+using SlmCostResults = std::map<uint32_t, SlmInsCost>;
+
+/// BBL ID -> number of executions
+using BblExecutionCounts = std::vector<uint64_t>;
+
+/* ============================================================================================= */
+// Class BankConflictAnalyzer
+/* ============================================================================================= */
+/*!
+ * Collects SLM access patterns of each SEND instruction and computes histograms of their conflict degrees.
+ * By default, each pattern is weighted by the number of its occurrences in the trace. In the "unique" mode,
+ * each distinct (instruction, lane addresses) pattern is counted once, as profiler.analyze_memtrace_result did
+ */
+class BankConflictAnalyzer : public MemTraceVisitor
+{
+public:
+    BankConflictAnalyzer(uint32_t numBanks, bool countUnique = false) : _numBanks(numBanks), _countUnique(countUnique) {}
+
+    /// Implementation of the MemTraceVisitor interface
+    void OnRecord(const MemTraceRecord& record) override;
+
+    /// @return Histograms of conflict degrees of all patterns collected so far
+    ConflictResults Results() const;
+
+private:
+    uint32_t        _numBanks;      ///< Number of SLM banks
+    bool            _countUnique;   ///< Count each distinct pattern once instead of weighting by occurrences
+    PatternStore    _patterns;      ///< Distinct non-broadcast access patterns
+};
+
+/* ============================================================================================= */
+// Class ConflictHistogramCollector
+/* ============================================================================================= */
+/*!
+ * Folds SLM accesses directly into per-instruction conflict degree histograms, without storing access patterns.
+ * Produces the same results as BankConflictAnalyzer in the default (weighted) mode with the Dword bank model,
+ * using memory proportional to the number of SEND instructions only. Bank cycles of each instruction are
+ * accumulated along with the histograms. Records of version 3 files are evaluated in the address column
+ * of the mapped file, without restoring address payloads
+ */
+class ConflictHistogramCollector : public MemTraceVisitor
+{
+public:
+    explicit ConflictHistogramCollector(uint32_t numBanks) : _model(SlmBankConfig::Dword(numBanks)) {}
+    explicit ConflictHistogramCollector(const SlmBankConfig& bankConfig) : _model(bankConfig) {}
+
+    /// Implementation of the MemTraceVisitor interface
+    void OnRecord(const MemTraceRecord& record) override;
+    bool ConsumesColumns() const override { return true; }
+    void OnColumnarRecord(const MemTraceColumnarRecord& record) override;
+
+    /*!
+     * Add count executions of the SLM instruction with the same lane addresses
+     * @param memIns    Memory instruction descriptor
+     * @param bblId     ID of the BBL that contains the instruction
+     * @param execMask  Dynamic execution mask of the record
+     * @param payload   Address payload of the instruction
+     * @param count     Number of executions
+     */
+    void AddAccesses(const MemTracePackedMemIns& memIns, uint32_t bblId, uint32_t execMask, const uint8_t* payload,
+                     uint64_t count);
+
+    /// Add executions of BBLs, each counted as a trace record
+    void AddBblExecutions(const BblExecutionCounts& bblExecutions);
+
+    /*!
+     * Add histograms and bank cycles collected by another collector with the same bank model, e.g. from another
+     * part of the trace. The result does not depend on the order of merges
+     */
+    void Merge(const ConflictHistogramCollector& other);
+
+    /// Write histograms, bank cycles and BBL executions in the text format. The bank model is not stored
+    void Store(std::ostream& os) const;
+
+    /*!
+     * Replace histograms, bank cycles and BBL executions by those written by Store()
+     * @return false if the input is not in this format
+     */
+    bool Load(std::istream& is);
+
+    const ConflictResults&      Results()       const { return _results; }
+    const SlmCostResults&       Costs()         const { return _costs; }
+    const BblExecutionCounts&   BblExecutions() const { return _bblExecutions; }    ///< Number of records of each BBL
+    const SlmBankModel&         BankModel()     const { return _model; }
+    uint64_t                    NumRecords()    const { return _numRecords; }
+
+private:
+    /// Count the execution of the BBL of a record
+    void AddBblExecution(uint32_t bblId);
+
+    SlmBankModel        _model;             ///< SLM bank model
+    ConflictResults     _results;           ///< Histograms of conflict degrees. Broadcasts are not counted
+    SlmCostResults      _costs;             ///< Bank cycles of instructions
+    BblExecutionCounts  _bblExecutions;     ///< Number of records of each BBL
+    uint64_t            _numRecords = 0;    ///< Number of processed trace records
+};
+
+#endif
@@ -0,0 +1,244 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of SLM bank models
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "bank_model.h"
+
+using namespace std;
+
+/// Max number of bank words accessed by a channel. Longer accesses are truncated
+static const uint32_t MAX_WORDS_PER_LANE = 16;
+
+/* ============================================================================================= */
+// Models of known platforms
+/* ============================================================================================= */
+/*!
+ * Bank models of supported platforms. Parameters are nominal values of the SLM organization of each
+ * GPU generation; this table is the single place to tune them
+ */
+static SlmBankConfig PlatformModel(const char* name, uint32_t numBanks, uint32_t laneGroupSize)
+{
+    SlmBankConfig config;
+    config.name             = name;
+    config.numBanks         = numBanks;
+    config.bankWidth        = 4;
+    config.broadcast        = SlmBroadcast::WORD;
+    config.laneGroupSize    = laneGroupSize;
+    config.isVectorAware    = true;
+    return config;
+}
+
+/// Gen9 - Xe-LP (32-byte GRF): 16 dword banks, SIMD32 messages are processed in two SIMD16 halves
+static SlmBankConfig Gen9Model()  { return PlatformModel("gen9", 16, 16); }
+
+/// Xe-HPC (64-byte GRF): 32 dword banks, SIMD32 messages are processed at once
+static SlmBankConfig XeHpcModel() { return PlatformModel("xe-hpc", 32, 32); }
+
+/* ============================================================================================= */
+// SlmBankConfig implementation
+/* ============================================================================================= */
+SlmBankConfig SlmBankConfig::Dword(uint32_t numBanks)
+{
+    SlmBankConfig config;
+    config.numBanks = numBanks;
+    return config;
+}
+
+bool SlmBankConfig::FromName(const string& name, uint32_t grfSize, SlmBankConfig& config, SlmPlatform platform)
+{
+    if (name == "auto")         { config = ForPlatform(platform, grfSize); }
+    else if (name == "dword")   { config = SlmBankConfig(); }
+    else if (name == "gen9")    { config = Gen9Model(); }
+    else if (name == "xe-hpc")  { config = XeHpcModel(); }
+    else                        { return false; }
+    return true;
+}
+
+SlmBankConfig SlmBankConfig::ForPlatform(SlmPlatform platform, uint32_t grfSize)
+{
+    switch (platform)
+    {
+    case SlmPlatform::GEN9:
+    case SlmPlatform::GEN11:
+    case SlmPlatform::XE_LP:    return Gen9Model();
+    case SlmPlatform::XE_HPC:   return XeHpcModel();
+    default:                    return ForGrfSize(grfSize);
+    }
+}
+
+SlmBankConfig SlmBankConfig::ForGrfSize(uint32_t grfSize)
+{
+    return (grfSize >= 64) ? XeHpcModel() : Gen9Model();
+}
+
+const char* SlmBankConfig::ModelNames()
+{
+    return "auto, dword, gen9, xe-hpc";
+}
+
+bool SlmBankConfig::IsValid() const
+{
+    bool isGroupValid = (laneGroupSize != 0) && (laneGroupSize <= MAX_SIMD_LANES) && ((laneGroupSize & (laneGroupSize - 1)) == 0);
+    return (numBanks != 0) && (numBanks <= MAX_SLM_BANKS) && (bankWidth != 0) && isGroupValid;
+}
+
+/* ============================================================================================= */
+// Model parameters
+/* ============================================================================================= */
+namespace
+{
+/// Parameters of the model known at compile time
+template <uint32_t NumBanksV, uint32_t BankWidthV, SlmBroadcast BroadcastV, uint32_t LaneGroupSizeV, bool IsVectorAwareV>
+struct StaticParams
+{
+    static const uint32_t MAX_BANKS = NumBanksV;
+
+    explicit StaticParams(const SlmBankConfig&) {}
+
+    uint32_t        NumBanks()      const { return NumBanksV; }
+    uint32_t        BankWidth()     const { return BankWidthV; }
+    SlmBroadcast    Broadcast()     const { return BroadcastV; }
+    uint32_t        LaneGroupSize() const { return LaneGroupSizeV; }
+    bool            IsVectorAware() const { return IsVectorAwareV; }
+
+    /// @return true if the configuration has these parameters
+    static bool Matches(const SlmBankConfig& config)
+    {
+        return (config.numBanks == NumBanksV) && (config.bankWidth == BankWidthV) && (config.broadcast == BroadcastV) &&
+               (config.laneGroupSize == LaneGroupSizeV) && (config.isVectorAware == IsVectorAwareV);
+    }
+};
+
+/// Parameters of the model known at run time only
+struct RuntimeParams
+{
+    static const uint32_t MAX_BANKS = MAX_SLM_BANKS;
+
+    explicit RuntimeParams(const SlmBankConfig& config) : _config(config) {}
+
+    uint32_t        NumBanks()      const { return _config.numBanks; }
+    uint32_t        BankWidth()     const { return _config.bankWidth; }
+    SlmBroadcast    Broadcast()     const { return _config.broadcast; }
+    uint32_t        LaneGroupSize() const { return _config.laneGroupSize; }
+    bool            IsVectorAware() const { return _config.isVectorAware; }
+
+    const SlmBankConfig& _config;
+};
+
+using Gen9Params  = StaticParams<16, 4, SlmBroadcast::WORD, 16, true>;
+using XeHpcParams = StaticParams<32, 4, SlmBroadcast::WORD, 32, true>;
+}
+
+/* ============================================================================================= */
+// SlmBankModel implementation
+/* ============================================================================================= */
+SlmBankModel::SlmBankModel(const SlmBankConfig& config) : _config(config), _kernel(config.numBanks)
+{
+    bool isDword = (config.bankWidth == 4) && (config.broadcast == SlmBroadcast::MESSAGE) &&
+                   (config.laneGroupSize == MAX_SIMD_LANES) && !config.isVectorAware;
+    if (isDword)                                { _evaluate = EvaluateDword; }
+    else if (Gen9Params::Matches(config))       { _evaluate = EvaluateModel<Gen9Params>; }
+    else if (XeHpcParams::Matches(config))      { _evaluate = EvaluateModel<XeHpcParams>; }
+    else                                        { _evaluate = EvaluateModel<RuntimeParams>; }
+}
+
+bool SlmBankModel::EvaluateDword(const SlmBankModel& model, const MemTracePackedMemIns& memIns, uint32_t execMask,
+                                 const uint8_t* payload, SlmAccessCost& cost)
+{
+    uint32_t laneMask = MemTraceLaneMask(memIns, execMask);
+    if (laneMask == 0) { return false; }
+
+    uint32_t numLanes = 0;
+    for (uint32_t mask = laneMask; mask != 0; mask &= mask - 1) { numLanes++; }
+
+    uint32_t numBanks = model._config.numBanks;
+    uint32_t degree   = model._kernel.Degree(memIns, execMask, payload);
+    cost.numLanes     = numLanes;
+    cost.isBroadcast  = (degree == CONFLICT_DEGREE_SKIPPED);
+    cost.degree       = cost.isBroadcast ? 0 : degree;
+    cost.minCycles    = cost.isBroadcast ? 1 : (numLanes + numBanks - 1) / numBanks;
+    cost.cycles       = std::max(cost.degree, cost.minCycles);
+    return true;
+}
+
+template <typename Params>
+bool SlmBankModel::EvaluateModel(const SlmBankModel& model, const MemTracePackedMemIns& memIns, uint32_t execMask,
+                                 const uint8_t* payload, SlmAccessCost& cost)
+{
+    uint32_t laneMask = MemTraceLaneMask(memIns, execMask);
+    if (laneMask == 0) { return false; }
+
+    const Params params(model._config);
+    uint32_t addrSize    = MemTraceAddrSize(memIns);
+    uint32_t accessSize  = params.IsVectorAware() ? std::max(1u, uint32_t(memIns.elementSize) * memIns.numElements) : 1;
+    uint32_t groupSize   = params.LaneGroupSize();
+    uint32_t groupBits   = (groupSize >= MAX_SIMD_LANES) ? UINT32_MAX : ((1u << groupSize) - 1);
+    uint32_t numBanks    = params.NumBanks();
+
+    uint32_t firstLane = 0;
+    while (((laneMask >> firstLane) & 1) == 0) { firstLane++; }
+    uint32_t firstAddr;
+    memcpy(&firstAddr, payload + firstLane * addrSize, sizeof(uint32_t));
+
+    cost = SlmAccessCost{0, 0, 0, 0, true};
+    uint32_t numGroups = 0;
+    uint32_t maxLoad   = 0;
+    uint32_t words[MAX_SIMD_LANES * MAX_WORDS_PER_LANE];
+    for (uint32_t groupBase = 0; groupBase < MAX_SIMD_LANES; groupBase += groupSize)
+    {
+        uint32_t groupMask = (laneMask >> groupBase) & groupBits;
+        if (groupMask == 0) { continue; }
+        numGroups++;
+
+        // Collect bank words accessed by channels of the group. SLM offsets are 32-bit, so the low dword
+        // of a 64-bit address is sufficient
+        uint32_t numWords = 0;
+        for (uint32_t lane = groupBase; groupMask != 0; lane++, groupMask >>= 1)
+        {
+            if ((groupMask & 1) == 0) { continue; }
+            uint32_t addr;
+            memcpy(&addr, payload + lane * addrSize, sizeof(uint32_t));
+            cost.isBroadcast = cost.isBroadcast && (addr == firstAddr);
+            cost.numLanes++;
+
+            uint32_t firstWord    = addr / params.BankWidth();
+            uint32_t numLaneWords = std::min((addr % params.BankWidth() + accessSize - 1) / params.BankWidth() + 1, MAX_WORDS_PER_LANE);
+            for (uint32_t w = 0; w != numLaneWords; w++) { words[numWords++] = firstWord + w; }
+        }
+        if (params.Broadcast() == SlmBroadcast::WORD)
+        {
+            std::sort(words, words + numWords);
+            numWords = (uint32_t)(std::unique(words, words + numWords) - words);
+        }
+
+        // The group takes as many cycles as the max number of words accessed in the same bank
+        uint16_t bankCounts[Params::MAX_BANKS];
+        memset(bankCounts, 0, numBanks * sizeof(uint16_t));
+        uint32_t load = 0;
+        for (uint32_t i = 0; i != numWords; i++)
+        {
+            load = std::max(load, (uint32_t)++bankCounts[words[i] % numBanks]);
+        }
+        cost.cycles    += load;
+        cost.minCycles += (numWords + numBanks - 1) / numBanks;
+        maxLoad         = std::max(maxLoad, load);
+    }
+
+    if (cost.isBroadcast)
+    {
+        // All channels read the same word, which each group receives in one cycle
+        cost.cycles    = numGroups;
+        cost.minCycles = numGroups;
+    }
+    cost.degree = (cost.cycles > cost.minCycles) ? maxLoad : 0;
+    return true;
+}
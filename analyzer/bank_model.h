@@ -0,0 +1,146 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file SLM bank models: bank width, bank count, broadcast rules, splitting of wide messages into lane groups
+ *       and multi-element messages. A bank model computes the conflict degree and the number of bank cycles
+ *       of each SLM access
+ */
+
+#ifndef BANK_MODEL_H_
+#define BANK_MODEL_H_
+
+#include <cstdint>
+#include <string>
+
+#include "conflict_kernel.h"
+
+/// Max number of SLM banks supported by bank models
+static const uint32_t MAX_SLM_BANKS = 256;
+
+/// Rule that decides which channels of an SLM access are served by a bank in the same cycle
+enum class SlmBroadcast
+{
+    MESSAGE,    ///< Only accesses where all channels access the same address are conflict-free
+    WORD        ///< Channels that access the same bank word are served together
+};
+
+/// Platforms whose SLM organization is known to the "auto" model
+enum class SlmPlatform
+{
+    UNKNOWN,    ///< The model is selected by the GRF size of the platform
+    GEN9,       ///< Gen9
+    GEN11,      ///< Gen11
+    XE_LP,      ///< Xe-LP (Gen12)
+    XE_HPC      ///< Xe-HPC
+};
+
+/* ============================================================================================= */
+// Struct SlmBankConfig
+/* ============================================================================================= */
+/*!
+ * Parameters of the SLM bank model. Bank word of the byte address is address / bankWidth,
+ * bank of the word is word % numBanks
+ */
+struct SlmBankConfig
+{
+    std::string     name            = "dword";                  ///< Name of the model
+    uint32_t        numBanks        = 16;                       ///< Number of SLM banks
+    uint32_t        bankWidth       = 4;                        ///< Width of the bank in bytes
+    SlmBroadcast    broadcast       = SlmBroadcast::MESSAGE;    ///< Broadcast rule
+    uint32_t        laneGroupSize   = MAX_SIMD_LANES;           ///< Channels processed in the same cycles (16 - SIMD32 is split into halves)
+    bool            isVectorAware   = false;                    ///< Channels access elementSize * numElements bytes, not a single word
+
+    /*!
+     * The model of the original analysis: 4-byte banks, broadcasts of the whole message, one word per channel.
+     * Conflict degrees of this model are identical to ConflictKernel
+     */
+    static SlmBankConfig Dword(uint32_t numBanks);
+
+    /*!
+     * @param[in]  name      Name of the model, or "auto" for the model of the profiled platform
+     * @param[in]  grfSize   Size of the GRF register of the profiled platform in bytes, used by "auto" if the platform
+     *                       is unknown
+     * @param[out] config    The model
+     * @param[in]  platform  Profiled platform, used by "auto"
+     * @return false if the name is unknown
+     */
+    static bool FromName(const std::string& name, uint32_t grfSize, SlmBankConfig& config,
+                         SlmPlatform platform = SlmPlatform::UNKNOWN);
+
+    /// @return Model of the platform. Unknown platforms are identified by the GRF size
+    static SlmBankConfig ForPlatform(SlmPlatform platform, uint32_t grfSize);
+
+    /// @return Model of the platform with the specified GRF size
+    static SlmBankConfig ForGrfSize(uint32_t grfSize);
+
+    /// @return Comma-separated names of known models, for usage messages
+    static const char* ModelNames();
+
+    /// @return false if parameters are out of the supported range
+    bool IsValid() const;
+};
+
+/* ============================================================================================= */
+// Struct SlmAccessCost
+/* ============================================================================================= */
+/// Cost of an SLM access in the bank model
+struct SlmAccessCost
+{
+    uint32_t    degree;         ///< Conflict degree: max number of accesses to the same bank in a cycle, 0 if none conflict
+    uint32_t    cycles;         ///< Number of bank cycles required by the access
+    uint32_t    minCycles;      ///< Number of bank cycles required if all accesses were spread across banks
+    uint32_t    numLanes;       ///< Number of enabled channels
+    bool        isBroadcast;    ///< All enabled channels access the same address
+
+    /// @return Cycles lost to bank conflicts
+    uint32_t ExtraCycles() const { return cycles - minCycles; }
+};
+
+/* ============================================================================================= */
+// Class SlmBankModel
+/* ============================================================================================= */
+/*!
+ * Evaluates SLM accesses in the bank model. Models of known platforms are specialized at compile time;
+ * other parameters use the portable implementation
+ */
+class SlmBankModel
+{
+public:
+    explicit SlmBankModel(const SlmBankConfig& config);
+
+    /*!
+     * @param[in]  memIns    Descriptor of the memory instruction
+     * @param[in]  execMask  Dynamic execution mask of the record (ce & dm)
+     * @param[in]  payload   Address payload of the instruction
+     * @param[out] cost      Cost of the access
+     * @return false if the instruction has no channels analyzed by MemTraceLaneMask
+     */
+    bool Evaluate(const MemTracePackedMemIns& memIns, uint32_t execMask, const uint8_t* payload, SlmAccessCost& cost) const
+    {
+        return _evaluate(*this, memIns, execMask, payload, cost);
+    }
+
+    const SlmBankConfig& Config() const { return _config; }
+
+private:
+    using EvaluateFn = bool (*)(const SlmBankModel& model, const MemTracePackedMemIns& memIns, uint32_t execMask,
+                                const uint8_t* payload, SlmAccessCost& cost);
+
+    /// Implementation of the Dword model, based on the conflict degree kernel
+    static bool EvaluateDword(const SlmBankModel& model, const MemTracePackedMemIns& memIns, uint32_t execMask,
+                              const uint8_t* payload, SlmAccessCost& cost);
+
+    template <typename Params>
+    static bool EvaluateModel(const SlmBankModel& model, const MemTracePackedMemIns& memIns, uint32_t execMask,
+                              const uint8_t* payload, SlmAccessCost& cost);
+
+    SlmBankConfig   _config;    ///< Parameters of the model
+    ConflictKernel  _kernel;    ///< Conflict degree kernel (Dword model)
+    EvaluateFn      _evaluate;  ///< Implementation of the model
+};
+
+#endif
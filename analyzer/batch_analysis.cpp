@@ -0,0 +1,261 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the batch analysis of a profile directory
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+#include <sys/stat.h>
+#if !defined(TARGET_WINDOWS)
+#include <dirent.h>
+#else
+#include <windows.h>
+#endif
+
+#include "batch_analysis.h"
+#include "trace_sampling.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// @return Path of the entry within the directory
+static string JoinPath(const string& dir, const string& name)
+{
+    return dir.empty() ? name : (dir + "/" + name);
+}
+
+/// @return true if the path names an existing directory
+static bool IsDirectory(const string& path)
+{
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0) && ((st.st_mode & S_IFMT) == S_IFDIR);
+}
+
+/// @return true if the file exists and can be read
+static bool IsReadableFile(const string& path)
+{
+    return !IsDirectory(path) && ifstream(path).good();
+}
+
+/*!
+ * List names of entries of the directory, except "." and "..", sorted by name
+ * @return false if the directory could not be read
+ */
+static bool ListDirectory(const string& dir, vector<string>& names)
+{
+    names.clear();
+#if !defined(TARGET_WINDOWS)
+    DIR* dirStream = opendir(dir.c_str());
+    if (dirStream == nullptr)
+    {
+        return false;
+    }
+    while (const dirent* entry = readdir(dirStream))
+    {
+        string name = entry->d_name;
+        if ((name != ".") && (name != "..")) { names.push_back(name); }
+    }
+    closedir(dirStream);
+#else
+    WIN32_FIND_DATAA data;
+    HANDLE           handle = FindFirstFileA((dir + "\\*").c_str(), &data);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    do
+    {
+        string name = data.cFileName;
+        if ((name != ".") && (name != "..")) { names.push_back(name); }
+    } while (FindNextFileA(handle, &data));
+    FindClose(handle);
+#endif
+    std::sort(names.begin(), names.end());
+    return true;
+}
+
+bool FindKernelTraces(const string& profileDir, vector<KernelTraceFiles>& kernels, string& error)
+{
+    // Kernel directories are stored in the session directory of the GTPin profile directory
+    string sessionDir = JoinPath(profileDir, "Session_Final");
+    string rootDir    = IsDirectory(sessionDir) ? sessionDir : profileDir;
+
+    kernels.clear();
+    vector<string> kernelNames;
+    if (!ListDirectory(rootDir, kernelNames))
+    {
+        error = rootDir + ": could not read the directory";
+        return false;
+    }
+    for (const string& kernelName : kernelNames)
+    {
+        string kernelDir = JoinPath(rootDir, kernelName);
+        if (!IsDirectory(kernelDir)) { continue; }
+
+        KernelTraceFiles kernel;
+        kernel.name = kernelName;
+        vector<string> dispatchNames;
+        if (!ListDirectory(kernelDir, dispatchNames))
+        {
+            error = kernelDir + ": could not read the directory";
+            return false;
+        }
+        for (const string& dispatchName : dispatchNames)
+        {
+            string traceFile = JoinPath(JoinPath(kernelDir, dispatchName), MEMTRACE_FILE_NAME);
+            if (IsReadableFile(traceFile)) { kernel.traceFiles.push_back(traceFile); }
+        }
+        if (kernel.traceFiles.empty()) { continue; } // The kernel has not been traced, or stored conflict profiles only
+
+        string samplingFile = JoinPath(kernelDir, MEMTRACE_SAMPLING_FILE_NAME);
+        if (IsReadableFile(samplingFile)) { kernel.samplingFile = samplingFile; }
+        kernels.push_back(std::move(kernel));
+    }
+    return true;
+}
+
+string KernelNameOfTraceFile(const string& tracePath)
+{
+    // Split off the file name, the dispatch directory and the kernel directory, which may start the path
+    string dir = tracePath;
+    string names[3];
+    for (uint32_t i = 0; i != 3; i++)
+    {
+        size_t sep = dir.find_last_of("/\\");
+        if ((sep == string::npos) && (i != 2)) { return string(); }
+        names[i] = (sep == string::npos) ? dir : dir.substr(sep + 1);
+        dir      = (sep == string::npos) ? string() : dir.substr(0, sep);
+        if (names[i].empty()) { return string(); }
+    }
+    bool isKernelDir = (names[0] == MEMTRACE_FILE_NAME) && (names[2] != ".") && (names[2] != "..");
+    return isKernelDir ? names[2] : string();
+}
+
+bool AnalyzeKernelTraces(const vector<KernelTraceFiles>& kernels, const string& modelName, uint32_t numBanks,
+                         const MemTraceThreadFilter& filter, TaskPool& pool, const AnalysisCache* cache,
+                         vector<SlmKernelCosts>& results, string& error)
+{
+    /// Analysis of a trace file, run by a task of the pool
+    struct FileAnalysis
+    {
+        const string*                           path;       ///< Trace file
+        unique_ptr<ConflictHistogramCollector>  collector;  ///< Results of the file
+        vector<MemTraceBblInfo>                 bbls;       ///< Memory instructions of BBLs of the file
+        string                                  error;      ///< Description of the error
+    };
+
+    vector<MemTraceSampling>    samplings(kernels.size());
+    vector<vector<FileAnalysis>> analyses(kernels.size());
+    for (uint32_t k = 0; k != kernels.size(); k++)
+    {
+        const KernelTraceFiles& kernel = kernels[k];
+        if (!kernel.samplingFile.empty() && !samplings[k].Load(kernel.samplingFile))
+        {
+            error = kernel.samplingFile + ": could not read sampling parameters";
+            return false;
+        }
+        analyses[k].resize(kernel.traceFiles.size());
+        for (uint32_t f = 0; f != kernel.traceFiles.size(); f++)
+        {
+            analyses[k][f].path = &kernel.traceFiles[f];
+        }
+    }
+
+    for (vector<FileAnalysis>& kernelAnalyses : analyses)
+    {
+        for (FileAnalysis& analysis : kernelAnalyses)
+        {
+            pool.Submit([&analysis, &modelName, numBanks, &filter, cache](uint32_t)
+            {
+                // Threads of the file are read by this task: tasks of the pool do not wait for other tasks
+                if (cache != nullptr)
+                {
+                    cache->Analyze(*analysis.path, modelName, numBanks, 0, filter, nullptr, analysis.collector,
+                                   analysis.bbls, analysis.error);
+                    return;
+                }
+
+                // The "auto" model depends on the GRF size, which is known once the trace file is open
+                MemTraceFileReader reader;
+                SlmBankConfig      bankConfig;
+                if (!reader.Open(*analysis.path))
+                {
+                    analysis.error = reader.Error();
+                    return;
+                }
+                if (!SlmBankConfig::FromName(modelName, reader.GrfSize(), bankConfig))
+                {
+                    analysis.error = "Unknown SLM bank model " + modelName;
+                    return;
+                }
+                if (numBanks != 0)
+                {
+                    bankConfig.numBanks = numBanks;
+                }
+                if (!bankConfig.IsValid())
+                {
+                    analysis.error = "Invalid number of SLM banks " + to_string(bankConfig.numBanks);
+                    return;
+                }
+                if (!filter.IsEmpty() && !reader.HasIndex())
+                {
+                    analysis.error = *analysis.path + ": the file has no thread index, which is required to select threads";
+                    return;
+                }
+                analysis.collector.reset(new ConflictHistogramCollector(bankConfig));
+                if (!(filter.IsEmpty() ? reader.Process(*analysis.collector) :
+                                         reader.ProcessThreads(*analysis.collector, reader.SelectThreads(filter))))
+                {
+                    analysis.error = reader.Error();
+                    return;
+                }
+                analysis.bbls = reader.Bbls();
+            });
+        }
+    }
+    pool.Wait();
+
+    // Merge results of dispatches of each kernel in the order of trace files
+    results.clear();
+    for (uint32_t k = 0; k != kernels.size(); k++)
+    {
+        unique_ptr<ConflictHistogramCollector> kernelCollector;
+        vector<MemTraceBblInfo>                bbls;
+        for (FileAnalysis& analysis : analyses[k])
+        {
+            if (!analysis.error.empty())
+            {
+                error = analysis.error;
+                return false;
+            }
+            if (bbls.empty()) { bbls = std::move(analysis.bbls); }
+            if (!kernelCollector)
+            {
+                kernelCollector = std::move(analysis.collector);
+                continue;
+            }
+            const SlmBankConfig& kernelConfig = kernelCollector->BankModel().Config();
+            const SlmBankConfig& fileConfig   = analysis.collector->BankModel().Config();
+            if ((kernelConfig.name != fileConfig.name) || (kernelConfig.numBanks != fileConfig.numBanks))
+            {
+                error = *analysis.path + ": the SLM bank model differs from other trace files of kernel " + kernels[k].name;
+                return false;
+            }
+            kernelCollector->Merge(*analysis.collector);
+            analysis.collector.reset();
+        }
+        results.emplace_back(kernels[k].name, *kernelCollector);
+        results.back().samplingScale = samplings[k].Scale();
+        results.back().AddInstructions(bbls);
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Batch analysis of a profile directory: traces of all kernels and dispatches stored by the Localmemorytrace
+ *       tool are discovered and analyzed by a shared task pool, producing a single ranking of SLM hotspots
+ */
+
+#ifndef BATCH_ANALYSIS_H_
+#define BATCH_ANALYSIS_H_
+
+#include <string>
+#include <vector>
+
+#include "analysis_cache.h"
+#include "hotspots.h"
+#include "task_pool.h"
+#include "trace_reader.h"
+
+/* ============================================================================================= */
+// Struct KernelTraceFiles
+/* ============================================================================================= */
+/*!
+ * Trace files of a kernel in the profile directory: <profile dir>/<kernel>/<dispatch>/memorytrace_compressed.bin
+ */
+struct KernelTraceFiles
+{
+    std::string                 name;           ///< Kernel name, as normalized in the name of the kernel directory
+    std::vector<std::string>    traceFiles;     ///< Trace files of dispatches, sorted by path
+    std::string                 samplingFile;   ///< Sampling parameters of the traces, or empty if not sampled
+};
+
+/*!
+ * Find trace files of all kernels in the profile directory. The directory is either the one the tool writes
+ * kernel directories to, or the GTPIN_PROFILE_* directory that contains it in Session_Final
+ * @param[in]  profileDir  Profile directory
+ * @param[out] kernels     Kernels with at least one trace file, sorted by name
+ * @param[out] error       Description of the error
+ * @return false if the directory could not be read
+ */
+bool FindKernelTraces(const std::string& profileDir, std::vector<KernelTraceFiles>& kernels, std::string& error);
+
+/*!
+ * @return Name of the kernel directory of the trace file stored by the tool (<kernel>/<dispatch>/memorytrace_compressed.bin),
+ *         the same name FindKernelTraces() reports, or an empty string if the file is not in a kernel directory
+ */
+std::string KernelNameOfTraceFile(const std::string& tracePath);
+
+/*!
+ * Analyze trace files of the specified kernels. Each trace file is analyzed by a task of the pool, and results
+ * of dispatches are merged per kernel in the order of trace files, so they do not depend on the number of workers
+ * @param[in]  kernels    Kernels and their trace files
+ * @param[in]  modelName  SLM bank model (see SlmBankConfig::FromName). The "auto" model is selected by the GRF
+ *                        size of each trace file
+ * @param[in]  numBanks   Number of SLM banks, 0 - banks of the bank model
+ * @param[in]  filter     Threads to be analyzed. Selecting threads requires the thread index in all files
+ * @param[in]  pool       Pool of workers shared by all kernels
+ * @param[in]  cache      Cache of analyses of trace files, or nullptr
+ * @param[out] results    Bank cycles of instructions of each kernel, scaled by its sampling parameters
+ * @param[out] error      Description of the first error
+ * @return false if any trace file could not be analyzed
+ */
+bool AnalyzeKernelTraces(const std::vector<KernelTraceFiles>& kernels, const std::string& modelName, uint32_t numBanks,
+                         const MemTraceThreadFilter& filter, TaskPool& pool, const AnalysisCache* cache,
+                         std::vector<SlmKernelCosts>& results, std::string& error);
+
+#endif
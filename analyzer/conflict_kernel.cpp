@@ -0,0 +1,285 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the conflict degree kernel
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "bank_conflicts.h"
+#include "conflict_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CONFLICT_KERNEL_X86
+#define CONFLICT_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define CONFLICT_KERNEL_X86
+#define CONFLICT_KERNEL_TARGET(isa)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// @return Index of the lowest set bit of the non-zero mask
+static inline uint32_t LowestLane(uint32_t mask)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (uint32_t)index;
+#else
+    uint32_t index = 0;
+    for (; (mask & 1) == 0; mask >>= 1) { index++; }
+    return index;
+#endif
+}
+
+/// Portable implementation for any number of banks
+static uint32_t DegreeGeneric(const uint32_t* addrs, uint32_t laneMask, uint32_t numBanks)
+{
+    uint32_t enabledAddrs[MAX_SIMD_LANES];
+    uint32_t numAddrs = 0;
+    for (; laneMask != 0; laneMask &= laneMask - 1)
+    {
+        enabledAddrs[numAddrs++] = addrs[LowestLane(laneMask)];
+    }
+    if ((numAddrs == 0) || IsBroadcast(enabledAddrs, numAddrs))
+    {
+        return CONFLICT_DEGREE_SKIPPED;
+    }
+    return ConflictDegree(enabledAddrs, numAddrs, numBanks);
+}
+
+/// Portable implementation for a power-of-two number of banks: a histogram of bank IDs
+template <uint32_t NumBanks>
+static uint32_t DegreeScalar(const uint32_t* addrs, uint32_t laneMask, uint32_t)
+{
+    if (laneMask == 0) { return CONFLICT_DEGREE_SKIPPED; }
+
+    uint8_t  bankCounts[NumBanks] = {};
+    uint32_t firstAddr   = addrs[LowestLane(laneMask)];
+    bool     isBroadcast = true;
+    uint32_t degree      = 0;
+    for (; laneMask != 0; laneMask &= laneMask - 1)
+    {
+        uint32_t addr = addrs[LowestLane(laneMask)];
+        isBroadcast = isBroadcast && (addr == firstAddr);
+        degree      = std::max(degree, (uint32_t)++bankCounts[(addr >> 2) & (NumBanks - 1)]);
+    }
+    if (isBroadcast) { return CONFLICT_DEGREE_SKIPPED; }
+    return (degree > 1) ? degree : 0;
+}
+
+#if defined(CONFLICT_KERNEL_X86)
+/*!
+ * Max number of enabled channels with the same bank ID. Bank IDs of channels are bytes of bankIds, in the order
+ * of channels. For small bank counts, channels of each bank are counted independently of other banks.
+ * Otherwise, each iteration counts the channels of the bank of the lowest remaining channel, so the number
+ * of iterations is the number of distinct banks
+ */
+template <uint32_t NumBanks>
+CONFLICT_KERNEL_TARGET("avx2,popcnt")
+static inline uint32_t MaxBankMultiplicityAvx2(__m256i bankIds, uint32_t laneMask)
+{
+    uint32_t degree = 0;
+    if (NumBanks <= 64)
+    {
+        __m256i bank = _mm256_setzero_si256();
+        __m256i one  = _mm256_set1_epi8(1);
+        for (uint32_t b = 0; b != NumBanks; b++, bank = _mm256_add_epi8(bank, one))
+        {
+            uint32_t bankLanes = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bankIds, bank)) & laneMask;
+            degree = std::max(degree, (uint32_t)_mm_popcnt_u32(bankLanes));
+        }
+        return degree;
+    }
+
+    alignas(32) uint8_t ids[MAX_SIMD_LANES];
+    _mm256_store_si256((__m256i*)ids, bankIds);
+    for (uint32_t remaining = laneMask; remaining != 0;)
+    {
+        __m256i  bank      = _mm256_set1_epi8((char)ids[LowestLane(remaining)]);
+        uint32_t bankLanes = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bankIds, bank)) & laneMask;
+        degree     = std::max(degree, (uint32_t)_mm_popcnt_u32(bankLanes));
+        remaining &= ~bankLanes;
+    }
+    return degree;
+}
+
+/// AVX2 implementation for a power-of-two number of banks
+template <uint32_t NumBanks>
+CONFLICT_KERNEL_TARGET("avx2,popcnt")
+static uint32_t DegreeAvx2(const uint32_t* addrs, uint32_t laneMask, uint32_t)
+{
+    if (laneMask == 0) { return CONFLICT_DEGREE_SKIPPED; }
+
+    __m256i  firstAddr = _mm256_set1_epi32((int)addrs[LowestLane(laneMask)]);
+    __m256i  bankMask  = _mm256_set1_epi32((int)(NumBanks - 1));
+    __m256i  banks[4];
+    uint32_t sameAddrMask = 0;
+    for (uint32_t i = 0; i != 4; i++)
+    {
+        __m256i addr = _mm256_loadu_si256((const __m256i*)(addrs + 8 * i));
+        sameAddrMask |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(addr, firstAddr))) << (8 * i);
+        banks[i] = _mm256_and_si256(_mm256_srli_epi32(addr, 2), bankMask);
+    }
+    if ((sameAddrMask & laneMask) == laneMask) { return CONFLICT_DEGREE_SKIPPED; }
+
+    // Pack bank IDs into bytes. Packing interleaves 128-bit halves, so groups of 4 channels are permuted back
+    __m256i banks16 = _mm256_packus_epi16(_mm256_packus_epi32(banks[0], banks[1]), _mm256_packus_epi32(banks[2], banks[3]));
+    __m256i bankIds = _mm256_permutevar8x32_epi32(banks16, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+
+    uint32_t degree = MaxBankMultiplicityAvx2<NumBanks>(bankIds, laneMask);
+    return (degree > 1) ? degree : 0;
+}
+
+/// AVX-512 implementation for a power-of-two number of banks
+template <uint32_t NumBanks>
+CONFLICT_KERNEL_TARGET("avx512f,avx512bw,avx512vl,avx2,popcnt")
+static uint32_t DegreeAvx512(const uint32_t* addrs, uint32_t laneMask, uint32_t)
+{
+    if (laneMask == 0) { return CONFLICT_DEGREE_SKIPPED; }
+
+    __m512i  firstAddr = _mm512_set1_epi32((int)addrs[LowestLane(laneMask)]);
+    __m512i  bankMask  = _mm512_set1_epi32((int)(NumBanks - 1));
+    __m512i  addrLo    = _mm512_loadu_si512((const void*)addrs);
+    __m512i  addrHi    = _mm512_loadu_si512((const void*)(addrs + 16));
+    uint32_t sameAddrMask = (uint32_t)_mm512_cmpeq_epi32_mask(addrLo, firstAddr) |
+                            ((uint32_t)_mm512_cmpeq_epi32_mask(addrHi, firstAddr) << 16);
+    if ((sameAddrMask & laneMask) == laneMask) { return CONFLICT_DEGREE_SKIPPED; }
+
+    // Convert bank IDs to bytes, in the order of channels. Zero-masking forms of the instructions avoid
+    // undefined source operands, which GCC reports as uninitialized variables
+    __m128i idsLo   = _mm512_maskz_cvtepi32_epi8(0xFFFF, _mm512_and_si512(_mm512_maskz_srli_epi32(0xFFFF, addrLo, 2), bankMask));
+    __m128i idsHi   = _mm512_maskz_cvtepi32_epi8(0xFFFF, _mm512_and_si512(_mm512_maskz_srli_epi32(0xFFFF, addrHi, 2), bankMask));
+    __m256i bankIds = _mm256_inserti128_si256(_mm256_castsi128_si256(idsLo), idsHi, 1);
+
+    uint32_t degree = MaxBankMultiplicityAvx2<NumBanks>(bankIds, laneMask);
+    return (degree > 1) ? degree : 0;
+}
+#endif
+
+/* ============================================================================================= */
+// ConflictKernel implementation
+/* ============================================================================================= */
+/// Select the implementation of the instruction set for the specified power-of-two number of banks
+template <uint32_t NumBanks>
+static uint32_t (*SelectDegreeFn(ConflictKernel::Isa isa))(const uint32_t*, uint32_t, uint32_t)
+{
+    static_assert((NumBanks & (NumBanks - 1)) == 0, "The number of banks must be a power of two");
+    switch (isa)
+    {
+#if defined(CONFLICT_KERNEL_X86)
+    case ConflictKernel::Isa::AVX512:   return DegreeAvx512<NumBanks>;
+    case ConflictKernel::Isa::AVX2:     return DegreeAvx2<NumBanks>;
+#endif
+    default:                            return DegreeScalar<NumBanks>;
+    }
+}
+
+ConflictKernel::ConflictKernel(uint32_t numBanks, Isa isa) : _numBanks(numBanks)
+{
+    Isa cpuIsa = DetectIsa();
+    _isa = ((isa == Isa::BEST) || (isa > cpuIsa)) ? cpuIsa : isa;
+
+    switch (numBanks)
+    {
+    case 1:     _degree = SelectDegreeFn<1>(_isa);      break;
+    case 2:     _degree = SelectDegreeFn<2>(_isa);      break;
+    case 4:     _degree = SelectDegreeFn<4>(_isa);      break;
+    case 8:     _degree = SelectDegreeFn<8>(_isa);      break;
+    case 16:    _degree = SelectDegreeFn<16>(_isa);     break;
+    case 32:    _degree = SelectDegreeFn<32>(_isa);     break;
+    case 64:    _degree = SelectDegreeFn<64>(_isa);     break;
+    case 128:   _degree = SelectDegreeFn<128>(_isa);    break;
+    case 256:   _degree = SelectDegreeFn<256>(_isa);    break;
+    default:
+        _degree = DegreeGeneric;
+        _isa    = Isa::SCALAR;
+        break;
+    }
+}
+
+uint32_t ConflictKernel::Degree(const MemTracePackedMemIns& memIns, uint32_t execMask, const uint8_t* payload) const
+{
+    uint32_t laneMask = MemTraceLaneMask(memIns, execMask);
+    if (laneMask == 0) { return CONFLICT_DEGREE_SKIPPED; }
+
+    // Copy addresses of channels up to the last enabled one. SLM offsets are 32-bit, so the low dword
+    // of a 64-bit address is sufficient
+    uint32_t addrs[MAX_SIMD_LANES];
+    uint32_t numLanes = 0;
+    for (uint32_t mask = laneMask; mask != 0; mask >>= 1) { numLanes++; }
+    uint32_t addrSize = MemTraceAddrSize(memIns);
+    if (addrSize == sizeof(uint32_t))
+    {
+        memcpy(addrs, payload, numLanes * sizeof(uint32_t));
+    }
+    else
+    {
+        for (uint32_t lane = 0; lane != numLanes; lane++)
+        {
+            memcpy(&addrs[lane], payload + lane * addrSize, sizeof(uint32_t));
+        }
+    }
+    memset(addrs + numLanes, 0, (MAX_SIMD_LANES - numLanes) * sizeof(uint32_t));
+    return _degree(addrs, laneMask, _numBanks);
+}
+
+ConflictKernel::Isa ConflictKernel::DetectIsa()
+{
+#if defined(CONFLICT_KERNEL_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("popcnt"))
+    {
+        return Isa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    {
+        return Isa::AVX2;
+    }
+#elif defined(CONFLICT_KERNEL_X86)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool hasPopcnt = ((info[2] & (1 << 23)) != 0);
+    bool hasOsSave = ((info[2] & (1 << 27)) != 0);
+    if ((maxLeaf >= 7) && hasOsSave && hasPopcnt)
+    {
+        uint64_t xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        uint32_t features = (uint32_t)info[1];
+        bool hasAvx2   = ((features & (1u << 5)) != 0) && ((xcr0 & 0x6) == 0x6);
+        bool hasAvx512 = ((features & (1u << 16)) != 0) && ((features & (1u << 30)) != 0) && ((features & (1u << 31)) != 0) &&
+                         ((xcr0 & 0xE6) == 0xE6);
+        if (hasAvx512) { return Isa::AVX512; }
+        if (hasAvx2)   { return Isa::AVX2; }
+    }
+#endif
+    return Isa::SCALAR;
+}
+
+const char* ConflictKernel::IsaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::AVX512:   return "avx512";
+    case Isa::AVX2:     return "avx2";
+    case Isa::SCALAR:   return "scalar";
+    default:            return "best";
+    }
+}
@@ -0,0 +1,86 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Conflict degree kernel: computes SLM bank IDs of all channels of a SEND payload and the max number
+ *       of enabled channels that access the same bank. The kernel has scalar, AVX2 and AVX-512 implementations,
+ *       selected at run time, specialized for power-of-two bank counts
+ */
+
+#ifndef CONFLICT_KERNEL_H_
+#define CONFLICT_KERNEL_H_
+
+#include <cstdint>
+
+#include "memtrace_format.h"
+
+/// Max number of channels (SIMD lanes) in a SEND instruction
+static const uint32_t MAX_SIMD_LANES = 32;
+
+/// Result of the conflict kernel for accesses that are not analyzed: no enabled channels, or a broadcast
+static const uint32_t CONFLICT_DEGREE_SKIPPED = UINT32_MAX;
+
+/* ============================================================================================= */
+// Class ConflictKernel
+/* ============================================================================================= */
+/*!
+ * Conflict degree of SLM accesses: the max number of enabled channels that access the same bank, where
+ * the bank of an address is (address / 4) % numBanks, or 0 if all channels access different banks.
+ * Accesses where all enabled channels access the same address (broadcasts) are skipped.
+ * The results are identical to IsBroadcast() and ConflictDegree() applied to addresses of enabled channels
+ */
+class ConflictKernel
+{
+public:
+    /// Instruction set of the implementation
+    enum class Isa
+    {
+        SCALAR,     ///< Portable implementation
+        AVX2,       ///< AVX2
+        AVX512,     ///< AVX-512 F, BW and VL
+        BEST        ///< The best implementation supported by the CPU
+    };
+
+    /*!
+     * @param numBanks  Number of SLM banks. Power-of-two bank counts up to 256 use specialized implementations,
+     *                  other bank counts use the portable implementation
+     * @param isa       Max instruction set of the implementation. Downgraded if not supported by the CPU
+     */
+    explicit ConflictKernel(uint32_t numBanks, Isa isa = Isa::BEST);
+
+    /*!
+     * @param addrs     Addresses of MAX_SIMD_LANES channels
+     * @param laneMask  Mask of enabled channels
+     * @return Conflict degree, or CONFLICT_DEGREE_SKIPPED
+     */
+    uint32_t operator()(const uint32_t* addrs, uint32_t laneMask) const { return _degree(addrs, laneMask, _numBanks); }
+
+    /*!
+     * @param memIns    Descriptor of the memory instruction
+     * @param execMask  Dynamic execution mask of the record (ce & dm)
+     * @param payload   Address payload of the instruction
+     * @return Conflict degree of channels analyzed by MemTraceLaneMask, or CONFLICT_DEGREE_SKIPPED
+     */
+    uint32_t Degree(const MemTracePackedMemIns& memIns, uint32_t execMask, const uint8_t* payload) const;
+
+    Isa         GetIsa()    const { return _isa; }      ///< Selected instruction set
+    uint32_t    NumBanks()  const { return _numBanks; }
+
+    /// @return The best instruction set supported by the CPU
+    static Isa DetectIsa();
+
+    /// @return Name of the instruction set
+    static const char* IsaName(Isa isa);
+
+private:
+    using DegreeFn = uint32_t (*)(const uint32_t* addrs, uint32_t laneMask, uint32_t numBanks);
+
+    DegreeFn    _degree;    ///< Implementation of the kernel
+    uint32_t    _numBanks;  ///< Number of SLM banks
+    Isa         _isa;       ///< Instruction set of the implementation
+};
+
+#endif
@@ -0,0 +1,575 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the processing of raw dispatch traces
+ */
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <fstream>
+
+#include "dispatch_trace.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// MemTraceKernelLayout implementation
+/* ============================================================================================= */
+void MemTraceKernelLayout::AddMemIns(uint32_t bblId, const MemTracePackedMemIns& memIns)
+{
+    if (bblId >= bblInfos.size())
+    {
+        bblInfos.resize(bblId + 1);
+        recordSizes.resize(bblId + 1, 0);
+    }
+    MemTraceBblInfo& bblInfo = bblInfos[bblId];
+    bblInfo.bblId = bblId;
+    bblInfo.memInstructions.push_back(memIns);
+    bblInfo.payloadOffsets.push_back(bblInfo.payloadSize);
+    bblInfo.payloadSize += memIns.addrPayloadLength * grfSize;
+    recordSizes[bblId] = AlignedHeaderSize() + bblInfo.payloadSize;
+}
+
+uint32_t MemTraceKernelLayout::NumMemBbls() const
+{
+    uint32_t numBbls = 0;
+    for (const MemTraceBblInfo& bblInfo : bblInfos)
+    {
+        if (!bblInfo.memInstructions.empty()) { ++numBbls; }
+    }
+    return numBbls;
+}
+
+/// @return Number of addresses of the record in the address column of the version 3 trace file
+static uint64_t NumColumnAddresses(const MemTraceBblInfo& bblInfo, uint32_t execMask, uint32_t grfSize)
+{
+    uint64_t numAddresses = 0;
+    for (const MemTracePackedMemIns& memIns : bblInfo.memInstructions)
+    {
+        numAddresses += bitset<32>(MemTraceColumnLaneMask(memIns, execMask, grfSize)).count();
+    }
+    return numAddresses;
+}
+
+/* ============================================================================================= */
+// MemTraceSerializer implementation
+/* ============================================================================================= */
+uint32_t MemTraceSerializer::BucketByThread(const MemTraceRawSegments& segments, Scratch& scratch) const
+{
+    // Associate trace records with threads - populate scratch using the counting sort.
+    // The first pass counts records of each thread, the second pass places record references to their positions
+    const vector<uint32_t>& sr0Tids     = _layout.sr0Tids;
+    uint32_t                maxThreads  = _layout.NumThreads();
+    vector<uint64_t>&       threadBegin = scratch.threadBegin;
+    vector<TraceRecord>&    records     = scratch.records;
+    threadBegin.assign(maxThreads + 1, 0);
+
+    // Count records of each thread. threadBegin[tid + 1] = number of records in thread tid
+    uint64_t numRecords = 0;
+    ForEachRawRecord(_layout, segments, [&](const MemTraceRecordHeader* header, uint32_t)
+    {
+        ++threadBegin[sr0Tids[header->sr0] + 1];
+        ++numRecords;
+    });
+
+    // Compute positions of the first records of threads (prefix sum)
+    uint32_t numProfiledThreads = 0; // Number of profiled (active) threads
+    for (uint32_t tid = 0; tid < maxThreads; tid++)
+    {
+        if (threadBegin[tid + 1] != 0) { ++numProfiledThreads; }
+        threadBegin[tid + 1] += threadBegin[tid];
+    }
+
+    // Scatter record references. Use threadBegin[tid] as the insertion point of thread tid, which shifts
+    // threadBegin by one thread: when done, threadBegin[tid] is the end of thread tid
+    if (records.size() < numRecords) { records.resize(numRecords); }
+    ForEachRawRecord(_layout, segments, [&](const MemTraceRecordHeader* header, uint32_t recordSize)
+    {
+        uint32_t tid = sr0Tids[header->sr0];
+        records[threadBegin[tid]++] = TraceRecord{header, recordSize};
+    });
+    return numProfiledThreads;
+}
+
+uint32_t MemTraceSerializer::SegmentRecords(const TraceRecord* records, uint64_t numRecords, uint32_t maxRecordSize)
+{
+    uint64_t maxRecords = std::min<uint64_t>(numRecords, UINT32_MAX);
+    if (maxRecords * maxRecordSize <= MAX_SEGMENT_SIZE)
+    {
+        return (uint32_t)maxRecords; // All records fit regardless of their BBLs
+    }
+    uint64_t segmentSize = 0;
+    uint32_t r = 0;
+    for (; r != maxRecords; r++)
+    {
+        segmentSize += records[r].size;
+        if ((segmentSize > MAX_SEGMENT_SIZE) && (r != 0)) { break; }
+    }
+    return r;
+}
+
+void MemTraceSerializer::Store(const MemTraceRawSegments& segments, Scratch& scratch, TraceFileWriter& fs) const
+{
+    BucketByThread(segments, scratch);
+    StoreBuckets(scratch, fs);
+}
+
+void MemTraceSerializer::StoreBuckets(Scratch& scratch, TraceFileWriter& fs) const
+{
+    uint32_t alignedHeaderSize = _layout.AlignedHeaderSize();
+    const vector<uint64_t>&    threadBegin = scratch.threadBegin;
+    const vector<TraceRecord>& records     = scratch.records;
+    vector<uint64_t>&          segmentEnds = scratch.segmentEnds;
+
+    // Split traces of threads into segments. Each segment is stored as a separate thread trace
+    uint32_t maxRecordSize = 0;
+    for (uint32_t recordSize : _layout.recordSizes) { maxRecordSize = std::max(maxRecordSize, recordSize); }
+    segmentEnds.clear();
+    for (uint32_t tid = 0; tid < _layout.NumThreads(); tid++)
+    {
+        for (uint64_t recordIndex = (tid == 0) ? 0 : threadBegin[tid - 1]; recordIndex != threadBegin[tid];)
+        {
+            recordIndex += SegmentRecords(records.data() + recordIndex, threadBegin[tid] - recordIndex, maxRecordSize);
+            segmentEnds.push_back(recordIndex);
+        }
+    }
+    uint32_t numProfiledThreads = (uint32_t)segmentEnds.size();
+
+    if (_version == 3)
+    {
+        StoreColumns(scratch, fs);
+        return;
+    }
+    if (_version == 2)
+    {
+        Store(MEMTRACE_V2_SIGNATURE, fs);       // Store the header of the version 2 format
+        Store(_layout.grfSize, fs);
+    }
+    uint64_t staticInfoOffset = fs.BytesWritten();
+    StoreBblInfos(_layout, fs);     // Store static information about memory accesses in the kernel
+    Store(numProfiledThreads, fs);  // Store the number of profiled threads (thread segments)
+    scratch.threadIndex.clear();
+
+    // Store per-thread traces
+    uint64_t recordIndex = 0;
+    auto     segmentEnd  = segmentEnds.begin();
+    for (uint32_t tid = 0; tid < _layout.NumThreads(); tid++)
+    {
+        for (; recordIndex != threadBegin[tid]; ++segmentEnd)
+        {
+            uint32_t numThreadRecords = uint32_t(*segmentEnd - recordIndex);
+            if (_storeIndex)
+            {
+                MemTraceThreadIndexEntry entry{_layout.threads[tid], numThreadRecords, fs.BytesWritten()};
+                scratch.threadIndex.push_back(entry);
+            }
+
+            Store(_layout.threads[tid], fs);    // Store Global Thread Identifier
+            Store(numThreadRecords, fs);        // Store #records collected in the thread
+
+            if (_version == 2)
+            {
+                StoreEncodedRecords(records.data() + recordIndex, numThreadRecords, scratch.encoder, fs);
+                recordIndex = *segmentEnd;
+                continue;
+            }
+
+            // Store trace records
+            for (; recordIndex != *segmentEnd; ++recordIndex)
+            {
+                const TraceRecord& record   = records[recordIndex];
+                const auto&        header   = *(record.header);
+                uint32_t           bblId    = header.bblId;
+                uint32_t           execMask = header.ce & header.dm;
+
+                Store(bblId, fs);       // Store BBL ID
+                Store(execMask, fs);    // Store dynamic execution mask
+
+                // Store address paylads
+                if (record.size > alignedHeaderSize)
+                {
+                    fs.WriteRef((const uint8_t*)(record.header) + alignedHeaderSize, record.size - alignedHeaderSize);
+                }
+            }
+        }
+    }
+
+    if (_storeIndex)
+    {
+        StoreThreadIndex(scratch.threadIndex, staticInfoOffset, fs);
+    }
+}
+
+void MemTraceSerializer::StoreEncodedRecords(const TraceRecord* records, uint32_t numRecords, MemTraceEncoder& encoder,
+                                             TraceFileWriter& fs) const
+{
+    uint32_t alignedHeaderSize = _layout.AlignedHeaderSize();
+
+    encoder.BeginThread();
+    for (uint32_t i = 0; i != numRecords; i++)
+    {
+        const MemTraceRecordHeader* header = records[i].header;
+        encoder.AddRecord(MemTraceRecord{&_layout.bblInfos[header->bblId], uint32_t(header->ce & header->dm),
+                                         (const uint8_t*)header + alignedHeaderSize});
+    }
+    const vector<uint8_t>& encoded = encoder.EndThread();
+
+    uint32_t encodedSize = (uint32_t)encoded.size();
+    Store(encodedSize, fs);                             // Store the size of encoded records
+    fs.Write(encoded.data(), encoded.size());           // Store encoded records
+}
+
+void MemTraceSerializer::StoreColumns(const Scratch& scratch, TraceFileWriter& fs) const
+{
+    uint32_t alignedHeaderSize = _layout.AlignedHeaderSize();
+    const vector<uint64_t>&    threadBegin = scratch.threadBegin;
+    const vector<TraceRecord>& records     = scratch.records;
+    const vector<uint64_t>&    segmentEnds = scratch.segmentEnds;
+    uint64_t                   numRecords  = segmentEnds.empty() ? 0 : segmentEnds.back();
+
+    Store(MEMTRACE_V3_SIGNATURE, fs);                   // Store the header of the version 3 format
+    Store(_layout.grfSize, fs);
+    StoreBblInfos(_layout, fs);                         // Store static information about memory accesses in the kernel
+    Store((uint32_t)segmentEnds.size(), fs);            // Store the number of profiled threads (thread segments)
+
+    // Store the thread table: records of each thread segment in columns
+    uint64_t recordIndex = 0;
+    auto     segmentEnd  = segmentEnds.begin();
+    for (uint32_t tid = 0; tid < _layout.NumThreads(); tid++)
+    {
+        for (; recordIndex != threadBegin[tid]; recordIndex = *(segmentEnd++))
+        {
+            Store(MemTraceThreadIndexEntry{_layout.threads[tid], uint32_t(*segmentEnd - recordIndex), recordIndex}, fs);
+        }
+    }
+    uint64_t headerOffset = StorePadding(fs);
+
+    // Count addresses of analyzed channels to lay out the columns, and locate the first address of each segment
+    vector<uint64_t> segmentAddrs(segmentEnds.size());
+    uint64_t         numAddresses = 0;
+    for (uint64_t s = 0, r = 0; s != segmentEnds.size(); s++)
+    {
+        segmentAddrs[s] = numAddresses;
+        for (; r != segmentEnds[s]; r++)
+        {
+            const MemTraceRecordHeader& header = *(records[r].header);
+            numAddresses += NumColumnAddresses(_layout.bblInfos[header.bblId], header.ce & header.dm, _layout.grfSize);
+        }
+    }
+    auto alignedEnd = [](uint64_t offset, uint64_t size)
+    {
+        return (offset + size + MEMTRACE_COLUMN_ALIGNMENT - 1) / MEMTRACE_COLUMN_ALIGNMENT * MEMTRACE_COLUMN_ALIGNMENT;
+    };
+    MemTraceColumnsHeader columns;
+    columns.numRecords        = numRecords;
+    columns.numAddresses      = numAddresses;
+    columns.bblIdsOffset      = alignedEnd(headerOffset, sizeof(MemTraceColumnsHeader));
+    columns.execMasksOffset   = alignedEnd(columns.bblIdsOffset, numRecords * sizeof(uint16_t));
+    columns.threadAddrsOffset = alignedEnd(columns.execMasksOffset, numRecords * sizeof(uint32_t));
+    columns.addressesOffset   = alignedEnd(columns.threadAddrsOffset, segmentAddrs.size() * sizeof(uint64_t));
+    Store(columns, fs);
+
+    // Store the columns
+    StorePadding(fs);
+    for (uint64_t r = 0; r != numRecords; r++)
+    {
+        Store(records[r].header->bblId, fs);
+    }
+    StorePadding(fs);
+    for (uint64_t r = 0; r != numRecords; r++)
+    {
+        uint32_t execMask = records[r].header->ce & records[r].header->dm;
+        Store(execMask, fs);
+    }
+    StorePadding(fs);
+    fs.Write(segmentAddrs.data(), segmentAddrs.size() * sizeof(uint64_t));
+    StorePadding(fs);
+    for (uint64_t r = 0; r != numRecords; r++)
+    {
+        const MemTraceRecordHeader& header  = *(records[r].header);
+        const MemTraceBblInfo&      bblInfo = _layout.bblInfos[header.bblId];
+        const uint8_t*              payload = (const uint8_t*)(records[r].header) + alignedHeaderSize;
+        for (uint32_t i = 0; i != bblInfo.memInstructions.size(); i++)
+        {
+            const MemTracePackedMemIns& memIns   = bblInfo.memInstructions[i];
+            const uint8_t*              insAddrs = payload + bblInfo.payloadOffsets[i];
+            uint32_t                    addrSize = MemTraceAddrSize(memIns);
+            uint32_t laneMask = MemTraceColumnLaneMask(memIns, header.ce & header.dm, _layout.grfSize);
+            for (uint32_t lane = 0; laneMask != 0; lane++, laneMask >>= 1)
+            {
+                if ((laneMask & 1) == 0) { continue; }
+                uint32_t addr = 0;
+                memcpy(&addr, insAddrs + lane * addrSize, sizeof(addr));     // Low dword of the little-endian address
+                Store(addr, fs);
+            }
+        }
+    }
+}
+
+uint64_t MemTraceSerializer::StorePadding(TraceFileWriter& fs)
+{
+    static const uint8_t zeros[MEMTRACE_COLUMN_ALIGNMENT] = {};
+    uint64_t paddingSize = (MEMTRACE_COLUMN_ALIGNMENT - fs.BytesWritten() % MEMTRACE_COLUMN_ALIGNMENT) % MEMTRACE_COLUMN_ALIGNMENT;
+    fs.Write(zeros, paddingSize);
+    return fs.BytesWritten();
+}
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+void StoreBblInfos(const MemTraceKernelLayout& layout, TraceFileWriter& fs)
+{
+    uint32_t numBbls = layout.NumMemBbls();
+    fs.Store(numBbls);                                  // Store the number of BBLs that access memory
+
+    for (const MemTraceBblInfo& bblInfo : layout.bblInfos)
+    {
+        uint32_t numMemInstructions = (uint32_t)bblInfo.memInstructions.size();
+        if (numMemInstructions == 0) { continue; }
+
+        fs.Store(bblInfo.bblId);                        // Store BBL ID
+        fs.Store(numMemInstructions);                   // Store the number of memory instructions in BBL
+        for (const MemTracePackedMemIns& memIns : bblInfo.memInstructions)
+        {
+            fs.Store(memIns);                           // Store the memory instruction descriptor
+        }
+    }
+}
+
+void StoreThreadIndex(const vector<MemTraceThreadIndexEntry>& threadIndex, uint64_t staticInfoOffset, TraceFileWriter& fs)
+{
+    MemTraceIndexTrailer trailer;
+    trailer.staticInfoOffset = staticInfoOffset;
+    trailer.indexOffset      = fs.BytesWritten();
+    trailer.numThreads       = (uint32_t)threadIndex.size();
+    trailer.signature        = MEMTRACE_INDEX_SIGNATURE;
+
+    fs.Write(threadIndex.data(), threadIndex.size() * sizeof(MemTraceThreadIndexEntry));   // Store the thread index
+    fs.Store(trailer);                                                                      // Store the index trailer
+}
+
+uint64_t CompleteRawRecordsSize(const MemTraceKernelLayout& layout, const uint8_t* trace, uint64_t traceSize, bool& isEnd)
+{
+    uint64_t size = 0;
+    ForEachRawRecord(layout, trace, traceSize, [&](const MemTraceRecordHeader*, uint32_t recordSize) { size += recordSize; });
+
+    const MemTraceRecordHeader* header = (const MemTraceRecordHeader*)(trace + size);
+    isEnd = (size + sizeof(MemTraceRecordHeader) <= traceSize) && (layout.RecordSize(header->bblId) == 0);
+    return size;
+}
+
+void StoreRawDispatch(const MemTraceKernelLayout& layout, const MemTraceRawSegments& segments, bool isTrimmed,
+                      TraceFileWriter& fs)
+{
+    uint32_t numThreads  = layout.NumThreads();
+    uint32_t trimmed     = (isTrimmed ? 1 : 0);
+    uint32_t numSegments = (uint32_t)segments.size();
+
+    fs.Store(MEMTRACE_RAW_SEGMENTED_SIGNATURE);
+    fs.Store(layout.grfSize);
+    StoreBblInfos(layout, fs);
+    fs.Store(numThreads);
+    fs.Write(layout.threads.data(), numThreads * sizeof(MemTraceGlobalTid));
+    fs.Write(layout.sr0Tids.data(), layout.sr0Tids.size() * sizeof(uint32_t));
+    fs.Store(trimmed);
+    fs.Store(numSegments);
+    for (const MemTraceRawSegment& segment : segments)
+    {
+        fs.Store(segment.size);
+        fs.WriteRef(segment.data, segment.size);
+    }
+}
+
+/* ============================================================================================= */
+// MemTraceRawDispatch implementation
+/* ============================================================================================= */
+bool MemTraceRawDispatch::Load(const string& path, string& error)
+{
+    auto fail = [&](const string& msg) { error = path + ": " + msg; return false; };
+
+    ifstream fs(path, ios::binary);
+    if (!fs)
+    {
+        return fail("could not open file");
+    }
+    fs.seekg(0, ios::end);
+    uint64_t fileSize = (uint64_t)fs.tellg();
+    fs.seekg(0, ios::beg);
+    auto load = [&](void* data, size_t size) { return (bool)fs.read((char*)data, size); };
+
+    uint32_t signature = 0;
+    uint32_t numBbls   = 0;
+    layout = MemTraceKernelLayout();
+    if (!load(&signature, sizeof(signature)) ||
+        ((signature != MEMTRACE_RAW_SEGMENTED_SIGNATURE) && (signature != MEMTRACE_RAW_SIGNATURE)))
+    {
+        return fail("not a raw dispatch capture file");
+    }
+    if (!load(&layout.grfSize, sizeof(layout.grfSize)) || (layout.grfSize == 0) || !load(&numBbls, sizeof(numBbls)))
+    {
+        return fail("could not read the file header");
+    }
+
+    // Read static information about memory accesses in BBLs. BBL IDs of raw records are 16-bit
+    for (uint32_t i = 0; i != numBbls; i++)
+    {
+        uint32_t bblId              = 0;
+        uint32_t numMemInstructions = 0;
+        if (!load(&bblId, sizeof(bblId)) || !load(&numMemInstructions, sizeof(numMemInstructions)) ||
+            (bblId > UINT16_MAX) || (numMemInstructions * sizeof(MemTracePackedMemIns) > fileSize))
+        {
+            return fail("could not read BBL information");
+        }
+        for (uint32_t j = 0; j != numMemInstructions; j++)
+        {
+            MemTracePackedMemIns memIns;
+            if (!load(&memIns, sizeof(memIns))) { return fail("could not read memory instruction descriptor"); }
+            layout.AddMemIns(bblId, memIns);
+        }
+    }
+
+    // Read the mapping of HW thread identifiers to global thread IDs
+    uint32_t numThreads = 0;
+    if (!load(&numThreads, sizeof(numThreads)) || (numThreads > MEMTRACE_NUM_SR0_VALUES))
+    {
+        return fail("could not read the number of threads");
+    }
+    layout.threads.resize(numThreads);
+    layout.sr0Tids.resize(MEMTRACE_NUM_SR0_VALUES);
+    if (!load(layout.threads.data(), numThreads * sizeof(MemTraceGlobalTid)) ||
+        !load(layout.sr0Tids.data(), MEMTRACE_NUM_SR0_VALUES * sizeof(uint32_t)))
+    {
+        return fail("could not read thread identifiers");
+    }
+
+    // Read segments of raw trace records. Captures of earlier versions have a single segment with a 32-bit size
+    uint32_t trimmed     = 0;
+    uint32_t numSegments = 1;
+    if (!load(&trimmed, sizeof(trimmed)) ||
+        ((signature == MEMTRACE_RAW_SEGMENTED_SIGNATURE) && !load(&numSegments, sizeof(numSegments))) ||
+        (numSegments * sizeof(uint64_t) > fileSize))
+    {
+        return fail("could not read the trace header");
+    }
+    isTrimmed = (trimmed != 0);
+    segments.resize(numSegments);
+    for (vector<uint8_t>& segment : segments)
+    {
+        uint64_t segmentSize = 0;
+        uint32_t traceSize   = 0;
+        bool     isOk        = (signature == MEMTRACE_RAW_SEGMENTED_SIGNATURE) ? load(&segmentSize, sizeof(segmentSize)) :
+                                                                                 load(&traceSize, sizeof(traceSize));
+        segmentSize = std::max<uint64_t>(segmentSize, traceSize);
+        if (!isOk || (segmentSize > fileSize - (uint64_t)fs.tellg()))
+        {
+            return fail("unexpected size of the raw trace");
+        }
+        segment.resize(segmentSize);
+        if (!load(segment.data(), segmentSize))
+        {
+            return fail("could not read the raw trace");
+        }
+    }
+    if ((uint64_t)fs.tellg() != fileSize)
+    {
+        return fail("unexpected size of the raw trace");
+    }
+
+    // Validate thread identifiers of the records, which are used as indices by the post-processing
+    bool isValid = true;
+    ForEachRawRecord(layout, Segments(), [&](const MemTraceRecordHeader* header, uint32_t)
+    {
+        isValid = isValid && (layout.sr0Tids[header->sr0] < numThreads);
+    });
+    return isValid ? true : fail("invalid thread identifier in a trace record");
+}
+
+/// Visitor that appends a raw record for each record of a trace file. The sr0 field of the record is the index of its thread
+class RawTraceBuilder : public MemTraceVisitor
+{
+public:
+    RawTraceBuilder(MemTraceKernelLayout& layout, vector<uint8_t>& trace) : _layout(layout), _trace(trace) {}
+
+    void OnThread(const MemTraceGlobalTid& gtid, uint32_t) override { _layout.threads.push_back(gtid); }
+
+    void OnRecord(const MemTraceRecord& record) override
+    {
+        MemTraceRecordHeader header = {};
+        header.bblId = (uint16_t)record.bbl->bblId;
+        header.sr0   = (uint16_t)(_layout.threads.size() - 1);
+        header.ce    = record.execMask;
+        header.dm    = UINT32_MAX;
+
+        size_t recordOffset = _trace.size();
+        _trace.resize(recordOffset + _layout.AlignedHeaderSize() + record.bbl->payloadSize, 0);
+        memcpy(_trace.data() + recordOffset, &header, sizeof(header));
+        if (record.bbl->payloadSize != 0)
+        {
+            memcpy(_trace.data() + recordOffset + _layout.AlignedHeaderSize(), record.payload, record.bbl->payloadSize);
+        }
+    }
+
+private:
+    MemTraceKernelLayout&   _layout;    ///< Layout that receives threads of the trace file
+    vector<uint8_t>&        _trace;     ///< Raw trace
+};
+
+bool MemTraceRawDispatch::LoadTraceFile(const string& path, string& error)
+{
+    MemTraceFileReader reader;
+    if (!reader.Open(path))
+    {
+        error = reader.Error();
+        return false;
+    }
+    if (reader.NumThreads() > MEMTRACE_NUM_SR0_VALUES)
+    {
+        error = path + ": too many threads for raw trace records";
+        return false;
+    }
+    layout = MemTraceKernelLayout();
+    layout.grfSize = reader.GrfSize();
+    for (const MemTraceBblInfo& bblInfo : reader.Bbls())
+    {
+        if (bblInfo.bblId > UINT16_MAX)
+        {
+            error = path + ": BBL ID " + to_string(bblInfo.bblId) + " does not fit raw trace records";
+            return false;
+        }
+        for (const MemTracePackedMemIns& memIns : bblInfo.memInstructions) { layout.AddMemIns(bblInfo.bblId, memIns); }
+    }
+    layout.sr0Tids.resize(MEMTRACE_NUM_SR0_VALUES);
+    for (uint32_t sr0 = 0; sr0 != MEMTRACE_NUM_SR0_VALUES; sr0++) { layout.sr0Tids[sr0] = sr0; }
+
+    segments.assign(1, vector<uint8_t>());
+    isTrimmed = false;
+    RawTraceBuilder builder(layout, segments[0]);
+    if (!reader.Process(builder))
+    {
+        error = reader.Error();
+        return false;
+    }
+    return true;
+}
+
+MemTraceRawSegments MemTraceRawDispatch::Segments() const
+{
+    MemTraceRawSegments views;
+    for (const vector<uint8_t>& segment : segments)
+    {
+        views.push_back(MemTraceRawSegment{segment.data(), segment.size()});
+    }
+    return views;
+}
+
+uint64_t MemTraceRawDispatch::TraceSize() const
+{
+    uint64_t size = 0;
+    for (const vector<uint8_t>& segment : segments) { size += segment.size(); }
+    return size;
+}
@@ -0,0 +1,266 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Processing of raw dispatch traces, independent of GTPin: parsing of trace records, grouping of records
+ *       by threads and serialization in the trace file format.
+ *
+ * A raw trace is read from the profile buffer in segments, each holding complete trace records, so that large
+ * traces do not require a single contiguous allocation. Sizes and offsets of raw traces are 64-bit.
+ *
+ * Raw dispatch traces may be captured in files, so that the post-processing can be replayed offline.
+ * Layout of the raw dispatch capture file (all values are little-endian uint32_t unless specified otherwise):
+ *
+ *   MEMTRACE_RAW_SEGMENTED_SIGNATURE, grfSize
+ *   numBbls, numBbls x { bblId, numMemIns, numMemIns x MemTracePackedMemIns }
+ *   numThreads, numThreads x MemTraceGlobalTid
+ *   MEMTRACE_NUM_SR0_VALUES x global thread ID of the sr0.0[0:15] value
+ *   isTrimmed, numSegments, numSegments x { segmentSize (uint64_t), segmentSize bytes of raw trace records }
+ *
+ * Captures of earlier versions start with MEMTRACE_RAW_SIGNATURE and end with a single segment:
+ *   isTrimmed, traceSize, traceSize bytes of raw trace records
+ */
+
+#ifndef DISPATCH_TRACE_H_
+#define DISPATCH_TRACE_H_
+
+#include <string>
+#include <vector>
+
+#include "memtrace_format.h"
+#include "trace_codec.h"
+#include "trace_file_writer.h"
+#include "trace_reader.h"
+
+/// Number of distinct values of sr0.0[0:15], which identifies the HW thread of a raw trace record
+static const uint32_t MEMTRACE_NUM_SR0_VALUES = 0x10000;
+
+/// First value of the segmented raw dispatch capture file ("MTRS")
+static const uint32_t MEMTRACE_RAW_SEGMENTED_SIGNATURE = 0x5352544D;
+
+/* ============================================================================================= */
+// Struct MemTraceRawSegment
+/* ============================================================================================= */
+/*!
+ * Segment of a raw dispatch trace. Records do not cross segment boundaries
+ */
+struct MemTraceRawSegment
+{
+    const uint8_t*  data;   ///< Raw trace records
+    uint64_t        size;   ///< Size of the segment in bytes
+};
+
+/// Raw dispatch trace: segments in the order of their records in the profile buffer
+using MemTraceRawSegments = std::vector<MemTraceRawSegment>;
+
+/* ============================================================================================= */
+// Struct MemTraceKernelLayout
+/* ============================================================================================= */
+/*!
+ * Static information required to process raw traces of a kernel: descriptors of SLM accesses in BBLs and
+ * the mapping of HW thread identifiers to global thread IDs
+ */
+struct MemTraceKernelLayout
+{
+    uint32_t                        grfSize = 0;    ///< Size of the GRF register in bytes. Set before adding instructions
+    std::vector<MemTraceBblInfo>    bblInfos;       ///< BBL ID -> descriptor of SLM accesses (dense table)
+    std::vector<uint32_t>           recordSizes;    ///< BBL ID -> size of the raw trace record, or 0 (dense table)
+    std::vector<uint32_t>           sr0Tids;        ///< sr0.0[0:15] -> global thread ID
+    std::vector<MemTraceGlobalTid>  threads;        ///< Global thread ID -> fields of the thread identifier
+
+    /// Append the memory instruction to the descriptor of the specified BBL
+    void AddMemIns(uint32_t bblId, const MemTracePackedMemIns& memIns);
+
+    /// @return Size of the raw trace record generated by the specified BBL, or 0 if the BBL does not access SLM
+    uint32_t RecordSize(uint32_t bblId) const { return (bblId < recordSizes.size()) ? recordSizes[bblId] : 0; }
+
+    uint32_t AlignedHeaderSize()    const { return MemTraceRecordHeader::AlignedSize(grfSize); }
+    uint32_t NumThreads()           const { return (uint32_t)threads.size(); }
+    uint32_t NumMemBbls()           const;  ///< Number of BBLs that access SLM
+};
+
+/*!
+ * Call visit(header, recordSize) for each complete record of the raw trace. The walk stops at the end of the trace,
+ * or at a record of an unknown BBL
+ */
+template <typename Visitor>
+void ForEachRawRecord(const MemTraceKernelLayout& layout, const uint8_t* trace, uint64_t traceSize, Visitor visit)
+{
+    for (uint64_t recordOffset = 0; recordOffset + sizeof(MemTraceRecordHeader) <= traceSize;)
+    {
+        const MemTraceRecordHeader* header = (const MemTraceRecordHeader*)(trace + recordOffset);
+        uint32_t recordSize = layout.RecordSize(header->bblId);
+        if ((recordSize == 0) || (recordOffset + recordSize > traceSize))
+        {
+            break; // end of trace
+        }
+        visit(header, recordSize);
+        recordOffset += recordSize;
+    }
+}
+
+/// Call visit(header, recordSize) for each complete record of all segments of the raw trace
+template <typename Visitor>
+void ForEachRawRecord(const MemTraceKernelLayout& layout, const MemTraceRawSegments& segments, Visitor visit)
+{
+    for (const MemTraceRawSegment& segment : segments)
+    {
+        ForEachRawRecord(layout, segment.data, segment.size, visit);
+    }
+}
+
+/*!
+ * @return Size of the leading complete records of the raw trace data
+ * @param[out] isEnd  The walk stopped at a record of an unknown BBL, which marks the end of the trace,
+ *                    rather than at the end of the data or at an incomplete record
+ */
+uint64_t CompleteRawRecordsSize(const MemTraceKernelLayout& layout, const uint8_t* trace, uint64_t traceSize, bool& isEnd);
+
+/* ============================================================================================= */
+// Class MemTraceSerializer
+/* ============================================================================================= */
+/*!
+ * Stores raw dispatch traces of a kernel in the memorytrace_compressed.bin format
+ */
+class MemTraceSerializer
+{
+public:
+    /// Reference to a raw trace record
+    struct TraceRecord
+    {
+        const MemTraceRecordHeader* header;     ///< Record header
+        uint32_t                    size;       ///< Record size
+    };
+
+    /*!
+     * Trace records grouped by threads in a single contiguous array (CSR layout), and other scratch data reused
+     * across traces, so that processing does not allocate memory once the arrays are large enough.
+     * After BucketByThread(), records of thread tid are records[threadBegin[tid - 1]] ... records[threadBegin[tid] - 1]
+     * (starting from 0 for tid 0), in the order of their appearance in the trace
+     */
+    struct Scratch
+    {
+        std::vector<uint64_t>                   threadBegin;    ///< Thread ID -> end of the thread's records in records
+        std::vector<TraceRecord>                records;        ///< Trace records sorted by thread ID
+        std::vector<uint64_t>                   segmentEnds;    ///< Ends of thread segments in records
+        MemTraceEncoder                         encoder;        ///< Encoder of thread traces in the version 2 format
+        std::vector<MemTraceThreadIndexEntry>   threadIndex;    ///< Thread index of the last stored trace
+    };
+
+    /*!
+     * @param version     Version of the trace file format, 1, 2 or 3
+     * @param storeIndex  Append the thread index to the stored trace. Ignored by version 3, which always stores
+     *                    the thread table
+     */
+    MemTraceSerializer(const MemTraceKernelLayout& layout, uint32_t version, bool storeIndex = false) :
+        _layout(layout), _version(version), _storeIndex(storeIndex) {}
+
+    /// Store the raw trace of a dispatch by the specified writer
+    void Store(const MemTraceRawSegments& segments, Scratch& scratch, TraceFileWriter& fs) const;
+    void Store(const uint8_t* trace, uint64_t traceSize, Scratch& scratch, TraceFileWriter& fs) const
+    {
+        Store(MemTraceRawSegments{MemTraceRawSegment{trace, traceSize}}, scratch, fs);
+    }
+
+    /*!
+     * Group records of the raw trace by threads using the counting sort
+     * @return Number of threads that have records
+     */
+    uint32_t BucketByThread(const MemTraceRawSegments& segments, Scratch& scratch) const;
+    uint32_t BucketByThread(const uint8_t* trace, uint64_t traceSize, Scratch& scratch) const
+    {
+        return BucketByThread(MemTraceRawSegments{MemTraceRawSegment{trace, traceSize}}, scratch);
+    }
+
+    /// Store records grouped by BucketByThread() by the specified writer. Store() is BucketByThread() + StoreBuckets()
+    void StoreBuckets(Scratch& scratch, TraceFileWriter& fs) const;
+
+    /*!
+     * Max size of raw records of a thread segment in the trace file. Traces of threads with more records are split
+     * into segments (see memtrace_format.h), so that record counts and encoded sizes fit 32 bits
+     */
+    static const uint64_t MAX_SEGMENT_SIZE = 0x40000000;
+
+private:
+    /*!
+     * @return Number of leading records of the thread, starting from the specified one, that fit in a segment
+     * @param numRecords     Number of remaining records of the thread
+     * @param maxRecordSize  Max size of a raw record in the kernel
+     */
+    static uint32_t SegmentRecords(const TraceRecord* records, uint64_t numRecords, uint32_t maxRecordSize);
+
+    /// Encode the specified records of a thread and store them in the version 2 format
+    void StoreEncodedRecords(const TraceRecord* records, uint32_t numRecords, MemTraceEncoder& encoder,
+                             TraceFileWriter& fs) const;
+
+    /// Store records grouped by BucketByThread() and split into thread segments in the version 3 (columnar) format
+    void StoreColumns(const Scratch& scratch, TraceFileWriter& fs) const;
+
+    /// Store zero bytes up to the file offset aligned to MEMTRACE_COLUMN_ALIGNMENT. @return The aligned offset
+    static uint64_t StorePadding(TraceFileWriter& fs);
+
+    /// Store a value of type T in binary format
+    template <typename T> static void Store(const T& val, TraceFileWriter& fs) { fs.Store(val); }
+
+private:
+    const MemTraceKernelLayout& _layout;        ///< Layout of the kernel
+    uint32_t                    _version;       ///< Version of the trace file format
+    bool                        _storeIndex;    ///< Append the thread index to the stored trace
+};
+
+/// Store static information about SLM accesses in BBLs, as laid out in trace files
+void StoreBblInfos(const MemTraceKernelLayout& layout, TraceFileWriter& fs);
+
+/*!
+ * Store the thread index and its trailer after per-thread traces. Offsets are counted from the beginning of the file,
+ * which must be written by fs from the start
+ * @param staticInfoOffset  File offset of static information about SLM accesses in BBLs
+ */
+void StoreThreadIndex(const std::vector<MemTraceThreadIndexEntry>& threadIndex, uint64_t staticInfoOffset,
+                      TraceFileWriter& fs);
+
+/// Store the raw trace of a dispatch, together with the layout of its kernel, in the raw dispatch capture format
+void StoreRawDispatch(const MemTraceKernelLayout& layout, const MemTraceRawSegments& segments, bool isTrimmed,
+                      TraceFileWriter& fs);
+
+/* ============================================================================================= */
+// Struct MemTraceRawDispatch
+/* ============================================================================================= */
+/*!
+ * Raw trace of a dispatch with the layout of its kernel, loaded from a raw dispatch capture file or rebuilt from
+ * a trace file
+ */
+struct MemTraceRawDispatch
+{
+    MemTraceKernelLayout                layout;             ///< Layout of the kernel
+    std::vector<std::vector<uint8_t>>   segments;           ///< Segments of raw trace records
+    bool                                isTrimmed = false;  ///< Trace buffer overflow was detected in the dispatch
+
+    /// @return Views of the segments
+    MemTraceRawSegments Segments() const;
+
+    /// @return Total size of the raw trace
+    uint64_t TraceSize() const;
+
+    /*!
+     * Load the raw dispatch capture file
+     * @param[in]  path   Path to the file
+     * @param[out] error  Description of the error
+     * @return false if the file could not be read or is corrupted
+     */
+    bool Load(const std::string& path, std::string& error);
+
+    /*!
+     * Rebuild the raw trace from a trace file of any version, so that it can be stored in another version. Each thread
+     * trace of the file becomes a HW thread with a single record segment; dispatch masks of records are all ones
+     * @param[in]  path   Path to the trace file
+     * @param[out] error  Description of the error
+     * @return false if the file could not be read or has more threads than raw records can identify
+     */
+    bool LoadTraceFile(const std::string& path, std::string& error);
+};
+
+#endif
@@ -0,0 +1,219 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the SLM hotspot ranking
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "hotspots.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+void WriteJsonString(const string& str, ostream& os)
+{
+    static const char* const hexDigits = "0123456789abcdef";
+    os << '"';
+    for (char c : str)
+    {
+        if ((c == '"') || (c == '\\'))      { os << '\\' << c; }
+        else if ((unsigned char)c < 0x20)   { os << "\\u00" << hexDigits[(c >> 4) & 0xF] << hexDigits[c & 0xF]; }
+        else                                { os << c; }
+    }
+    os << '"';
+}
+
+/// @return Percentage of the total, rounded as in WriteJson of conflict histograms
+static double Share(uint64_t value, uint64_t total)
+{
+    return (total == 0) ? 0 : std::round(double(value) / double(total) * 100 * 10000) / 10000;
+}
+
+/// Write full-run estimates of the dynamic counts of a kernel with sampled traces
+static void WriteEstimates(const SlmKernelCosts& kernel, uint64_t executions, uint64_t stallCycles, ostream& os)
+{
+    if (kernel.samplingScale != 1)
+    {
+        os << ", \"estimated_executions\": " << uint64_t(std::llround(double(executions) * kernel.samplingScale))
+           << ", \"estimated_stall_cycles\": " << uint64_t(std::llround(double(stallCycles) * kernel.samplingScale));
+    }
+}
+
+/// Order of hotspots: stall cycles, descending
+template <typename T>
+static void SortByStallCycles(vector<T>& entries, uint32_t maxEntries)
+{
+    std::stable_sort(entries.begin(), entries.end(), [](const T& a, const T& b) { return a.stallCycles > b.stallCycles; });
+    if ((maxEntries != 0) && (entries.size() > maxEntries))
+    {
+        entries.resize(maxEntries);
+    }
+}
+
+/* ============================================================================================= */
+// SlmKernelCosts implementation
+/* ============================================================================================= */
+SlmKernelCosts::SlmKernelCosts(const string& kernelName, const ConflictHistogramCollector& collector) :
+    name(kernelName), bankModel(collector.BankModel().Config().name), costs(collector.Costs()),
+    histograms(collector.Results()), bblExecutions(collector.BblExecutions()) {}
+
+void SlmKernelCosts::AddInstructions(const vector<MemTraceBblInfo>& bbls)
+{
+    for (const MemTraceBblInfo& bbl : bbls)
+    {
+        for (const MemTracePackedMemIns& memIns : bbl.memInstructions)
+        {
+            memInstructions.emplace(memIns.offset, memIns);
+        }
+    }
+}
+
+uint32_t SlmKernelCosts::NumBblMismatches() const
+{
+    if (expectedBblExecutions.empty())
+    {
+        return 0;
+    }
+
+    // BBLs with SLM accesses are those with traced records or analyzed instructions
+    map<uint32_t, uint64_t> tracedBbls;
+    for (uint32_t bblId = 0; bblId != bblExecutions.size(); bblId++)
+    {
+        if (bblExecutions[bblId] != 0) { tracedBbls[bblId] = bblExecutions[bblId]; }
+    }
+    for (const auto& entry : costs)
+    {
+        tracedBbls.emplace(entry.second.bblId, 0);
+    }
+
+    uint32_t numMismatches = 0;
+    for (const auto& entry : tracedBbls)
+    {
+        uint64_t expected = (entry.first < expectedBblExecutions.size()) ? expectedBblExecutions[entry.first] : 0;
+        if (expected != entry.second) { numMismatches++; }
+    }
+    return numMismatches;
+}
+
+/* ============================================================================================= */
+// WriteHotspotsJson implementation
+/* ============================================================================================= */
+void WriteHotspotsJson(const vector<SlmKernelCosts>& kernels, uint32_t maxEntries, ostream& os)
+{
+    struct KernelEntry
+    {
+        const SlmKernelCosts*   kernel;
+        uint64_t                numAccesses;
+        uint64_t                cycles;
+        uint64_t                stallCycles;
+    };
+    struct BblEntry
+    {
+        const SlmKernelCosts*   kernel;
+        uint32_t                bblId;
+        uint64_t                stallCycles;
+    };
+    struct InsEntry
+    {
+        const SlmKernelCosts*   kernel;
+        uint32_t                offset;
+        const SlmInsCost*       cost;
+        uint64_t                stallCycles;
+    };
+
+    vector<KernelEntry> kernelEntries;
+    vector<BblEntry>    bblEntries;
+    vector<InsEntry>    insEntries;
+    uint64_t            totalStallCycles = 0;
+    for (const SlmKernelCosts& kernel : kernels)
+    {
+        KernelEntry                 kernelEntry{&kernel, 0, 0, 0};
+        map<uint32_t, BblEntry>     bbls;
+        for (const auto& entry : kernel.costs)
+        {
+            const SlmInsCost& cost = entry.second;
+            kernelEntry.numAccesses += cost.numAccesses;
+            kernelEntry.cycles      += cost.cycles;
+            kernelEntry.stallCycles += cost.StallCycles();
+            bbls.emplace(cost.bblId, BblEntry{&kernel, cost.bblId, 0}).first->second.stallCycles += cost.StallCycles();
+            insEntries.push_back(InsEntry{&kernel, entry.first, &cost, cost.StallCycles()});
+        }
+        for (const auto& entry : bbls) { bblEntries.push_back(entry.second); }
+        kernelEntries.push_back(kernelEntry);
+        totalStallCycles += kernelEntry.stallCycles;
+    }
+    SortByStallCycles(kernelEntries, 0);
+    SortByStallCycles(bblEntries, maxEntries);
+    SortByStallCycles(insEntries, maxEntries);
+
+    os << "{\n  \"total_stall_cycles\": " << totalStallCycles << ",\n  \"kernels\": [";
+    const char* sep = "";
+    for (const KernelEntry& entry : kernelEntries)
+    {
+        const SlmKernelCosts& kernel = *entry.kernel;
+        os << sep << "\n    {\"name\": ";
+        WriteJsonString(kernel.name, os);
+        os << ", \"bank_model\": ";
+        WriteJsonString(kernel.bankModel, os);
+        os << ", \"accesses\": " << entry.numAccesses << ", \"cycles\": " << entry.cycles
+           << ", \"stall_cycles\": " << entry.stallCycles << ", \"share\": " << Share(entry.stallCycles, totalStallCycles);
+        if (!kernel.expectedBblExecutions.empty())
+        {
+            os << ", \"bbl_mismatches\": " << kernel.NumBblMismatches();
+        }
+        if (kernel.samplingScale != 1)
+        {
+            os << ", \"sampling_scale\": " << kernel.samplingScale;
+            WriteEstimates(kernel, entry.numAccesses, entry.stallCycles, os);
+        }
+        os << "}";
+        sep = ",";
+    }
+
+    os << "\n  ],\n  \"bbls\": [";
+    sep = "";
+    for (const BblEntry& entry : bblEntries)
+    {
+        const SlmKernelCosts& kernel = *entry.kernel;
+        uint64_t executions = (entry.bblId < kernel.bblExecutions.size()) ? kernel.bblExecutions[entry.bblId] : 0;
+        os << sep << "\n    {\"kernel\": ";
+        WriteJsonString(kernel.name, os);
+        os << ", \"bbl\": " << entry.bblId << ", \"executions\": " << executions;
+        if (!kernel.expectedBblExecutions.empty())
+        {
+            uint64_t expected = (entry.bblId < kernel.expectedBblExecutions.size()) ? kernel.expectedBblExecutions[entry.bblId] : 0;
+            os << ", \"expected_executions\": " << expected;
+        }
+        os << ", \"stall_cycles\": " << entry.stallCycles << ", \"share\": " << Share(entry.stallCycles, totalStallCycles);
+        WriteEstimates(kernel, executions, entry.stallCycles, os);
+        os << "}";
+        sep = ",";
+    }
+
+    os << "\n  ],\n  \"instructions\": [";
+    sep = "";
+    for (const InsEntry& entry : insEntries)
+    {
+        const SlmInsCost& cost = *entry.cost;
+        double stallsPerExecution = (cost.numAccesses == 0) ? 0 : double(entry.stallCycles) / double(cost.numAccesses);
+        os << sep << "\n    {\"kernel\": ";
+        WriteJsonString(entry.kernel->name, os);
+        os << ", \"offset\": " << entry.offset << ", \"bbl\": " << cost.bblId << ", \"executions\": " << cost.numAccesses
+           << ", \"lanes\": " << cost.numLanes << ", \"cycles\": " << cost.cycles << ", \"min_cycles\": " << cost.minCycles
+           << ", \"stall_cycles\": " << entry.stallCycles << ", \"stall_cycles_per_execution\": " << stallsPerExecution
+           << ", \"share\": " << Share(entry.stallCycles, totalStallCycles);
+        WriteEstimates(*entry.kernel, cost.numAccesses, entry.stallCycles, os);
+        os << "}";
+        sep = ",";
+    }
+    os << "\n  ]\n}\n";
+}
@@ -0,0 +1,66 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Ranking of SLM bank conflict hotspots by estimated stall cycles: instructions, BBLs and kernels
+ */
+
+#ifndef HOTSPOTS_H_
+#define HOTSPOTS_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "bank_conflicts.h"
+
+/* ============================================================================================= */
+// Struct SlmKernelCosts
+/* ============================================================================================= */
+/*!
+ * Bank cycles of SLM instructions of a kernel, accumulated over all analyzed dispatches
+ */
+struct SlmKernelCosts
+{
+    std::string         name;                   ///< Kernel name
+    std::string         bankModel;              ///< Name of the SLM bank model
+    SlmCostResults      costs;                  ///< Bank cycles of instructions
+    ConflictResults     histograms;             ///< Histograms of conflict degrees of instructions
+    std::map<uint32_t, MemTracePackedMemIns> memInstructions;  ///< Instruction offset -> static information,
+                                                               ///< empty if unknown
+    BblExecutionCounts  bblExecutions;          ///< Number of traced executions of each BBL
+    BblExecutionCounts  expectedBblExecutions;  ///< Number of executions of each BBL counted by the pre-processing
+                                                ///< phase, or empty if unknown
+    double              samplingScale = 1;      ///< Factor that scales dynamic counts of sampled traces to full-run
+                                                ///< estimates (see MemTraceSampling), 1 if traces are not sampled
+
+    /// Fill the costs from the specified collector
+    SlmKernelCosts(const std::string& kernelName, const ConflictHistogramCollector& collector);
+
+    /// Add static information about memory instructions of the specified BBLs
+    void AddInstructions(const std::vector<MemTraceBblInfo>& bbls);
+
+    /*!
+     * @return Number of BBLs with SLM accesses whose traced executions differ from expectedBblExecutions,
+     *         or 0 if expected executions are unknown
+     */
+    uint32_t NumBblMismatches() const;
+};
+
+/// Write the string as a JSON string literal
+void WriteJsonString(const std::string& str, std::ostream& os);
+
+/*!
+ * Write the ranking of SLM hotspots of the specified kernels in JSON format:
+ * { "kernels": [...], "bbls": [...], "instructions": [...] }, each list sorted by estimated stall cycles,
+ * which the bank model computes for each dynamic execution of an instruction. Entries of kernels with sampled traces
+ * also report the sampling scale and full-run estimates of executions and stall cycles
+ * @param maxEntries  Max number of entries in the BBL and instruction lists, 0 - unlimited
+ */
+void WriteHotspotsJson(const std::vector<SlmKernelCosts>& kernels, uint32_t maxEntries, std::ostream& os);
+
+#endif
@@ -0,0 +1,129 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the selection of traced kernels and kernel dispatches
+ */
+
+#include <cstdlib>
+
+#include "kernel_filter.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+bool GlobMatch(const char* pattern, const char* name)
+{
+    // Greedy matching with backtracking to the last '*': linear in the common case, O(n * m) in the worst case
+    const char* starPattern = nullptr;
+    const char* starName    = nullptr;
+    while (*name != '\0')
+    {
+        if ((*pattern == '?') || ((*pattern != '*') && (*pattern == *name)))
+        {
+            ++pattern;
+            ++name;
+        }
+        else if (*pattern == '*')
+        {
+            starPattern = pattern++;
+            starName    = name;
+        }
+        else if (starPattern != nullptr)
+        {
+            pattern = starPattern + 1;
+            name    = ++starName;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (*pattern == '*') { ++pattern; }
+    return (*pattern == '\0');
+}
+
+/* ============================================================================================= */
+// KernelFilter implementation
+/* ============================================================================================= */
+KernelFilter::KernelFilter(const string& includeSpec, const string& excludeSpec) :
+    _includes(Split(includeSpec)), _excludes(Split(excludeSpec)) {}
+
+vector<string> KernelFilter::Split(const string& spec)
+{
+    vector<string> patterns;
+    for (size_t begin = 0; begin <= spec.size();)
+    {
+        size_t end = spec.find(',', begin);
+        if (end == string::npos) { end = spec.size(); }
+
+        // Trim spaces around the pattern
+        size_t first = spec.find_first_not_of(' ', begin);
+        size_t last  = spec.find_last_not_of(' ', end - 1);
+        if ((first < end) && (last != string::npos) && (last >= first))
+        {
+            patterns.emplace_back(spec.substr(first, last - first + 1));
+        }
+        begin = end + 1;
+    }
+    return patterns;
+}
+
+bool KernelFilter::MatchesAny(const vector<string>& patterns, const string& name, const string& extName)
+{
+    for (const string& pattern : patterns)
+    {
+        if (GlobMatch(pattern.c_str(), name.c_str()) || GlobMatch(pattern.c_str(), extName.c_str()))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KernelFilter::Matches(const string& name, const string& extName) const
+{
+    if (!_includes.empty() && !MatchesAny(_includes, name, extName))
+    {
+        return false;
+    }
+    return !MatchesAny(_excludes, name, extName);
+}
+
+/* ============================================================================================= */
+// DispatchRange implementation
+/* ============================================================================================= */
+bool DispatchRange::Parse(const string& spec)
+{
+    _first = 0;
+    _last  = UINT64_MAX;
+    if (spec.empty())
+    {
+        return true;
+    }
+
+    // Parse an optional number and return the position after it, or nullptr if the number is malformed
+    auto parseIndex = [](const char* str, uint64_t& index) -> const char*
+    {
+        if ((*str < '0') || (*str > '9')) { return str; }
+        char* end = nullptr;
+        index = strtoull(str, &end, 10);
+        return end;
+    };
+
+    const char* pos = parseIndex(spec.c_str(), _first);
+    if (*pos == '-')
+    {
+        pos = parseIndex(pos + 1, _last);
+    }
+    else
+    {
+        _last = _first;
+    }
+    return (*pos == '\0') && (_first <= _last);
+}
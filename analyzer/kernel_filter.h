@@ -0,0 +1,84 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Selection of traced kernels and kernel dispatches
+ */
+
+#ifndef KERNEL_FILTER_H_
+#define KERNEL_FILTER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*!
+ * @return true if the name matches the glob pattern, where '*' matches any sequence of characters
+ *         and '?' matches any single character
+ */
+bool GlobMatch(const char* pattern, const char* name);
+
+/* ============================================================================================= */
+// Class KernelFilter
+/* ============================================================================================= */
+/*!
+ * Filter of kernels by name. A kernel passes the filter if its name or extended name matches any include pattern
+ * (or the include list is empty), and matches none of the exclude patterns
+ */
+class KernelFilter
+{
+public:
+    /*!
+     * @param includeSpec  Comma-separated names or glob patterns of included kernels. If empty, all kernels are included
+     * @param excludeSpec  Comma-separated names or glob patterns of excluded kernels
+     */
+    explicit KernelFilter(const std::string& includeSpec = "", const std::string& excludeSpec = "");
+
+    /// @return true if the kernel with the specified name and extended name passes the filter
+    bool Matches(const std::string& name, const std::string& extName) const;
+
+    /// @return true if the filter passes all kernels
+    bool IsEmpty() const { return _includes.empty() && _excludes.empty(); }
+
+private:
+    /// Split the comma-separated list of patterns
+    static std::vector<std::string> Split(const std::string& spec);
+
+    /// @return true if any of the names matches any of the patterns
+    static bool MatchesAny(const std::vector<std::string>& patterns, const std::string& name, const std::string& extName);
+
+private:
+    std::vector<std::string>    _includes;  ///< Patterns of included kernels
+    std::vector<std::string>    _excludes;  ///< Patterns of excluded kernels
+};
+
+/* ============================================================================================= */
+// Class DispatchRange
+/* ============================================================================================= */
+/*!
+ * Inclusive range of dispatch indices of a kernel. Dispatches of each kernel are counted from 0
+ */
+class DispatchRange
+{
+public:
+    /*!
+     * Parse the range in one of the forms: "first-last", "first-", "-last" or "index".
+     * An empty string specifies all dispatches
+     * @return false if the specification is malformed
+     */
+    bool Parse(const std::string& spec);
+
+    bool Contains(uint64_t index) const { return (index >= _first) && (index <= _last); }
+
+    uint64_t First()    const { return _first; }
+    uint64_t Last()     const { return _last; }     ///< UINT64_MAX if the range is not bounded
+
+private:
+    uint64_t    _first = 0;             ///< First dispatch in the range
+    uint64_t    _last  = UINT64_MAX;    ///< Last dispatch in the range
+};
+
+#endif
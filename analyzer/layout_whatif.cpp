@@ -0,0 +1,257 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the what-if analysis of SLM layouts
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "hotspots.h"
+#include "layout_whatif.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// Split the string by the separator
+static vector<string> Split(const string& str, char separator)
+{
+    vector<string> items;
+    string         item;
+    istringstream  is(str);
+    while (getline(is, item, separator))
+    {
+        items.push_back(item);
+    }
+    return items;
+}
+
+/// Parse the unsigned decimal or hexadecimal number. @return false if the string is not a number
+static bool ParseNumber(const string& str, uint32_t& value)
+{
+    if (str.empty() || (str[0] == '-')) { return false; }
+    char*         end;
+    unsigned long number = strtoul(str.c_str(), &end, 0);
+    if ((*end != '\0') || (number > UINT32_MAX)) { return false; }
+    value = (uint32_t)number;
+    return true;
+}
+
+/* ============================================================================================= */
+// SlmLayoutCandidate implementation
+/* ============================================================================================= */
+bool SlmLayoutCandidate::Parse(const string& spec, SlmLayoutCandidate& candidate)
+{
+    candidate      = SlmLayoutCandidate();
+    candidate.name = spec;
+    for (const string& item : Split(spec, '+'))
+    {
+        vector<string> fields = Split(item, ':');
+        if (fields.empty()) { return false; }
+
+        const string& kind    = fields[0];
+        bool          isValid = false;
+        if (kind == "none")
+        {
+            isValid = (fields.size() == 1);
+        }
+        else if ((kind == "pad") && (candidate.transform == Transform::NONE))
+        {
+            candidate.transform = Transform::PAD;
+            isValid = (fields.size() == 3) && ParseNumber(fields[1], candidate.rowPitch) && ParseNumber(fields[2], candidate.padBytes);
+        }
+        else if ((kind == "xor") && (candidate.transform == Transform::NONE))
+        {
+            candidate.transform = Transform::XOR;
+            isValid = (fields.size() == 2) && ParseNumber(fields[1], candidate.rowPitch);
+        }
+        else if (kind == "region")
+        {
+            isValid = (fields.size() == 3) && ParseNumber(fields[1], candidate.regionBase) && ParseNumber(fields[2], candidate.regionSize);
+        }
+        else if (kind == "banks")
+        {
+            isValid = (fields.size() == 2) && ParseNumber(fields[1], candidate.numBanks) &&
+                      (candidate.numBanks != 0) && (candidate.numBanks <= MAX_SLM_BANKS);
+        }
+        if (!isValid) { return false; }
+    }
+    return (candidate.transform == Transform::NONE) || (candidate.rowPitch != 0);
+}
+
+vector<SlmLayoutCandidate> SlmLayoutCandidate::Standard(uint32_t rowPitch, uint32_t bankWidth)
+{
+    string                      pitch = to_string(rowPitch);
+    vector<SlmLayoutCandidate>  candidates;
+    for (const string& spec : {"pad:" + pitch + ":" + to_string(bankWidth),
+                               "pad:" + pitch + ":" + to_string(2 * bankWidth),
+                               "xor:" + pitch})
+    {
+        SlmLayoutCandidate candidate;
+        Parse(spec, candidate);
+        candidates.push_back(candidate);
+    }
+    return candidates;
+}
+
+const char* SlmLayoutCandidate::SpecUsage()
+{
+    return "Candidate layout: '+'-separated list of items\n"
+           "  none                  addresses are not transformed\n"
+           "  pad:<pitch>:<bytes>   rows of <pitch> bytes are padded with <bytes> bytes\n"
+           "  xor:<pitch>           bank words of each row of <pitch> bytes are XOR-ed with the row index\n"
+           "  region:<base>:<size>  the array occupies <size> bytes from <base> (default - the whole SLM)\n"
+           "  banks:<N>             number of SLM banks (default - banks of the bank model)\n";
+}
+
+/* ============================================================================================= */
+// SlmLayoutSimulator implementation
+/* ============================================================================================= */
+SlmLayoutSimulator::SlmLayoutSimulator(const SlmBankConfig& bankConfig, const vector<SlmLayoutCandidate>& candidates)
+{
+    SlmLayoutCandidate baseline;
+    baseline.name = "none";
+    _profiles.push_back(CandidateProfile{baseline, 0, ConflictHistogramCollector(bankConfig)});
+
+    for (const SlmLayoutCandidate& candidate : candidates)
+    {
+        SlmBankConfig config = bankConfig;
+        if (candidate.numBanks != 0)
+        {
+            config.numBanks = candidate.numBanks;
+        }
+
+        // XOR-ed row indices are limited to the power of two that fits both the number of banks and the number
+        // of bank words in a row, so that swizzled addresses stay within the row
+        uint32_t xorMask = 0;
+        if (candidate.transform == SlmLayoutCandidate::Transform::XOR)
+        {
+            uint32_t rowWords = candidate.rowPitch / config.bankWidth;
+            for (uint32_t width = 1; (width * 2 <= config.numBanks) && (width * 2 <= rowWords); width *= 2)
+            {
+                xorMask = width * 2 - 1;
+            }
+        }
+        _profiles.push_back(CandidateProfile{candidate, xorMask, ConflictHistogramCollector(config)});
+    }
+}
+
+uint32_t SlmLayoutSimulator::TransformAddress(const CandidateProfile& profile, uint32_t addr, uint32_t bankWidth)
+{
+    const SlmLayoutCandidate& candidate = profile.candidate;
+    uint32_t offset = addr - candidate.regionBase;
+    if ((addr < candidate.regionBase) || (offset >= candidate.regionSize))
+    {
+        return addr;
+    }
+
+    uint32_t row    = offset / candidate.rowPitch;
+    uint32_t column = offset % candidate.rowPitch;
+    if (candidate.transform == SlmLayoutCandidate::Transform::PAD)
+    {
+        return candidate.regionBase + row * (candidate.rowPitch + candidate.padBytes) + column;
+    }
+    uint32_t word = (column / bankWidth) ^ (row & profile.xorMask);
+    return candidate.regionBase + row * candidate.rowPitch + word * bankWidth + column % bankWidth;
+}
+
+void SlmLayoutSimulator::OnRecord(const MemTraceRecord& record)
+{
+    const vector<MemTracePackedMemIns>& memInstructions = record.bbl->memInstructions;
+    for (CandidateProfile& profile : _profiles)
+    {
+        if (profile.candidate.transform == SlmLayoutCandidate::Transform::NONE)
+        {
+            profile.profile.OnRecord(record);
+            continue;
+        }
+
+        // Transform addresses of analyzed channels in a copy of the address payloads. SLM offsets are 32-bit,
+        // so only the low dword of a 64-bit address is transformed
+        uint32_t bankWidth = profile.profile.BankModel().Config().bankWidth;
+        _payload.assign(record.payload, record.payload + record.bbl->payloadSize);
+        for (uint32_t i = 0; i != memInstructions.size(); i++)
+        {
+            const MemTracePackedMemIns& memIns   = memInstructions[i];
+            uint32_t                    laneMask = MemTraceLaneMask(memIns, record.execMask);
+            uint32_t                    addrSize = MemTraceAddrSize(memIns);
+            uint8_t*                    payload  = _payload.data() + record.bbl->payloadOffsets[i];
+            for (uint32_t lane = 0; laneMask != 0; lane++, laneMask >>= 1)
+            {
+                if ((laneMask & 1) == 0) { continue; }
+                uint32_t addr;
+                memcpy(&addr, payload + lane * addrSize, sizeof(uint32_t));
+                addr = TransformAddress(profile, addr, bankWidth);
+                memcpy(payload + lane * addrSize, &addr, sizeof(uint32_t));
+            }
+        }
+        profile.profile.OnRecord(MemTraceRecord{record.bbl, record.execMask, _payload.data()});
+    }
+}
+
+void SlmLayoutSimulator::WriteJson(ostream& os) const
+{
+    struct Summary
+    {
+        const CandidateProfile* profile;
+        uint64_t                cycles;
+        uint64_t                stallCycles;
+        ConflictHistogram       histogram;
+    };
+    vector<Summary> summaries;
+    for (const CandidateProfile& profile : _profiles)
+    {
+        Summary summary{&profile, 0, 0, ConflictHistogram()};
+        for (const auto& entry : profile.profile.Costs())
+        {
+            summary.cycles      += entry.second.cycles;
+            summary.stallCycles += entry.second.StallCycles();
+        }
+        for (const auto& entry : profile.profile.Results())
+        {
+            for (const auto& bin : entry.second) { summary.histogram[bin.first] += bin.second; }
+        }
+        summaries.push_back(summary);
+    }
+    uint64_t baselineStallCycles = summaries.front().stallCycles;
+    std::stable_sort(summaries.begin(), summaries.end(),
+                     [](const Summary& a, const Summary& b) { return a.stallCycles < b.stallCycles; });
+
+    os << "{\n  \"bank_model\": ";
+    WriteJsonString(_profiles.front().profile.BankModel().Config().name, os);
+    os << ",\n  \"candidates\": [";
+    const char* sep  = "";
+    uint32_t    rank = 1;
+    for (const Summary& summary : summaries)
+    {
+        double reduction = (baselineStallCycles == 0) ? 0 :
+                           (double(baselineStallCycles) - double(summary.stallCycles)) / double(baselineStallCycles) * 100;
+        os << sep << "\n    {\"rank\": " << rank++ << ", \"name\": ";
+        WriteJsonString(summary.profile->candidate.name, os);
+        os << ", \"banks\": " << summary.profile->profile.BankModel().Config().numBanks
+           << ", \"stall_cycles\": " << summary.stallCycles << ", \"cycles\": " << summary.cycles
+           << ", \"stall_reduction\": " << (std::round(reduction * 10000) / 10000) << ", \"histogram\": [";
+
+        uint64_t total = 0;
+        for (const auto& bin : summary.histogram) { total += bin.second; }
+        const char* binSep = "";
+        for (const auto& bin : summary.histogram)
+        {
+            double percent = std::round(double(bin.second) / double(total) * 100 * 10000) / 10000;
+            os << binSep << "[" << bin.first << ", " << percent << "]";
+            binSep = ", ";
+        }
+        os << "]}";
+        sep = ",";
+    }
+    os << "\n  ]\n}\n";
+}
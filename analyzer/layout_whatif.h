@@ -0,0 +1,107 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file What-if analysis of SLM layouts: SLM accesses of traces are replayed through candidate address
+ *       transforms (row padding, XOR swizzles) and bank counts, and candidates are ranked by estimated stall cycles
+ */
+
+#ifndef LAYOUT_WHATIF_H_
+#define LAYOUT_WHATIF_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "bank_conflicts.h"
+
+/* ============================================================================================= */
+// Struct SlmLayoutCandidate
+/* ============================================================================================= */
+/*!
+ * Candidate SLM layout: an address transform of a 2D array in SLM and the number of banks.
+ * The specification is a '+'-separated list of items:
+ *   none                   - addresses are not transformed
+ *   pad:<pitch>:<bytes>    - rows of <pitch> bytes are padded with <bytes> bytes
+ *   xor:<pitch>            - bank words of each row of <pitch> bytes are XOR-ed with the row index
+ *   region:<base>:<size>   - the array occupies <size> bytes from <base>; other addresses are not transformed
+ *                            (default - the whole SLM)
+ *   banks:<N>              - number of SLM banks (default - banks of the bank model)
+ */
+struct SlmLayoutCandidate
+{
+    /// Address transform
+    enum class Transform
+    {
+        NONE,   ///< Addresses are not transformed
+        PAD,    ///< Row padding
+        XOR     ///< XOR swizzle of bank words
+    };
+
+    std::string name;                           ///< Specification of the candidate
+    Transform   transform   = Transform::NONE;  ///< Address transform
+    uint32_t    rowPitch    = 0;                ///< Size of the array row in bytes
+    uint32_t    padBytes    = 0;                ///< Padding at the end of each row in bytes (PAD)
+    uint32_t    regionBase  = 0;                ///< First byte of the array
+    uint32_t    regionSize  = UINT32_MAX;       ///< Size of the array in bytes
+    uint32_t    numBanks    = 0;                ///< Number of SLM banks, 0 - banks of the bank model
+
+    /*!
+     * Parse the candidate specification
+     * @return false if the specification is invalid
+     */
+    static bool Parse(const std::string& spec, SlmLayoutCandidate& candidate);
+
+    /// @return Standard candidates for an array with rows of the specified pitch
+    static std::vector<SlmLayoutCandidate> Standard(uint32_t rowPitch, uint32_t bankWidth);
+
+    /// @return Description of the candidate specification, for usage messages
+    static const char* SpecUsage();
+};
+
+/* ============================================================================================= */
+// Class SlmLayoutSimulator
+/* ============================================================================================= */
+/*!
+ * Replays SLM accesses through all candidate layouts in a single pass over the trace. The unmodified layout
+ * is always evaluated as the baseline
+ */
+class SlmLayoutSimulator : public MemTraceVisitor
+{
+public:
+    /*!
+     * @param bankConfig  Bank model of the baseline layout
+     * @param candidates  Candidate layouts
+     */
+    SlmLayoutSimulator(const SlmBankConfig& bankConfig, const std::vector<SlmLayoutCandidate>& candidates);
+
+    /// Implementation of the MemTraceVisitor interface
+    void OnRecord(const MemTraceRecord& record) override;
+
+    /*!
+     * Write candidates ranked by estimated stall cycles in JSON format:
+     * { "bank_model": ..., "candidates": [ { "rank", "name", "banks", "stall_cycles", "cycles", "stall_reduction",
+     *   "histogram": [[degree, percent], ...] }, ... ] }
+     */
+    void WriteJson(std::ostream& os) const;
+
+private:
+    /// Candidate layout and its conflict profile
+    struct CandidateProfile
+    {
+        SlmLayoutCandidate          candidate;  ///< Candidate layout
+        uint32_t                    xorMask;    ///< Mask of row indices XOR-ed with bank words (XOR)
+        ConflictHistogramCollector  profile;    ///< Histograms and bank cycles of transformed accesses
+    };
+
+    /// @return Transformed SLM address
+    static uint32_t TransformAddress(const CandidateProfile& profile, uint32_t addr, uint32_t bankWidth);
+
+    std::vector<CandidateProfile>   _profiles;  ///< Profiles of the baseline and candidates
+    std::vector<uint8_t>            _payload;   ///< Address payloads of the record transformed by a candidate
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the read-only memory mapping of files
+ */
+
+#if !defined(TARGET_WINDOWS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#include "mapped_file.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// MappedFile implementation
+/* ============================================================================================= */
+MappedFile::~MappedFile()
+{
+#if !defined(TARGET_WINDOWS)
+    if (_data != nullptr) { munmap(_data, _size); }
+#else
+    if (_data != nullptr) { UnmapViewOfFile(_data); }
+#endif
+}
+
+bool MappedFile::Map(const string& path)
+{
+#if !defined(TARGET_WINDOWS)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+    struct stat st;
+    bool isOk = (fstat(fd, &st) == 0);
+    _size = isOk ? size_t(st.st_size) : 0;
+    if (isOk && (_size != 0))
+    {
+        void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        isOk  = (data != MAP_FAILED);
+        _data = isOk ? data : nullptr;
+    }
+    close(fd);
+    return isOk;
+#else
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+    LARGE_INTEGER size;
+    bool isOk = (GetFileSizeEx(file, &size) != 0);
+    _size = isOk ? size_t(size.QuadPart) : 0;
+    if (isOk && (_size != 0))
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        _data = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        isOk  = (_data != nullptr);
+        if (mapping != nullptr) { CloseHandle(mapping); }
+    }
+    CloseHandle(file);
+    return isOk;
+#endif
+}
@@ -0,0 +1,44 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Read-only memory mapping of files
+ */
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+/* ============================================================================================= */
+// Class MappedFile
+/* ============================================================================================= */
+/*!
+ * Read-only mapping of a file. The mapping starts at a page boundary, so data at file offsets aligned to
+ * the cache line size is aligned in memory as well
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    /// Map the file. @return false if the file could not be mapped
+    bool Map(const std::string& path);
+
+    const char* Data()  const { return (const char*)_data; }
+    size_t      Size()  const { return _size; }
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    void*   _data = nullptr;    ///< Mapped contents of the file
+    size_t  _size = 0;          ///< Size of the file
+};
+
+#endif
@@ -0,0 +1,311 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Benchmark of the trace processing stages on a synthetic trace: bucketing of raw records by threads,
+ *       the conflict degree kernel, writing and parsing of trace files in all format versions, and the SLM bank
+ *       conflict analysis.
+ *       Results are printed in JSON format, so that they can be tracked over time
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(TARGET_WINDOWS)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "bank_conflicts.h"
+#include "bank_model.h"
+#include "conflict_kernel.h"
+#include "trace_generator.h"
+
+using namespace std;
+
+/// @return Peak resident set size of the process in KB
+static uint64_t PeakRssKb()
+{
+#if defined(TARGET_WINDOWS)
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? (counters.PeakWorkingSetSize / 1024) : 0;
+#elif defined(TARGET_MAC)
+    struct rusage usage;
+    return (getrusage(RUSAGE_SELF, &usage) == 0) ? (uint64_t(usage.ru_maxrss) / 1024) : 0;  // bytes on macOS
+#else
+    struct rusage usage;
+    return (getrusage(RUSAGE_SELF, &usage) == 0) ? uint64_t(usage.ru_maxrss) : 0;           // KB on Linux
+#endif
+}
+
+/// Visitor that only counts trace records, to measure the cost of parsing
+class RecordCounter : public MemTraceVisitor
+{
+public:
+    void OnRecord(const MemTraceRecord&) override { ++numRecords; }
+
+    uint64_t numRecords = 0;
+};
+
+/// Visitor that passes records with address payloads to the collector, to measure the analysis of version 3 files
+/// without the column path
+class RecordForwarder : public MemTraceVisitor
+{
+public:
+    explicit RecordForwarder(MemTraceVisitor& visitor) : _visitor(visitor) {}
+
+    void OnRecord(const MemTraceRecord& record) override { _visitor.OnRecord(record); }
+
+private:
+    MemTraceVisitor& _visitor;  ///< Visitor that receives the records
+};
+
+/// Measurements of a benchmark stage
+struct StageResult
+{
+    string      name;           ///< Stage name
+    uint64_t    numRecords;     ///< Number of processed records
+    uint64_t    numBytes;       ///< Number of processed bytes: raw trace, or trace file
+    double      seconds;        ///< Time spent in the stage
+    uint64_t    peakRssKb;      ///< Peak RSS of the process at the end of the stage
+};
+
+/// Run the stage and record its measurements. @return false if the stage failed
+static bool RunStage(const string& name, uint64_t numRecords, uint64_t numBytes, const function<bool()>& stage,
+                     vector<StageResult>& results)
+{
+    auto startTime = chrono::steady_clock::now();
+    bool isOk = stage();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    if (!isOk)
+    {
+        cerr << "MEMTRACE_BENCH: Stage " << name << " failed" << endl;
+        return false;
+    }
+    results.push_back(StageResult{name, numRecords, numBytes, seconds, PeakRssKb()});
+    return true;
+}
+
+static void WriteJson(const MemTraceGenConfig& config, uint64_t numRecords, const vector<StageResult>& results, ostream& os)
+{
+    os << "{\n  \"config\": {\"records\": " << numRecords << ", \"threads\": " << config.numThreads
+       << ", \"bbls\": " << config.numBbls << ", \"ins_per_bbl\": " << config.numInsPerBbl
+       << ", \"simd\": " << config.simdWidth << ", \"stride\": " << config.stride
+       << ", \"broadcast\": " << config.broadcastFraction << ", \"slm_size\": " << config.slmSize
+       << ", \"grf_size\": " << config.grfSize << ", \"seed\": " << config.seed << "},\n  \"stages\": [";
+    const char* sep = "";
+    for (const StageResult& result : results)
+    {
+        double seconds = (result.seconds > 0) ? result.seconds : 1e-9;
+        os << sep << "\n    {\"name\": \"" << result.name << "\", \"records\": " << result.numRecords
+           << ", \"bytes\": " << result.numBytes << ", \"seconds\": " << result.seconds
+           << ", \"records_per_s\": " << (result.numRecords / seconds) << ", \"bytes_per_s\": " << (result.numBytes / seconds)
+           << ", \"peak_rss_kb\": " << result.peakRssKb << "}";
+        sep = ",";
+    }
+    os << "\n  ]\n}\n";
+}
+
+static void PrintUsage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 << " [-size <MB>] [-nb <number of banks>] [-dir <directory>] [-keep] [-o <output JSON file>]"
+            " [generator options]\n"
+         << "  -size       Size of the raw dispatch trace in MB (default - 256)\n"
+         << "  -nb         Number of SLM banks used by the conflict analysis (default - 16)\n"
+         << "  -dir        Directory of temporary trace files (default - current directory)\n"
+         << "  -keep       Keep temporary trace files\n"
+         << "  -o          File that receives the results (default - standard output)\n"
+         << MemTraceGenConfig::OptionsUsage();
+}
+
+int main(int argc, const char* argv[])
+{
+    MemTraceGenConfig   config;
+    uint64_t            sizeMb      = 256;
+    uint32_t            numBanks    = 16;
+    string              dir         = ".";
+    bool                keepFiles   = false;
+    string              outPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "-size") && hasValue)      { sizeMb    = strtoull(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-nb") && hasValue)   { numBanks  = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-dir") && hasValue)  { dir       = argv[++i]; }
+        else if (!strcmp(argv[i], "-o") && hasValue)    { outPath   = argv[++i]; }
+        else if (!strcmp(argv[i], "-keep"))             { keepFiles = true; }
+        else if (!config.ParseOption(argc, argv, i))
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((sizeMb == 0) || (numBanks == 0) || !config.IsValid())
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    MemTraceGenerator           generator(config);
+    uint64_t                    numRecords = sizeMb * 0x100000 / generator.RawRecordSize();
+    vector<uint8_t>             rawTrace;
+    MemTraceSerializer::Scratch scratch;
+    vector<StageResult>         results;
+    const MemTraceKernelLayout& layout   = generator.Layout();
+    uint64_t                    rawBytes = numRecords * generator.RawRecordSize();
+
+    bool isOk = RunStage("generate", numRecords, rawBytes, [&]
+    {
+        generator.GenerateRawTrace(numRecords, rawTrace);
+        return true;
+    }, results);
+
+    isOk = isOk && RunStage("bucket", numRecords, rawBytes, [&]
+    {
+        return MemTraceSerializer(layout, 1).BucketByThread(rawTrace.data(), rawBytes, scratch) != 0;
+    }, results);
+
+    // Conflict degree kernel applied to all SLM accesses of the raw trace, for each supported instruction set
+    for (auto isa : {ConflictKernel::Isa::SCALAR, ConflictKernel::Isa::AVX2, ConflictKernel::Isa::AVX512})
+    {
+        ConflictKernel kernel(numBanks, isa);
+        if (!isOk || (kernel.GetIsa() != isa)) { continue; }
+
+        isOk = RunStage(string("conflict_kernel_") + ConflictKernel::IsaName(isa), numRecords, rawBytes, [&]
+        {
+            uint64_t degreeSum         = 0;
+            uint32_t alignedHeaderSize = layout.AlignedHeaderSize();
+            ForEachRawRecord(layout, rawTrace.data(), rawBytes, [&](const MemTraceRecordHeader* header, uint32_t)
+            {
+                const MemTraceBblInfo& bblInfo  = layout.bblInfos[header->bblId];
+                const uint8_t*         payload  = (const uint8_t*)header + alignedHeaderSize;
+                uint32_t               execMask = header->ce & header->dm;
+                for (uint32_t i = 0; i != bblInfo.memInstructions.size(); i++)
+                {
+                    degreeSum += kernel.Degree(bblInfo.memInstructions[i], execMask, payload + bblInfo.payloadOffsets[i]);
+                }
+            });
+            return (degreeSum != 0);
+        }, results);
+    }
+
+    // SLM bank models of platforms applied to all SLM accesses of the raw trace
+    for (const char* modelName : {"gen9", "xe-hpc"})
+    {
+        SlmBankConfig bankConfig;
+        SlmBankConfig::FromName(modelName, config.grfSize, bankConfig);
+        SlmBankModel model(bankConfig);
+
+        isOk = isOk && RunStage(string("bank_model_") + modelName, numRecords, rawBytes, [&]
+        {
+            uint64_t      cycleSum          = 0;
+            uint32_t      alignedHeaderSize = layout.AlignedHeaderSize();
+            SlmAccessCost cost;
+            ForEachRawRecord(layout, rawTrace.data(), rawBytes, [&](const MemTraceRecordHeader* header, uint32_t)
+            {
+                const MemTraceBblInfo& bblInfo  = layout.bblInfos[header->bblId];
+                const uint8_t*         payload  = (const uint8_t*)header + alignedHeaderSize;
+                uint32_t               execMask = header->ce & header->dm;
+                for (uint32_t i = 0; i != bblInfo.memInstructions.size(); i++)
+                {
+                    if (model.Evaluate(bblInfo.memInstructions[i], execMask, payload + bblInfo.payloadOffsets[i], cost))
+                    {
+                        cycleSum += cost.cycles;
+                    }
+                }
+            });
+            return (cycleSum != 0);
+        }, results);
+    }
+
+    // Write trace files of all versions, then parse and analyze them
+    for (uint32_t version = 1; isOk && (version <= 3); version++)
+    {
+        string   suffix   = "_v" + to_string(version);
+        string   filePath = dir + "/memtrace_bench" + suffix + ".bin";
+        uint64_t fileSize = 0;
+
+        isOk = isOk && RunStage("write" + suffix, numRecords, rawBytes, [&]
+        {
+            TraceFileWriter fs;
+            if (!fs.Open(filePath)) { return false; }
+            MemTraceSerializer(layout, version).Store(rawTrace.data(), rawBytes, scratch, fs);
+            bool isClosed = fs.Close();
+            fileSize = fs.BytesWritten();
+            return isClosed;
+        }, results);
+
+        // Parsing and analysis read the file through the page cache, which holds the file just written
+        auto process = [&](MemTraceVisitor& visitor)
+        {
+            MemTraceFileReader reader;
+            if (!reader.Open(filePath) || !reader.Process(visitor))
+            {
+                cerr << "MEMTRACE_BENCH: " << reader.Error() << endl;
+                return false;
+            }
+            return true;
+        };
+        isOk = isOk && RunStage("parse" + suffix, numRecords, fileSize, [&]
+        {
+            RecordCounter counter;
+            return process(counter) && (counter.numRecords == numRecords);
+        }, results);
+        isOk = isOk && RunStage("analyze" + suffix, numRecords, fileSize, [&]
+        {
+            ConflictHistogramCollector collector(numBanks);
+            return process(collector);
+        }, results);
+        isOk = isOk && ((version != 3) || RunStage("analyze_payloads" + suffix, numRecords, fileSize, [&]
+        {
+            ConflictHistogramCollector collector(numBanks);
+            RecordForwarder            forwarder(collector);
+            return process(forwarder);
+        }, results));
+        isOk = isOk && RunStage("analyze_patterns" + suffix, numRecords, fileSize, [&]
+        {
+            BankConflictAnalyzer analyzer(numBanks);
+            if (!process(analyzer)) { return false; }
+            analyzer.Results();     // Conflict degrees are computed from the collected patterns
+            return true;
+        }, results);
+
+        if (!keepFiles)
+        {
+            remove(filePath.c_str());
+        }
+    }
+    if (!isOk)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (outPath.empty())
+    {
+        WriteJson(config, numRecords, results, cout);
+    }
+    else
+    {
+        ofstream os(outPath);
+        if (!os)
+        {
+            cerr << "MEMTRACE_BENCH: Could not create file " << outPath << endl;
+            return EXIT_FAILURE;
+        }
+        WriteJson(config, numRecords, results, os);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Layout of the memorytrace_compressed.bin file produced by the Localmemorytrace tool.
+ *
+ * This header does not depend on GTPin, so that the same definitions are shared by the tool
+ * (which writes the file) and by the offline analyzer (which reads it).
+ *
+ * File layout (all values are little-endian uint32_t unless specified otherwise):
+ *
+ *   numBbls
+ *   numBbls x { bblId, numMemIns, numMemIns x MemTracePackedMemIns }
+ *   numThreads
+ *   numThreads x { MemTraceGlobalTid, numRecords,
+ *                  numRecords x { bblId, execMask, address payloads of all memory instructions in the BBL } }
+ *
+ * The size of the address payload of a memory instruction is addrPayloadLength GRF registers.
+ *
+ * The trace of a thread may be split into several consecutive segments with the same MemTraceGlobalTid, so that
+ * the 32-bit record counts and encoded sizes do not overflow for very large traces. numThreads counts segments,
+ * and readers treat each segment as a separate thread trace.
+ *
+ * Version 2 of the format (opt-in) starts with a header { MEMTRACE_V2_SIGNATURE, grfSize }, followed by the
+ * same static part and number of threads. The records of each thread are encoded by MemTraceEncoder
+ * (see trace_codec.h) into a byte stream that follows the thread header:
+ *
+ *   numThreads x { MemTraceGlobalTid, numRecords, encodedSize, encodedSize bytes of encoded records }
+ *
+ * Version 2 keeps addresses of enabled channels of SLM scatter messages only (see MemTraceLaneMask).
+ * Other bytes of address payloads are decoded as zeros.
+ *
+ * Version 3 of the format (opt-in) is columnar: fields of records are stored in separate contiguous columns rather
+ * than record by record, so that analyses can map the file and process each column with vector loads. It starts
+ * with a header { MEMTRACE_V3_SIGNATURE, grfSize }, followed by the same static part, and a thread table that
+ * locates records of each thread in the columns:
+ *
+ *   numThreads
+ *   numThreads x MemTraceThreadIndexEntry, where offset is the index of the first record of the thread
+ *   padding to MEMTRACE_COLUMN_ALIGNMENT, MemTraceColumnsHeader
+ *   columns, each starting at a file offset aligned to MEMTRACE_COLUMN_ALIGNMENT (see MemTraceColumnsHeader)
+ *
+ * Records of threads are stored in the order of the thread table. The address column keeps addresses of enabled
+ * channels of SLM scatter messages only (see MemTraceColumnLaneMask), packed without gaps in the order of records,
+ * instructions of the BBL and channels; 32-bit SLM offsets are stored for 64-bit addresses. The number of addresses
+ * of a record follows from its BBL and execution mask, so only the first address of each thread is stored, and
+ * readers locate addresses of records while walking the records of the thread. Version 3 files do not have the
+ * thread index: the thread table serves the same purpose.
+ *
+ * Files of versions 1 and 2 may end with a thread index (opt-in), which locates the trace of each thread without
+ * parsing the traces before it, so that threads can be read in parallel or selectively:
+ *
+ *   numThreads x MemTraceThreadIndexEntry
+ *   MemTraceIndexTrailer
+ *
+ * The trailer is the last part of the file. Per-thread traces end at the beginning of the thread index.
+ */
+
+#ifndef MEMTRACE_FORMAT_H_
+#define MEMTRACE_FORMAT_H_
+
+#include <algorithm>
+#include <cstdint>
+
+/* ============================================================================================= */
+// Struct MemTracePackedMemIns
+/* ============================================================================================= */
+/*!
+ * Packed descriptor of a memory instruction, as stored in the static part of the trace file
+ */
+struct MemTracePackedMemIns
+{
+    uint32_t offset;                    ///< Instruction offset within the kernel binary
+
+    uint32_t isWrite            : 1;    ///< Store message
+    uint32_t isScatter          : 1;    ///< Scatter/gather message - one address per channel
+    uint32_t isBTS              : 1;    ///< Binding table surface
+    uint32_t isSLM              : 1;    ///< Shared local memory access
+    uint32_t isScratch          : 1;    ///< Scratch space access
+    uint32_t isAtomic           : 1;    ///< Atomic operation
+    uint32_t addressWidth       : 1;    ///< 0 - 32-bit addresses, 1 - 64-bit addresses
+    uint32_t simdWidth          : 1;    ///< 0 - SIMD8, 1 - SIMD16
+    uint32_t bti                : 8;    ///< Binding table index
+    uint32_t elementSize        : 8;    ///< Size of the data element in bytes
+    uint32_t numElements        : 8;    ///< Number of data elements accessed by each channel
+
+    uint32_t addrPayloadLength  : 5;    ///< Size of the address payload in GRF registers
+    uint32_t dataPort           : 1;    ///< 0 - DP0, 1 - DP1
+    uint32_t isEOT              : 1;    ///< End of thread
+    uint32_t isMedia            : 1;    ///< Media block message
+    uint32_t res                : 8;    ///< Reserved
+    uint32_t execSize           : 8;    ///< Execution size of the SEND instruction
+    uint32_t channelOffset      : 8;    ///< First channel of the execution mask used by the instruction
+};
+static_assert(sizeof(MemTracePackedMemIns) == 3 * sizeof(uint32_t), "Unexpected size of MemTracePackedMemIns");
+
+/* ============================================================================================= */
+// Struct MemTraceRecordHeader
+/* ============================================================================================= */
+/*!
+ * Header of the raw trace record written by the instrumentation. The record header is followed by address
+ * payloads of all memory instructions in the basic block
+ */
+struct MemTraceRecordHeader
+{
+    uint16_t bblId;         ///< ID of the basic block that generated the record
+    uint16_t sr0;           ///< sr0.0[0:15] - identifies the HW thread that generated the record
+    uint32_t ce;            ///< Channel enable register
+    uint32_t dm;            ///< Dispatch mask register
+    uint32_t cr0;           ///< Control register (valid in entry BBL only)
+    uint32_t flag0;         ///< Flag register f0
+    uint32_t flag1;         ///< Flag register f1
+
+    /// @return Size of the record header aligned to the GRF register size
+    static uint32_t AlignedSize(uint32_t grfSize)
+    {
+        return (uint32_t(sizeof(MemTraceRecordHeader)) + grfSize - 1) / grfSize * grfSize;
+    }
+};
+
+/* ============================================================================================= */
+// Struct MemTraceGlobalTid
+/* ============================================================================================= */
+/*!
+ * Global thread identifier, as stored in the trace file at the beginning of each thread's trace.
+ * Fields that do not exist on the profiled platform are set to UINT32_MAX
+ */
+struct MemTraceGlobalTid
+{
+    uint32_t sliceId;
+    uint32_t dualSubSliceId;
+    uint32_t subSliceId;
+    uint32_t euId;
+    uint32_t threadSlot;
+};
+static_assert(sizeof(MemTraceGlobalTid) == 5 * sizeof(uint32_t), "Unexpected size of MemTraceGlobalTid");
+
+/* ============================================================================================= */
+// Struct MemTraceThreadIndexEntry
+/* ============================================================================================= */
+/*!
+ * Entry of the thread index: location of a thread's trace in the file
+ */
+struct MemTraceThreadIndexEntry
+{
+    MemTraceGlobalTid   gtid;           ///< Global thread identifier
+    uint32_t            numRecords;     ///< Number of records of the thread
+    uint64_t            offset;         ///< File offset of the thread's trace, starting from the thread header.
+                                        ///< In version 3 files - index of the first record of the thread in columns
+};
+static_assert(sizeof(MemTraceThreadIndexEntry) == 32, "Unexpected size of MemTraceThreadIndexEntry");
+
+/* ============================================================================================= */
+// Struct MemTraceIndexTrailer
+/* ============================================================================================= */
+/*!
+ * Trailer of the thread index, stored at the end of the file
+ */
+struct MemTraceIndexTrailer
+{
+    uint64_t            staticInfoOffset;   ///< File offset of static information about SLM accesses in BBLs
+    uint64_t            indexOffset;        ///< File offset of the thread index
+    uint32_t            numThreads;         ///< Number of entries in the thread index
+    uint32_t            signature;          ///< MEMTRACE_INDEX_SIGNATURE
+};
+static_assert(sizeof(MemTraceIndexTrailer) == 24, "Unexpected size of MemTraceIndexTrailer");
+
+/* ============================================================================================= */
+// Struct MemTraceColumnsHeader
+/* ============================================================================================= */
+/*!
+ * Header of columns of the version 3 trace file. Columns are indexed by records of all threads
+ */
+struct MemTraceColumnsHeader
+{
+    uint64_t            numRecords;         ///< Number of records of all threads
+    uint64_t            numAddresses;       ///< Number of channel addresses of all records
+    uint64_t            bblIdsOffset;       ///< File offset of BBL IDs of records: numRecords x uint16_t
+    uint64_t            execMasksOffset;    ///< File offset of execution masks of records: numRecords x uint32_t
+    uint64_t            threadAddrsOffset;  ///< File offset of indices of the first address of each thread (segment)
+                                            ///< of the thread table in the address column: numThreads x uint64_t
+    uint64_t            addressesOffset;    ///< File offset of channel addresses: numAddresses x uint32_t
+};
+static_assert(sizeof(MemTraceColumnsHeader) == 48, "Unexpected size of MemTraceColumnsHeader");
+
+/// Alignment of columns of the version 3 trace file in bytes: the size of the cache line and of the widest vector load
+static const uint32_t MEMTRACE_COLUMN_ALIGNMENT = 64;
+
+/// First value of the version 2 trace file ("MTV2"). Version 1 files start with the number of BBLs
+static const uint32_t MEMTRACE_V2_SIGNATURE = 0x3256544D;
+
+/// First value of the version 3 (columnar) trace file ("MTV3")
+static const uint32_t MEMTRACE_V3_SIGNATURE = 0x3356544D;
+
+/// Last value of the trace file with the thread index ("MTIX")
+static const uint32_t MEMTRACE_INDEX_SIGNATURE = 0x5849544D;
+
+/// First value of the raw dispatch capture file ("MTRD"), see dispatch_trace.h
+static const uint32_t MEMTRACE_RAW_SIGNATURE = 0x4452544D;
+
+/// @return Size of a channel address in the address payload of the memory instruction
+inline uint32_t MemTraceAddrSize(const MemTracePackedMemIns& memIns)
+{
+    return (memIns.addressWidth ? sizeof(uint64_t) : sizeof(uint32_t));
+}
+
+/*!
+ * @return Mask of enabled channels whose addresses are analyzed, relative to the first channel of the instruction.
+ *         Only SLM scatter messages are analyzed: block messages access consecutive addresses, so they never
+ *         cause bank conflicts
+ */
+inline uint32_t MemTraceLaneMask(const MemTracePackedMemIns& memIns, uint32_t execMask)
+{
+    if (!memIns.isSLM || !memIns.isScatter || (memIns.channelOffset >= 32))
+    {
+        return 0;
+    }
+    uint32_t execSize = (memIns.execSize != 0) ? memIns.execSize : (memIns.simdWidth ? 16 : 8);
+    uint32_t numLanes = std::min(execSize, 32u);
+    uint32_t laneMask = (execMask >> memIns.channelOffset);
+    return (numLanes == 32) ? laneMask : (laneMask & ((1u << numLanes) - 1));
+}
+
+/*!
+ * @return Mask of channels whose addresses are stored in the address column of the version 3 trace file:
+ *         analyzed channels (see MemTraceLaneMask) whose addresses fit in the instruction's address payload
+ */
+inline uint32_t MemTraceColumnLaneMask(const MemTracePackedMemIns& memIns, uint32_t execMask, uint32_t grfSize)
+{
+    uint32_t maxLanes = memIns.addrPayloadLength * grfSize / MemTraceAddrSize(memIns);
+    uint32_t laneMask = MemTraceLaneMask(memIns, execMask);
+    return (maxLanes >= 32) ? laneMask : (laneMask & ((1u << maxLanes) - 1));
+}
+
+/// Name of the trace file stored in each kernel dispatch directory
+static const char* const MEMTRACE_FILE_NAME = "memorytrace_compressed.bin";
+
+/// Name of the raw dispatch capture file stored in the kernel dispatch directory (optional)
+static const char* const MEMTRACE_RAW_FILE_NAME = "memorytrace_dispatch.raw";
+
+#endif
@@ -0,0 +1,66 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Generator of synthetic memorytrace_compressed.bin files
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "trace_generator.h"
+
+using namespace std;
+
+static void PrintUsage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 << " -size <MB> [-format <1|2|3>] [-index] [generator options] -o <output trace file>\n"
+         << "  -size       Size of the trace in MB, as stored in the version 1 format\n"
+         << "  -format     Version of the trace file format (default - 1). Version 3 files are written from a raw\n"
+         << "              dispatch trace held in memory\n"
+         << "  -index      Append the thread index to the trace file. Version 3 files always have the thread table\n"
+         << "  -o          Output trace file\n"
+         << MemTraceGenConfig::OptionsUsage();
+}
+
+int main(int argc, const char* argv[])
+{
+    MemTraceGenConfig   config;
+    uint64_t            sizeMb   = 0;
+    uint32_t            version  = 1;
+    bool                hasIndex = false;
+    string              outPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "-size") && hasValue)          { sizeMb   = strtoull(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-format") && hasValue)   { version  = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-o") && hasValue)        { outPath  = argv[++i]; }
+        else if (!strcmp(argv[i], "-index"))                { hasIndex = true; }
+        else if (!config.ParseOption(argc, argv, i))
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((sizeMb == 0) || outPath.empty() || (version < 1) || (version > 3) || !config.IsValid())
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    MemTraceGenerator generator(config);
+    uint64_t numRecords = sizeMb * 0x100000 / generator.FileRecordSize();
+    if (!generator.StoreTraceFile(outPath, version, numRecords, hasIndex))
+    {
+        cerr << "MEMTRACE_GEN: Could not write file " << outPath << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
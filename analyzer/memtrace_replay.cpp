@@ -0,0 +1,129 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Replay of the trace post-processing: stores raw dispatch traces captured by the Localmemorytrace tool
+ *       (capture_raw knob) in the trace file format, without GTPin and GPU, and reports the processing throughput.
+ *       With -trace, inputs are trace files, so that traces are converted between versions of the file format
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dispatch_trace.h"
+
+using namespace std;
+
+#if defined(TARGET_WINDOWS)
+static const char* const NULL_DEVICE = "NUL";
+#else
+static const char* const NULL_DEVICE = "/dev/null";
+#endif
+
+static void PrintUsage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 << " [-format <1|2|3>] [-index] [-repeat <N>] [-trace] [-o <output trace file>]"
+                                 " <raw dispatch capture file>...\n"
+         << "  -format  Version of the trace file format (default - 1)\n"
+         << "  -index   Append the thread index to traces\n"
+         << "  -repeat  Number of times each capture is processed (default - 1)\n"
+         << "  -trace   Inputs are trace files of any version, which are stored in the -format version\n"
+         << "  -o       File that receives the trace of the single capture (default - traces are discarded)\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    uint32_t        version     = 1;
+    uint32_t        numRepeats  = 1;
+    bool            hasIndex    = false;
+    bool            isTrace     = false;
+    string          outPath;
+    vector<string>  capturePaths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "-format") && hasValue)        { version    = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-repeat") && hasValue)   { numRepeats = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-o") && hasValue)        { outPath    = argv[++i]; }
+        else if (!strcmp(argv[i], "-index"))                { hasIndex   = true; }
+        else if (!strcmp(argv[i], "-trace"))                { isTrace    = true; }
+        else if (argv[i][0] != '-')                         { capturePaths.emplace_back(argv[i]); }
+        else
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (capturePaths.empty() || (numRepeats == 0) || (version < 1) || (version > 3) ||
+        (!outPath.empty() && (capturePaths.size() != 1)))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Scratch data is reused across captures, as in the post-processing of the tool
+    MemTraceSerializer::Scratch scratch;
+    uint64_t                    totalRecords = 0;
+    uint64_t                    totalBytes   = 0;
+    double                      totalSeconds = 0;
+    for (const string& path : capturePaths)
+    {
+        MemTraceRawDispatch dispatch;
+        string              error;
+        if (!(isTrace ? dispatch.LoadTraceFile(path, error) : dispatch.Load(path, error)))
+        {
+            cerr << "MEMTRACE_REPLAY: " << error << endl;
+            return EXIT_FAILURE;
+        }
+        if (dispatch.isTrimmed)
+        {
+            cerr << "MEMTRACE_REPLAY: " << path << ": trace buffer overflow was detected in the captured dispatch" << endl;
+        }
+
+        MemTraceRawSegments segments   = dispatch.Segments();
+        uint64_t            numRecords = 0;
+        ForEachRawRecord(dispatch.layout, segments, [&](const MemTraceRecordHeader*, uint32_t) { ++numRecords; });
+
+        MemTraceSerializer serializer(dispatch.layout, version, hasIndex);
+        string             filePath = (outPath.empty() ? string(NULL_DEVICE) : outPath);
+        for (uint32_t r = 0; r != numRepeats; r++)
+        {
+            TraceFileWriter fs;
+            if (!fs.Open(filePath))
+            {
+                cerr << "MEMTRACE_REPLAY: Could not create file " << filePath << endl;
+                return EXIT_FAILURE;
+            }
+            auto startTime = chrono::steady_clock::now();
+            serializer.Store(segments, scratch, fs);
+            bool isOk = fs.Close();
+            totalSeconds += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+            if (!isOk)
+            {
+                cerr << "MEMTRACE_REPLAY: Could not write file " << filePath << endl;
+                return EXIT_FAILURE;
+            }
+        }
+        totalRecords += numRecords * numRepeats;
+        totalBytes   += dispatch.TraceSize() * numRepeats;
+    }
+
+    double totalMb = (double)totalBytes / (1024 * 1024);
+    cout << "records: " << totalRecords << "\n"
+         << "bytes: " << totalBytes << "\n"
+         << "seconds: " << totalSeconds << "\n";
+    if (totalSeconds > 0)
+    {
+        cout << "records/s: " << (totalRecords / totalSeconds) << "\n"
+             << "MB/s: " << (totalMb / totalSeconds) << "\n";
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the parallel processing of trace files with the thread index
+ */
+
+#include <algorithm>
+#include <mutex>
+
+#include "parallel_trace.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+vector<vector<uint32_t>> PartitionThreads(const MemTraceThreadIndex& index, const vector<uint32_t>& threads, uint32_t numShares)
+{
+    vector<uint32_t> order(threads);
+    std::stable_sort(order.begin(), order.end(),
+                     [&index](uint32_t a, uint32_t b) { return index[a].numRecords > index[b].numRecords; });
+
+    vector<vector<uint32_t>> shares(numShares);
+    vector<uint64_t>         shareRecords(numShares, 0);
+    for (uint32_t thread : order)
+    {
+        uint32_t share = uint32_t(std::min_element(shareRecords.begin(), shareRecords.end()) - shareRecords.begin());
+        shares[share].push_back(thread);
+        shareRecords[share] += index[thread].numRecords;
+    }
+
+    // Threads of a share are read in the file order
+    for (vector<uint32_t>& share : shares)
+    {
+        std::sort(share.begin(), share.end());
+    }
+    return shares;
+}
+
+bool ProcessThreadsParallel(const MemTraceFileReader& reader, const vector<uint32_t>& threads, TaskPool& pool,
+                            const vector<MemTraceVisitor*>& visitors, string& error)
+{
+    vector<vector<uint32_t>> shares = PartitionThreads(reader.ThreadIndex(), threads, (uint32_t)visitors.size());
+    mutex errorMutex;
+    error.clear();
+    for (uint32_t i = 0; i != shares.size(); i++)
+    {
+        if (shares[i].empty()) { continue; }
+        pool.Submit([&, i](uint32_t)
+        {
+            // The GRF size is known, so the reader of the share does not walk through the file to detect it
+            MemTraceFileReader shareReader(reader.GrfSize());
+            if (!shareReader.Open(reader.Path()) || !shareReader.ProcessThreads(*visitors[i], shares[i]))
+            {
+                lock_guard<mutex> lock(errorMutex);
+                if (error.empty()) { error = shareReader.Error(); }
+            }
+        });
+    }
+    pool.Wait();
+    return error.empty();
+}
@@ -0,0 +1,46 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Parallel processing of trace files with the thread index: threads are split into shares with balanced
+ *       numbers of records, and each share is read by a separate reader on a worker of the task pool
+ */
+
+#ifndef PARALLEL_TRACE_H_
+#define PARALLEL_TRACE_H_
+
+#include <string>
+#include <vector>
+
+#include "task_pool.h"
+#include "trace_reader.h"
+
+/*!
+ * Split threads into shares with balanced numbers of records. Threads are assigned, from the largest one,
+ * to the share with the fewest records
+ * @param index      Thread index of the file
+ * @param threads    Indices of threads in the thread index
+ * @param numShares  Number of shares
+ * @return numShares arrays of thread indices. Some arrays are empty if there are fewer threads than shares
+ */
+std::vector<std::vector<uint32_t>> PartitionThreads(const MemTraceThreadIndex& index, const std::vector<uint32_t>& threads,
+                                                    uint32_t numShares);
+
+/*!
+ * Process the specified threads of the trace file by workers of the pool. Threads are split into one share per
+ * visitor (see PartitionThreads), and visitors[i] receives records of the i-th share only, so visitors are never
+ * shared by workers. Each share is read by a separate reader of the file
+ * @param[in]  reader    Open reader of the file with the thread index
+ * @param[in]  threads   Indices of threads in the thread index
+ * @param[in]  pool      Pool of workers that read the shares
+ * @param[in]  visitors  Consumers of records of the shares
+ * @param[out] error     Description of the first error
+ * @return false if any share could not be read
+ */
+bool ProcessThreadsParallel(const MemTraceFileReader& reader, const std::vector<uint32_t>& threads, TaskPool& pool,
+                            const std::vector<MemTraceVisitor*>& visitors, std::string& error);
+
+#endif
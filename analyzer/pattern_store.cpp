@@ -0,0 +1,84 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the store of distinct SLM access patterns
+ */
+
+#include <algorithm>
+
+#include "pattern_store.h"
+
+using namespace std;
+
+/// @return hash value combined with the specified 32-bit value
+static inline uint64_t HashCombine(uint64_t hash, uint32_t val)
+{
+    hash ^= val;
+    hash *= 0x100000001b3ull;   // FNV-1a prime
+    return hash ^ (hash >> 29);
+}
+
+static const uint64_t HASH_SEED = 0xcbf29ce484222325ull;    // FNV-1a offset basis
+
+/* ============================================================================================= */
+// PatternStore implementation
+/* ============================================================================================= */
+PatternStore::PatternStore() : _addrBegin(1, 0), _addrIndex(0, AddrsHash{this}, AddrsEqual{this}) {}
+
+size_t PatternStore::AddrsHash::operator()(uint32_t addrsId) const
+{
+    const uint32_t* addrs = store->Addresses(addrsId);
+    uint32_t numAddrs     = store->NumAddresses(addrsId);
+    uint64_t hash         = HashCombine(HASH_SEED, numAddrs);
+    for (uint32_t i = 0; i != numAddrs; i++)
+    {
+        hash = HashCombine(hash, addrs[i]);
+    }
+    return (size_t)hash;
+}
+
+bool PatternStore::AddrsEqual::operator()(uint32_t lhs, uint32_t rhs) const
+{
+    uint32_t numAddrs = store->NumAddresses(lhs);
+    return (numAddrs == store->NumAddresses(rhs)) &&
+           std::equal(store->Addresses(lhs), store->Addresses(lhs) + numAddrs, store->Addresses(rhs));
+}
+
+size_t PatternStore::PatternKeyHash::operator()(const PatternKey& key) const
+{
+    return (size_t)HashCombine(HashCombine(HashCombine(HASH_SEED, key.offset), key.execMask), key.addrsId);
+}
+
+uint32_t PatternStore::Intern(const uint32_t* addrs, uint32_t numAddrs)
+{
+    // Append the vector to the pool as a candidate entry, and drop it if an equal vector is already interned
+    uint32_t candidateId = NumAddressVectors();
+    _addrPool.insert(_addrPool.end(), addrs, addrs + numAddrs);
+    _addrBegin.push_back((uint32_t)_addrPool.size());
+
+    auto ret = _addrIndex.insert(candidateId);
+    if (!ret.second)
+    {
+        _addrPool.resize(_addrBegin[candidateId]);
+        _addrBegin.pop_back();
+    }
+    return *ret.first;
+}
+
+void PatternStore::Add(uint32_t offset, uint32_t execMask, const uint32_t* addrs, uint32_t numAddrs, uint64_t count)
+{
+    PatternKey key{offset, execMask, Intern(addrs, numAddrs)};
+    auto ret = _patternIndex.emplace(key, (uint32_t)_patterns.size());
+    if (ret.second)
+    {
+        _patterns.push_back(Pattern{offset, execMask, key.addrsId, count});
+    }
+    else
+    {
+        _patterns[ret.first->second].count += count;
+    }
+}
@@ -0,0 +1,83 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Hash-based store of distinct SLM access patterns
+ */
+
+#ifndef PATTERN_STORE_H_
+#define PATTERN_STORE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* ============================================================================================= */
+// Class PatternStore
+/* ============================================================================================= */
+/*!
+ * Deduplicates SLM access patterns keyed by (instruction offset, execution mask, lane address vector)
+ * and counts occurrences of each pattern. Lane address vectors are interned: each distinct vector is
+ * stored once and referenced by its ID, so patterns of different instructions share the storage.
+ * All operations take amortized constant time per lane.
+ */
+class PatternStore
+{
+public:
+    /// Distinct access pattern
+    struct Pattern
+    {
+        uint32_t offset;        ///< Instruction offset
+        uint32_t execMask;      ///< Dynamic execution mask
+        uint32_t addrsId;       ///< ID of the interned lane address vector
+        uint64_t count;         ///< Number of occurrences
+    };
+
+    PatternStore();
+    PatternStore(const PatternStore&) = delete;
+    PatternStore& operator = (const PatternStore&) = delete;
+
+    /// Add count occurrences of the specified pattern
+    void Add(uint32_t offset, uint32_t execMask, const uint32_t* addrs, uint32_t numAddrs, uint64_t count = 1);
+
+    /// @return Lane addresses of the specified interned address vector
+    const uint32_t* Addresses(uint32_t addrsId)     const { return _addrPool.data() + _addrBegin[addrsId]; }
+    uint32_t        NumAddresses(uint32_t addrsId)  const { return _addrBegin[addrsId + 1] - _addrBegin[addrsId]; }
+
+    const std::vector<Pattern>& Patterns()              const { return _patterns; }
+    uint32_t                    NumAddressVectors()     const { return (uint32_t)_addrBegin.size() - 1; }
+
+private:
+    /// Hash and equality of interned address vectors, referenced by ID
+    struct AddrsHash  { const PatternStore* store; size_t operator()(uint32_t addrsId) const; };
+    struct AddrsEqual { const PatternStore* store; bool operator()(uint32_t lhs, uint32_t rhs) const; };
+
+    /// Hash and equality of patterns
+    struct PatternKey
+    {
+        uint32_t offset;
+        uint32_t execMask;
+        uint32_t addrsId;
+        bool operator == (const PatternKey& other) const
+        {
+            return (offset == other.offset) && (execMask == other.execMask) && (addrsId == other.addrsId);
+        }
+    };
+    struct PatternKeyHash { size_t operator()(const PatternKey& key) const; };
+
+    /// @return ID of the interned copy of the specified address vector
+    uint32_t Intern(const uint32_t* addrs, uint32_t numAddrs);
+
+private:
+    std::vector<uint32_t>                                       _addrPool;      ///< Concatenated address vectors
+    std::vector<uint32_t>                                       _addrBegin;     ///< ID -> offset in _addrPool
+    std::unordered_set<uint32_t, AddrsHash, AddrsEqual>         _addrIndex;     ///< Set of interned address vector IDs
+    std::vector<Pattern>                                        _patterns;      ///< Distinct patterns in order of appearance
+    std::unordered_map<PatternKey, uint32_t, PatternKeyHash>    _patternIndex;  ///< Pattern -> index in _patterns
+};
+
+#endif
@@ -0,0 +1,425 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the run-to-run comparison of SLM bank conflicts
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include "profile_diff.h"
+
+using namespace std;
+
+#define SLM_PROFILE_VERSION 1   ///< Version of the conflict profile format
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+uint64_t MemInsSignature(const MemTracePackedMemIns& memIns)
+{
+    return uint64_t(memIns.isWrite) | (uint64_t(memIns.isScatter) << 1) | (uint64_t(memIns.isAtomic) << 2) |
+           (uint64_t(memIns.isMedia) << 3) | (uint64_t(memIns.addressWidth) << 4) | (uint64_t(memIns.simdWidth) << 5) |
+           (uint64_t(memIns.isSLM) << 6) | (uint64_t(memIns.elementSize) << 8) | (uint64_t(memIns.numElements) << 16) |
+           (uint64_t(memIns.execSize) << 24) | (uint64_t(memIns.channelOffset) << 32) |
+           (uint64_t(memIns.addrPayloadLength) << 40);
+}
+
+/// @return Estimated stall cycles of the instruction in the full run
+static uint64_t ScaledStallCycles(const SlmKernelProfile& kernel, const SlmInsProfile& ins)
+{
+    return uint64_t(std::llround(double(ins.cost.StallCycles()) * kernel.samplingScale));
+}
+
+/// @return Stall cycles per execution of the instruction
+static double StallCyclesPerExecution(const SlmInsCost& cost)
+{
+    return (cost.numAccesses == 0) ? 0 : double(cost.StallCycles()) / double(cost.numAccesses);
+}
+
+/// @return Total bank cycles of accesses of the kernel
+static SlmInsCost KernelCost(const SlmKernelProfile& kernel)
+{
+    SlmInsCost total;
+    for (const SlmInsProfile& ins : kernel.instructions)
+    {
+        total.numAccesses += ins.cost.numAccesses;
+        total.numLanes    += ins.cost.numLanes;
+        total.cycles      += ins.cost.cycles;
+        total.minCycles   += ins.cost.minCycles;
+    }
+    return total;
+}
+
+/// @return true if the new value exceeds the base value by more than the threshold in percent
+static bool ExceedsThreshold(double base, double current, double percent)
+{
+    return (current > base) && (current > base * (1 + percent / 100));
+}
+
+/// Write the relative change of the value in percent, or null if the base value is 0
+static void WriteChange(double base, double current, ostream& os)
+{
+    os << ", \"change_percent\": ";
+    if (base == 0)
+    {
+        os << ((current == 0) ? "0" : "null");
+        return;
+    }
+    os << std::round((current - base) / base * 100 * 10000) / 10000;
+}
+
+/// @return Status of an entry of the comparison
+static const char* DiffStatus(const void* base, const void* current)
+{
+    return (base == nullptr) ? "added" : ((current == nullptr) ? "removed" : "matched");
+}
+
+/* ============================================================================================= */
+// SlmInsProfile implementation
+/* ============================================================================================= */
+double SlmInsProfile::AverageDegree() const
+{
+    uint64_t numAccesses = 0;
+    uint64_t numCycles   = 0;
+    for (const auto& bin : histogram)
+    {
+        numAccesses += bin.second;
+        numCycles   += std::max(bin.first, 1u) * bin.second;
+    }
+    return (numAccesses == 0) ? 0 : double(numCycles) / double(numAccesses);
+}
+
+uint32_t SlmInsProfile::MaxDegree() const
+{
+    for (auto it = histogram.rbegin(); it != histogram.rend(); ++it)
+    {
+        if (it->second != 0) { return std::max(it->first, 1u); }
+    }
+    return 0;
+}
+
+/* ============================================================================================= */
+// SlmKernelProfile implementation
+/* ============================================================================================= */
+SlmKernelProfile SlmKernelProfile::FromCosts(const SlmKernelCosts& kernel, const SourceAsmIndex* source)
+{
+    SlmKernelProfile profile;
+    profile.name          = kernel.name;
+    profile.bankModel     = kernel.bankModel;
+    profile.samplingScale = kernel.samplingScale;
+    for (const auto& entry : kernel.costs)
+    {
+        SlmInsProfile ins;
+        ins.offset = entry.first;
+        ins.cost   = entry.second;
+
+        auto histogram = kernel.histograms.find(entry.first);
+        if (histogram != kernel.histograms.end()) { ins.histogram = histogram->second; }
+        auto memIns = kernel.memInstructions.find(entry.first);
+        if (memIns != kernel.memInstructions.end()) { ins.signature = MemInsSignature(memIns->second); }
+        const SourceAsmIndex::AsmLine* asmLine = (source == nullptr) ? nullptr : source->FindInstruction(entry.first);
+        if ((asmLine != nullptr) && (asmLine->sourceLine != SourceAsmIndex::NO_SOURCE_LINE))
+        {
+            ins.sourceLine = asmLine->sourceLine + 1;
+        }
+        profile.instructions.push_back(std::move(ins));
+    }
+    return profile;
+}
+
+/* ============================================================================================= */
+// Conflict profile files
+/* ============================================================================================= */
+void WriteProfiles(const vector<SlmKernelProfile>& kernels, ostream& os)
+{
+    os << "slm_profile " << SLM_PROFILE_VERSION << "\n";
+    for (const SlmKernelProfile& kernel : kernels)
+    {
+        os << "kernel " << kernel.name << "\n"
+           << "bank_model " << kernel.bankModel << "\n"
+           << "sampling_scale " << kernel.samplingScale << "\n";
+        for (const SlmInsProfile& ins : kernel.instructions)
+        {
+            const SlmInsCost& cost = ins.cost;
+            os << "ins " << ins.offset << " " << ins.sourceLine << " " << std::hex << ins.signature << std::dec << " "
+               << cost.bblId << " " << cost.numAccesses << " " << cost.numLanes << " " << cost.cycles << " "
+               << cost.minCycles << " ";
+            const char* sep = "";
+            for (const auto& bin : ins.histogram)
+            {
+                os << sep << bin.first << ":" << bin.second;
+                sep = ",";
+            }
+            os << (ins.histogram.empty() ? "-" : "") << "\n";
+        }
+    }
+}
+
+bool ReadProfiles(istream& is, vector<SlmKernelProfile>& kernels)
+{
+    kernels.clear();
+    string   line;
+    string   key;
+    uint32_t version = 0;
+    if (!getline(is, line) || !(istringstream(line) >> key >> version) || (key != "slm_profile") ||
+        (version != SLM_PROFILE_VERSION))
+    {
+        return false;
+    }
+    while (getline(is, line))
+    {
+        if (!line.empty() && (line.back() == '\r')) { line.pop_back(); }
+        istringstream ls(line);
+        if (!(ls >> key)) { continue; }
+
+        // Kernel names and bank models are the rest of the line
+        string value;
+        if ((key == "kernel") || (key == "bank_model"))
+        {
+            getline(ls >> std::ws, value);
+        }
+        if (key == "kernel")
+        {
+            kernels.emplace_back();
+            kernels.back().name = value;
+            continue;
+        }
+        if (kernels.empty()) { return false; }
+        SlmKernelProfile& kernel = kernels.back();
+        if (key == "bank_model")
+        {
+            kernel.bankModel = value;
+        }
+        else if (key == "sampling_scale")
+        {
+            if (!(ls >> kernel.samplingScale)) { return false; }
+        }
+        else if (key == "ins")
+        {
+            SlmInsProfile ins;
+            SlmInsCost&   cost = ins.cost;
+            string        histogram;
+            if (!(ls >> ins.offset >> ins.sourceLine >> std::hex >> ins.signature >> std::dec >> cost.bblId >> cost.numAccesses >>
+                  cost.numLanes >> cost.cycles >> cost.minCycles >> histogram) || (cost.minCycles > cost.cycles))
+            {
+                return false;
+            }
+            if (histogram != "-")
+            {
+                istringstream hs(histogram);
+                uint32_t      degree;
+                uint64_t      count;
+                char          colon;
+                char          comma = ',';
+                while ((comma == ',') && (hs >> degree >> colon >> count) && (colon == ':'))
+                {
+                    ins.histogram[degree] += count;
+                    if (!(hs >> comma)) { comma = '\0'; }
+                }
+                if (comma != '\0') { return false; }
+            }
+            kernel.instructions.push_back(std::move(ins));
+        }
+        // Unknown keys are skipped, for compatibility with newer files
+    }
+    for (SlmKernelProfile& kernel : kernels)
+    {
+        std::stable_sort(kernel.instructions.begin(), kernel.instructions.end(),
+                         [](const SlmInsProfile& lhs, const SlmInsProfile& rhs) { return lhs.offset < rhs.offset; });
+    }
+    return is.eof();
+}
+
+/* ============================================================================================= */
+// Run-to-run comparison
+/* ============================================================================================= */
+/// Match instructions of a kernel of two runs
+static vector<SlmInsDiff> MatchInstructions(const SlmKernelProfile& base, const SlmKernelProfile& current)
+{
+    auto hasSource = [](const SlmKernelProfile& kernel)
+    {
+        return std::any_of(kernel.instructions.begin(), kernel.instructions.end(),
+                           [](const SlmInsProfile& ins) { return ins.sourceLine != 0; });
+    };
+    bool useSource = hasSource(base) && hasSource(current);
+
+    // Key of an instruction: source line (if used), signature and order among instructions with the same line
+    // and signature. Instructions are visited in the order of offsets, which is preserved by recompilation
+    using Key = tuple<uint32_t, uint64_t, uint32_t>;
+    auto makeKeys = [useSource](const SlmKernelProfile& kernel)
+    {
+        map<pair<uint32_t, uint64_t>, uint32_t> ordinals;
+        vector<Key>                             keys;
+        for (const SlmInsProfile& ins : kernel.instructions)
+        {
+            uint32_t line = useSource ? ins.sourceLine : 0;
+            keys.emplace_back(line, ins.signature, ordinals[make_pair(line, ins.signature)]++);
+        }
+        return keys;
+    };
+    vector<Key> baseKeys    = makeKeys(base);
+    vector<Key> currentKeys = makeKeys(current);
+
+    map<Key, uint32_t> unmatched;   // Key -> index of the base instruction
+    for (uint32_t i = 0; i != baseKeys.size(); i++)
+    {
+        unmatched.emplace(baseKeys[i], i);
+    }
+    vector<bool>       isBaseMatched(base.instructions.size(), false);
+    vector<SlmInsDiff> diffs;
+    for (uint32_t i = 0; i != currentKeys.size(); i++)
+    {
+        auto it = unmatched.find(currentKeys[i]);
+        if (it == unmatched.end())
+        {
+            diffs.push_back(SlmInsDiff{nullptr, &current.instructions[i], false});
+            continue;
+        }
+        isBaseMatched[it->second] = true;
+        diffs.push_back(SlmInsDiff{&base.instructions[it->second], &current.instructions[i], false});
+        unmatched.erase(it);
+    }
+    for (uint32_t i = 0; i != base.instructions.size(); i++)
+    {
+        if (!isBaseMatched[i])
+        {
+            diffs.push_back(SlmInsDiff{&base.instructions[i], nullptr, false});
+        }
+    }
+    return diffs;
+}
+
+vector<SlmKernelDiff> CompareProfiles(const vector<SlmKernelProfile>& base, const vector<SlmKernelProfile>& current,
+                                      const SlmDiffThresholds& thresholds)
+{
+    map<string, SlmKernelDiff> kernels;
+    for (const SlmKernelProfile& kernel : base)
+    {
+        kernels.emplace(kernel.name, SlmKernelDiff{kernel.name, &kernel, nullptr, {}, false});
+    }
+    for (const SlmKernelProfile& kernel : current)
+    {
+        kernels.emplace(kernel.name, SlmKernelDiff{kernel.name, nullptr, nullptr, {}, false}).first->second.current = &kernel;
+    }
+
+    vector<SlmKernelDiff> diffs;
+    for (auto& entry : kernels)
+    {
+        SlmKernelDiff& diff = entry.second;
+        if ((diff.base != nullptr) && (diff.current != nullptr))
+        {
+            SlmInsCost baseCost    = KernelCost(*diff.base);
+            SlmInsCost currentCost = KernelCost(*diff.current);
+            diff.isRegressed  = ExceedsThreshold(StallCyclesPerExecution(baseCost), StallCyclesPerExecution(currentCost),
+                                                 thresholds.kernelPercent);
+            diff.instructions = MatchInstructions(*diff.base, *diff.current);
+            for (SlmInsDiff& ins : diff.instructions)
+            {
+                if ((thresholds.insPercent == 0) || (ins.base == nullptr) || (ins.current == nullptr)) { continue; }
+                ins.isRegressed  = ExceedsThreshold(StallCyclesPerExecution(ins.base->cost),
+                                                    StallCyclesPerExecution(ins.current->cost), thresholds.insPercent);
+                diff.isRegressed = diff.isRegressed || ins.isRegressed;
+            }
+        }
+        else
+        {
+            // Instructions of a kernel present in one run only are reported as added or removed
+            const SlmKernelProfile& kernel = (diff.base != nullptr) ? *diff.base : *diff.current;
+            for (const SlmInsProfile& ins : kernel.instructions)
+            {
+                diff.instructions.push_back(SlmInsDiff{(diff.base != nullptr) ? &ins : nullptr,
+                                                       (diff.current != nullptr) ? &ins : nullptr, false});
+            }
+        }
+
+        // Order of instructions: the increase of stall cycles, descending
+        auto delta = [&diff](const SlmInsDiff& ins)
+        {
+            double baseCycles    = (ins.base == nullptr) ? 0 : double(ScaledStallCycles(*diff.base, *ins.base));
+            double currentCycles = (ins.current == nullptr) ? 0 : double(ScaledStallCycles(*diff.current, *ins.current));
+            return currentCycles - baseCycles;
+        };
+        std::stable_sort(diff.instructions.begin(), diff.instructions.end(),
+                         [&delta](const SlmInsDiff& lhs, const SlmInsDiff& rhs) { return delta(lhs) > delta(rhs); });
+        diffs.push_back(std::move(diff));
+    }
+    return diffs;
+}
+
+void WriteDiffJson(const vector<SlmKernelDiff>& diffs, ostream& os)
+{
+    bool isRegressed = std::any_of(diffs.begin(), diffs.end(), [](const SlmKernelDiff& diff) { return diff.isRegressed; });
+    os << "{\n  \"regressed\": " << (isRegressed ? "true" : "false") << ",\n  \"kernels\": [";
+    const char* sep = "";
+    for (const SlmKernelDiff& diff : diffs)
+    {
+        os << sep << "\n    {\"name\": ";
+        WriteJsonString(diff.name, os);
+        os << ", \"status\": \"" << DiffStatus(diff.base, diff.current) << "\"";
+        double stallsPerAccess[2] = {0, 0};
+        const SlmKernelProfile* kernels[2] = {diff.base, diff.current};
+        const char* prefixes[2] = {"base", "new"};
+        for (uint32_t run = 0; run != 2; run++)
+        {
+            if (kernels[run] == nullptr) { continue; }
+            SlmInsCost cost = KernelCost(*kernels[run]);
+            stallsPerAccess[run] = StallCyclesPerExecution(cost);
+            os << ", \"" << prefixes[run] << "_accesses\": " << cost.numAccesses << ", \"" << prefixes[run]
+               << "_stall_cycles\": " << uint64_t(std::llround(double(cost.StallCycles()) * kernels[run]->samplingScale))
+               << ", \"" << prefixes[run] << "_stall_cycles_per_access\": " << stallsPerAccess[run];
+        }
+        if ((diff.base != nullptr) && (diff.current != nullptr))
+        {
+            WriteChange(stallsPerAccess[0], stallsPerAccess[1], os);
+        }
+        os << ", \"regressed\": " << (diff.isRegressed ? "true" : "false") << "}";
+        sep = ",";
+    }
+
+    os << "\n  ],\n  \"instructions\": [";
+    sep = "";
+    for (const SlmKernelDiff& diff : diffs)
+    {
+        for (const SlmInsDiff& ins : diff.instructions)
+        {
+            const SlmInsProfile* profile = (ins.current != nullptr) ? ins.current : ins.base;
+            os << sep << "\n    {\"kernel\": ";
+            WriteJsonString(diff.name, os);
+            os << ", \"status\": \"" << DiffStatus(ins.base, ins.current) << "\"";
+            if (profile->sourceLine != 0) { os << ", \"source_line\": " << profile->sourceLine; }
+            os << ", \"signature\": \"" << std::hex << profile->signature << std::dec << "\"";
+
+            double                  stallsPerExecution[2] = {0, 0};
+            const SlmInsProfile*    runs[2]     = {ins.base, ins.current};
+            const SlmKernelProfile* kernels[2]  = {diff.base, diff.current};
+            const char*             prefixes[2] = {"base", "new"};
+            for (uint32_t run = 0; run != 2; run++)
+            {
+                if (runs[run] == nullptr) { continue; }
+                const SlmInsProfile& runIns = *runs[run];
+                stallsPerExecution[run] = StallCyclesPerExecution(runIns.cost);
+                os << ", \"" << prefixes[run] << "_offset\": " << runIns.offset
+                   << ", \"" << prefixes[run] << "_average_degree\": " << runIns.AverageDegree()
+                   << ", \"" << prefixes[run] << "_max_degree\": " << runIns.MaxDegree()
+                   << ", \"" << prefixes[run] << "_stall_cycles\": " << ScaledStallCycles(*kernels[run], runIns)
+                   << ", \"" << prefixes[run] << "_stall_cycles_per_execution\": " << stallsPerExecution[run];
+            }
+            if ((ins.base != nullptr) && (ins.current != nullptr))
+            {
+                WriteChange(stallsPerExecution[0], stallsPerExecution[1], os);
+            }
+            os << ", \"regressed\": " << (ins.isRegressed ? "true" : "false") << "}";
+            sep = ",";
+        }
+    }
+    os << "\n  ]\n}\n";
+}
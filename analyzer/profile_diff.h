@@ -0,0 +1,131 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Run-to-run comparison of SLM bank conflicts: conflict profiles of analyzed runs are stored in files, and
+ *       instructions of two runs are matched by source lines and message signatures rather than by offsets, which
+ *       change between builds of a kernel
+ */
+
+#ifndef PROFILE_DIFF_H_
+#define PROFILE_DIFF_H_
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "hotspots.h"
+#include "source_report.h"
+
+/*!
+ * @return Signature of the memory instruction: attributes of its message that do not depend on the placement of
+ *         the instruction in the kernel binary
+ */
+uint64_t MemInsSignature(const MemTracePackedMemIns& memIns);
+
+/* ============================================================================================= */
+// Struct SlmInsProfile
+/* ============================================================================================= */
+/*!
+ * Conflict profile of a SEND instruction
+ */
+struct SlmInsProfile
+{
+    uint32_t            offset      = 0;    ///< Instruction offset
+    uint32_t            sourceLine  = 0;    ///< Source line, counted from 1, or 0 if unknown
+    uint64_t            signature   = 0;    ///< Message signature (see MemInsSignature), or 0 if unknown
+    SlmInsCost          cost;               ///< Bank cycles of the instruction
+    ConflictHistogram   histogram;          ///< Histogram of conflict degrees
+
+    /// @return Average number of bank cycles of an access in degrees: conflict-free accesses take one cycle
+    double AverageDegree() const;
+
+    /// @return Max conflict degree of accesses in bank cycles: conflict-free accesses take one cycle. 0 - no accesses
+    uint32_t MaxDegree() const;
+};
+
+/* ============================================================================================= */
+// Struct SlmKernelProfile
+/* ============================================================================================= */
+/*!
+ * Conflict profile of a kernel in an analyzed run
+ */
+struct SlmKernelProfile
+{
+    std::string                 name;               ///< Kernel name
+    std::string                 bankModel;          ///< Name of the SLM bank model
+    double                      samplingScale = 1;  ///< Factor that scales dynamic counts to full-run estimates
+    std::vector<SlmInsProfile>  instructions;       ///< Instructions sorted by offset
+
+    /*!
+     * Build the profile from bank cycles and histograms of the kernel
+     * @param kernel  Results of the analysis of the kernel
+     * @param source  Source lines and assembly of the kernel, or nullptr if not available
+     */
+    static SlmKernelProfile FromCosts(const SlmKernelCosts& kernel, const SourceAsmIndex* source);
+};
+
+/*!
+ * Write conflict profiles of kernels in the text format. The file starts with the "slm_profile <version>" line;
+ * each kernel is described by "kernel", "bank_model" and "sampling_scale" lines, followed by a line per instruction:
+ * ins <offset> <source line> <signature> <bbl> <executions> <lanes> <cycles> <min cycles> <degree>:<count>,...
+ */
+void WriteProfiles(const std::vector<SlmKernelProfile>& kernels, std::ostream& os);
+
+/*!
+ * Read conflict profiles written by WriteProfiles()
+ * @return false if the input is not a conflict profile of a supported version
+ */
+bool ReadProfiles(std::istream& is, std::vector<SlmKernelProfile>& kernels);
+
+/* ============================================================================================= */
+// Run-to-run comparison
+/* ============================================================================================= */
+/*!
+ * Thresholds of regressions: relative increases of stall cycles per SLM access of a kernel, or per execution of an
+ * instruction, that fail the comparison
+ */
+struct SlmDiffThresholds
+{
+    double  kernelPercent   = 5;    ///< Threshold of kernels in percent
+    double  insPercent      = 0;    ///< Threshold of instructions in percent, 0 - instructions are not checked
+};
+
+/// Instruction of two runs. Instructions present in one run only have no counterpart in the other
+struct SlmInsDiff
+{
+    const SlmInsProfile*    base;           ///< Instruction of the base run, or nullptr if added
+    const SlmInsProfile*    current;        ///< Instruction of the new run, or nullptr if removed
+    bool                    isRegressed;    ///< Stall cycles per execution exceed the threshold
+};
+
+/// Kernel of two runs
+struct SlmKernelDiff
+{
+    std::string                 name;           ///< Kernel name
+    const SlmKernelProfile*     base;           ///< Kernel of the base run, or nullptr if added
+    const SlmKernelProfile*     current;        ///< Kernel of the new run, or nullptr if removed
+    std::vector<SlmInsDiff>     instructions;   ///< Instructions, sorted by the increase of stall cycles
+    bool                        isRegressed;    ///< Stall cycles per access, or of any instruction, exceed the threshold
+};
+
+/*!
+ * Compare conflict profiles of two runs. Kernels are matched by names. Instructions of a kernel are matched by the
+ * source line, signature and order among instructions with the same line and signature if both runs have source
+ * lines, and by the signature and order among instructions with the same signature otherwise
+ * @return Kernels of both runs, sorted by name
+ */
+std::vector<SlmKernelDiff> CompareProfiles(const std::vector<SlmKernelProfile>& base,
+                                           const std::vector<SlmKernelProfile>& current, const SlmDiffThresholds& thresholds);
+
+/*!
+ * Write the comparison in JSON format: { "regressed": <bool>, "kernels": [...], "instructions": [...] }.
+ * Stall cycles are full-run estimates of sampled runs
+ */
+void WriteDiffJson(const std::vector<SlmKernelDiff>& diffs, std::ostream& os);
+
+#endif
@@ -0,0 +1,357 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file SLM bank conflict analyzer: computes per-instruction conflict degree histograms
+ *       directly from memorytrace_compressed.bin files produced by the Localmemorytrace tool
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "analysis_cache.h"
+#include "bank_conflicts.h"
+#include "batch_analysis.h"
+#include "hotspots.h"
+#include "parallel_trace.h"
+#include "profile_diff.h"
+#include "trace_reader.h"
+#include "trace_sampling.h"
+
+using namespace std;
+
+static void PrintUsage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 << " [-nb <number of banks>] [-model <SLM bank model>] [-grf <GRF size in bytes>] [-unique]"
+                                 " [-o <output JSON file>] [-hotspots <JSON file>] [-top <N>] [-kernel <name>] [-threads <N>]"
+                                 " [-slice <id>] [-subslice <id>] [-eu <id>] [-sampling <file>] [-profile <file>] [-source <file>]"
+                                 " [-cache <directory>] {<trace file>... | -dir <profile directory>}\n"
+         << "  -nb        Number of SLM banks. Overrides the number of banks of the bank model, required with -unique\n"
+         << "  -model     SLM bank model: " << SlmBankConfig::ModelNames() << " (default - auto)\n"
+         << "             auto - the model of the platform, selected by the GRF size\n"
+         << "  -grf       Size of the GRF register in bytes (default - detected from the trace file)\n"
+         << "  -unique    Count each distinct access pattern once instead of weighting it by the number of occurrences\n"
+         << "             in -nb 4-byte banks. Not supported with -model and -hotspots\n"
+         << "  -o         File that receives the results (default - standard output)\n"
+         << "  -hotspots  File that receives the ranking of instructions and BBLs by estimated stall cycles\n"
+         << "  -top       Max number of instructions and BBLs in the ranking (default - all)\n"
+         << "  -kernel    Kernel name reported in the ranking and the conflict profile (default - name of the kernel\n"
+         << "             directory of the first trace file, or its path). Required with -profile for trace files outside\n"
+         << "             kernel directories, since slm_compare matches kernels of profiles by name\n"
+         << "  -threads   Number of threads that analyze trace files with the thread index, or all trace files with -dir\n"
+         << "             (default - 1, 0 - number of hardware threads). Not supported with -unique\n"
+         << "  -slice     Analyze threads of the specified slice only. Requires the thread index\n"
+         << "  -subslice  Analyze threads of the specified subslice only. Requires the thread index\n"
+         << "  -eu        Analyze threads of the specified EU only. Requires the thread index\n"
+         << "  -sampling  Sampling parameters of the traces (" << MEMTRACE_SAMPLING_FILE_NAME << " of the kernel).\n"
+         << "             The ranking reports full-run estimates of dynamic counts of sampled traces\n"
+         << "  -profile   File that receives the conflict profile of the run, compared with profiles of other runs by\n"
+         << "             slm_compare. Not supported with -unique\n"
+         << "  -source    Source lines and assembly of the kernel printed by the cl_debug_info sample of PTI, or the\n"
+         << "             assembly (" << MEMTRACE_ASM_FILE_NAME << " of the kernel). Source lines of instructions are stored\n"
+         << "             in the conflict profile. Requires -profile\n"
+         << "  -cache     Directory of cached analyses of trace files, keyed by the hash of each file. Distinct access\n"
+         << "             patterns of a file are cached separately from its histograms, so that the analysis with other\n"
+         << "             bank parameters maps cached patterns to banks without reading the trace. Not supported with -unique\n"
+         << "  -dir       Analyze trace files of all kernels and dispatches in the profile directory, and write the\n"
+         << "             ranking of hotspots of all kernels to the output file. Sampling files of kernels are applied.\n"
+         << "             Not supported with trace files, -unique, -hotspots, -kernel, -sampling and -source\n";
+}
+
+/// Write conflict profiles of kernels to the file. @return Exit code
+static int StoreProfiles(const vector<SlmKernelCosts>& kernels, const SourceAsmIndex* source, const string& profilePath)
+{
+    vector<SlmKernelProfile> profiles;
+    for (const SlmKernelCosts& kernel : kernels)
+    {
+        profiles.push_back(SlmKernelProfile::FromCosts(kernel, source));
+    }
+    ofstream os(profilePath);
+    if (!os)
+    {
+        cerr << "SLM_BANK_ANALYZER: Could not create file " << profilePath << endl;
+        return EXIT_FAILURE;
+    }
+    WriteProfiles(profiles, os);
+    return EXIT_SUCCESS;
+}
+
+/// Analyze all kernels of the profile directory and write the ranking of their hotspots. @return Exit code
+static int AnalyzeProfileDir(const string& profileDir, const string& modelName, uint32_t numBanks,
+                             const MemTraceThreadFilter& filter, uint32_t numThreads, uint32_t maxHotspots,
+                             const string& outPath, const string& profilePath, const AnalysisCache* cache)
+{
+    vector<KernelTraceFiles> kernels;
+    string                   error;
+    if (!FindKernelTraces(profileDir, kernels, error))
+    {
+        cerr << "SLM_BANK_ANALYZER: " << error << endl;
+        return EXIT_FAILURE;
+    }
+    if (kernels.empty())
+    {
+        cerr << "SLM_BANK_ANALYZER: No trace files found in " << profileDir << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Trace files of all kernels and dispatches share the pool
+    TaskPool               pool(numThreads);
+    vector<SlmKernelCosts> results;
+    if (!AnalyzeKernelTraces(kernels, modelName, numBanks, filter, pool, cache, results, error))
+    {
+        cerr << "SLM_BANK_ANALYZER: " << error << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!profilePath.empty() && (StoreProfiles(results, nullptr, profilePath) != EXIT_SUCCESS))
+    {
+        return EXIT_FAILURE;
+    }
+    if (outPath.empty())
+    {
+        WriteHotspotsJson(results, maxHotspots, cout);
+        return EXIT_SUCCESS;
+    }
+    ofstream os(outPath);
+    if (!os)
+    {
+        cerr << "SLM_BANK_ANALYZER: Could not create file " << outPath << endl;
+        return EXIT_FAILURE;
+    }
+    WriteHotspotsJson(results, maxHotspots, os);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, const char* argv[])
+{
+    uint32_t        numBanks    = 0;
+    uint32_t        grfSize     = 0;
+    bool            countUnique = false;
+    uint32_t        maxHotspots = 0;
+    uint32_t        numThreads  = 1;
+    string          modelName;
+    string          outPath;
+    string          hotspotsPath;
+    string          kernelName;
+    string          samplingPath;
+    string          profileDir;
+    string          profilePath;
+    string          sourcePath;
+    string          cacheDir;
+    vector<string>  tracePaths;
+    MemTraceThreadFilter filter;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "-nb") && hasValue)               { numBanks     = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-model") && hasValue)       { modelName    = argv[++i]; }
+        else if (!strcmp(argv[i], "-grf") && hasValue)         { grfSize      = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-o") && hasValue)           { outPath      = argv[++i]; }
+        else if (!strcmp(argv[i], "-hotspots") && hasValue)    { hotspotsPath = argv[++i]; }
+        else if (!strcmp(argv[i], "-top") && hasValue)         { maxHotspots  = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-kernel") && hasValue)      { kernelName   = argv[++i]; }
+        else if (!strcmp(argv[i], "-threads") && hasValue)     { numThreads   = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-slice") && hasValue)       { filter.sliceId    = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-subslice") && hasValue)    { filter.subSliceId = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-eu") && hasValue)          { filter.euId       = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-sampling") && hasValue)    { samplingPath = argv[++i]; }
+        else if (!strcmp(argv[i], "-profile") && hasValue)     { profilePath  = argv[++i]; }
+        else if (!strcmp(argv[i], "-source") && hasValue)      { sourcePath   = argv[++i]; }
+        else if (!strcmp(argv[i], "-cache") && hasValue)       { cacheDir     = argv[++i]; }
+        else if (!strcmp(argv[i], "-dir") && hasValue)         { profileDir   = argv[++i]; }
+        else if (!strcmp(argv[i], "-unique"))                  { countUnique  = true; }
+        else if (argv[i][0] != '-')                            { tracePaths.emplace_back(argv[i]); }
+        else
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    bool isBatch = !profileDir.empty();
+    if ((tracePaths.empty() != isBatch) ||
+        (countUnique && (!modelName.empty() || !hotspotsPath.empty() || (numThreads != 1) || isBatch)) ||
+        (countUnique && ((numBanks == 0) || !profilePath.empty() || !cacheDir.empty())) || (!sourcePath.empty() && profilePath.empty()) ||
+        (isBatch && (!hotspotsPath.empty() || !kernelName.empty() || !samplingPath.empty() || !sourcePath.empty())))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!isBatch && kernelName.empty())
+    {
+        kernelName = KernelNameOfTraceFile(tracePaths.front());
+        if (kernelName.empty() && !profilePath.empty())
+        {
+            cerr << "SLM_BANK_ANALYZER: -kernel is required with -profile for trace files outside kernel directories" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (modelName.empty())
+    {
+        modelName = "auto";
+    }
+    unique_ptr<AnalysisCache> cache(cacheDir.empty() ? nullptr : new AnalysisCache(cacheDir));
+    if (isBatch)
+    {
+        return AnalyzeProfileDir(profileDir, modelName, numBanks, filter, numThreads, maxHotspots, outPath, profilePath,
+                                 cache.get());
+    }
+
+    MemTraceSampling sampling;
+    if (!samplingPath.empty() && !sampling.Load(samplingPath))
+    {
+        cerr << "SLM_BANK_ANALYZER: Could not read the sampling file " << samplingPath << endl;
+        return EXIT_FAILURE;
+    }
+    SourceAsmIndex source;
+    if (!sourcePath.empty() && !source.Load(sourcePath))
+    {
+        cerr << "SLM_BANK_ANALYZER: " << source.Error() << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Accesses of all trace files (dispatches) of the kernel are folded into histograms of the bank model.
+    // The "unique" mode collects distinct access patterns instead
+    BankConflictAnalyzer                   analyzer(numBanks, countUnique);
+    unique_ptr<ConflictHistogramCollector> collector;
+    unique_ptr<TaskPool>                   pool;
+    vector<MemTraceBblInfo>                bbls;
+    for (const string& path : tracePaths)
+    {
+        if (cache)
+        {
+            unique_ptr<ConflictHistogramCollector> fileCollector;
+            vector<MemTraceBblInfo>                fileBbls;
+            string                                 error;
+            if (!pool && (numThreads != 1))
+            {
+                pool.reset(new TaskPool(numThreads));
+            }
+            if (!cache->Analyze(path, modelName, numBanks, grfSize, filter, pool.get(), fileCollector, fileBbls, error))
+            {
+                cerr << "SLM_BANK_ANALYZER: " << error << endl;
+                return EXIT_FAILURE;
+            }
+            if (!collector)
+            {
+                collector = std::move(fileCollector);
+                bbls      = std::move(fileBbls);
+                continue;
+            }
+            collector->Merge(*fileCollector);
+            continue;
+        }
+
+        MemTraceFileReader reader(grfSize);
+        if (!reader.Open(path))
+        {
+            cerr << "SLM_BANK_ANALYZER: " << reader.Error() << endl;
+            return EXIT_FAILURE;
+        }
+        if (!countUnique && !collector)
+        {
+            // The "auto" model depends on the GRF size, which is known once the first trace file is open
+            SlmBankConfig bankConfig;
+            if (!SlmBankConfig::FromName(modelName, reader.GrfSize(), bankConfig))
+            {
+                cerr << "SLM_BANK_ANALYZER: Unknown SLM bank model " << modelName << endl;
+                return EXIT_FAILURE;
+            }
+            if (numBanks != 0)
+            {
+                bankConfig.numBanks = numBanks;
+            }
+            if (!bankConfig.IsValid())
+            {
+                cerr << "SLM_BANK_ANALYZER: Invalid number of SLM banks " << bankConfig.numBanks << endl;
+                return EXIT_FAILURE;
+            }
+            collector.reset(new ConflictHistogramCollector(bankConfig));
+            bbls = reader.Bbls();
+        }
+        if (!filter.IsEmpty() && !reader.HasIndex())
+        {
+            cerr << "SLM_BANK_ANALYZER: " << path << ": the file has no thread index, which is required to select threads"
+                 << endl;
+            return EXIT_FAILURE;
+        }
+
+        // Files with the thread index are analyzed by parallel readers of thread shares. Collectors of the shares
+        // are merged, so the results do not depend on the number of threads
+        if ((numThreads != 1) && reader.HasIndex())
+        {
+            if (!pool)
+            {
+                pool.reset(new TaskPool(numThreads));
+            }
+            ConflictHistogramCollector         shareCollector(collector->BankModel().Config());
+            vector<ConflictHistogramCollector> shareCollectors(pool->NumWorkers(), shareCollector);
+            vector<MemTraceVisitor*>           visitors;
+            for (ConflictHistogramCollector& share : shareCollectors) { visitors.push_back(&share); }
+
+            string error;
+            if (!ProcessThreadsParallel(reader, reader.SelectThreads(filter), *pool, visitors, error))
+            {
+                cerr << "SLM_BANK_ANALYZER: " << error << endl;
+                return EXIT_FAILURE;
+            }
+            for (const ConflictHistogramCollector& share : shareCollectors) { collector->Merge(share); }
+            continue;
+        }
+
+        MemTraceVisitor& visitor = collector ? static_cast<MemTraceVisitor&>(*collector) : analyzer;
+        if (!(filter.IsEmpty() ? reader.Process(visitor) : reader.ProcessThreads(visitor, reader.SelectThreads(filter))))
+        {
+            cerr << "SLM_BANK_ANALYZER: " << reader.Error() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    ConflictResults results = collector ? collector->Results() : analyzer.Results();
+    if (outPath.empty())
+    {
+        WriteJson(results, cout);
+    }
+    else
+    {
+        ofstream os(outPath);
+        if (!os)
+        {
+            cerr << "SLM_BANK_ANALYZER: Could not create file " << outPath << endl;
+            return EXIT_FAILURE;
+        }
+        WriteJson(results, os);
+    }
+
+    if (hotspotsPath.empty() && profilePath.empty())
+    {
+        return EXIT_SUCCESS;
+    }
+    vector<SlmKernelCosts> kernels{SlmKernelCosts(kernelName.empty() ? tracePaths.front() : kernelName, *collector)};
+    kernels.front().samplingScale = sampling.Scale();
+    kernels.front().AddInstructions(bbls);
+    if (!profilePath.empty() && (StoreProfiles(kernels, sourcePath.empty() ? nullptr : &source, profilePath) != EXIT_SUCCESS))
+    {
+        return EXIT_FAILURE;
+    }
+    if (!hotspotsPath.empty())
+    {
+        ofstream os(hotspotsPath);
+        if (!os)
+        {
+            cerr << "SLM_BANK_ANALYZER: Could not create file " << hotspotsPath << endl;
+            return EXIT_FAILURE;
+        }
+        WriteHotspotsJson(kernels, maxHotspots, os);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Run-to-run comparison of SLM bank conflicts: compares conflict profiles of two runs written by
+ *       slm_bank_analyzer -profile, and fails if stall cycles regressed. Intended as a gate of CI pipelines
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "profile_diff.h"
+
+using namespace std;
+
+#define EXIT_REGRESSION 2   ///< Exit code of the comparison that found a regression
+
+static void PrintUsage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 << " [-threshold <percent>] [-ins-threshold <percent>] [-o <output JSON file>]"
+                                 " <base profile> <new profile>\n"
+         << "  -threshold      Max increase of stall cycles per SLM access of a kernel, in percent (default - 5)\n"
+         << "  -ins-threshold  Max increase of stall cycles per execution of an instruction, in percent\n"
+         << "                  (default - 0, instructions are not checked)\n"
+         << "  -o              File that receives the comparison (default - standard output)\n"
+         << "Exit code: 0 - no regressions, " << EXIT_REGRESSION << " - stall cycles regressed, other - error\n";
+}
+
+/// Read conflict profiles from the file. @return false if the file could not be read
+static bool LoadProfiles(const string& path, vector<SlmKernelProfile>& kernels)
+{
+    ifstream is(path);
+    if (!is || !ReadProfiles(is, kernels))
+    {
+        cerr << "SLM_COMPARE: Could not read the conflict profile " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, const char* argv[])
+{
+    SlmDiffThresholds   thresholds;
+    string              outPath;
+    vector<string>      profilePaths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "-threshold") && hasValue)            { thresholds.kernelPercent = strtod(argv[++i], nullptr); }
+        else if (!strcmp(argv[i], "-ins-threshold") && hasValue)   { thresholds.insPercent    = strtod(argv[++i], nullptr); }
+        else if (!strcmp(argv[i], "-o") && hasValue)               { outPath                  = argv[++i]; }
+        else if (argv[i][0] != '-')                                { profilePaths.emplace_back(argv[i]); }
+        else
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((profilePaths.size() != 2) || (thresholds.kernelPercent < 0) || (thresholds.insPercent < 0))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    vector<SlmKernelProfile> base;
+    vector<SlmKernelProfile> current;
+    if (!LoadProfiles(profilePaths[0], base) || !LoadProfiles(profilePaths[1], current))
+    {
+        return EXIT_FAILURE;
+    }
+    for (const SlmKernelProfile& kernel : current)
+    {
+        for (const SlmKernelProfile& baseKernel : base)
+        {
+            if ((baseKernel.name == kernel.name) && (baseKernel.bankModel != kernel.bankModel))
+            {
+                cerr << "SLM_COMPARE: Kernel " << kernel.name << " was analyzed with different SLM bank models: "
+                     << baseKernel.bankModel << " and " << kernel.bankModel << endl;
+            }
+        }
+    }
+
+    vector<SlmKernelDiff> diffs = CompareProfiles(base, current, thresholds);
+    if (outPath.empty())
+    {
+        WriteDiffJson(diffs, cout);
+    }
+    else
+    {
+        ofstream os(outPath);
+        if (!os)
+        {
+            cerr << "SLM_COMPARE: Could not create file " << outPath << endl;
+            return EXIT_FAILURE;
+        }
+        WriteDiffJson(diffs, os);
+    }
+
+    bool isRegressed = false;
+    for (const SlmKernelDiff& diff : diffs)
+    {
+        if (!diff.isRegressed) { continue; }
+        cerr << "SLM_COMPARE: Stall cycles of kernel " << diff.name << " regressed" << endl;
+        isRegressed = true;
+    }
+    return isRegressed ? EXIT_REGRESSION : EXIT_SUCCESS;
+}
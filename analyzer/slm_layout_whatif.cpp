@@ -0,0 +1,137 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file What-if analysis of SLM layouts: replays SLM accesses of memorytrace_compressed.bin files through
+ *       candidate row paddings, XOR swizzles and bank counts, and ranks the candidates by estimated stall cycles
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layout_whatif.h"
+#include "trace_reader.h"
+
+using namespace std;
+
+static void PrintUsage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 << " [-nb <number of banks>] [-model <SLM bank model>] [-grf <GRF size in bytes>]"
+                                 " [-pitch <bytes>] [-c <candidate>]... [-o <output JSON file>] <trace file>...\n"
+         << "  -nb        Number of SLM banks of the baseline (default - banks of the bank model)\n"
+         << "  -model     SLM bank model: " << SlmBankConfig::ModelNames() << " (default - auto)\n"
+         << "  -grf       Size of the GRF register in bytes (default - detected from the trace file)\n"
+         << "  -pitch     Add standard candidates for an array with rows of the specified size: paddings of one\n"
+         << "             and two bank words and the XOR swizzle\n"
+         << "  -c         Candidate layout, may be repeated\n"
+         << "  -o         File that receives the ranking (default - standard output)\n"
+         << SlmLayoutCandidate::SpecUsage();
+}
+
+int main(int argc, const char* argv[])
+{
+    uint32_t                    numBanks    = 0;
+    uint32_t                    grfSize     = 0;
+    uint32_t                    rowPitch    = 0;
+    string                      modelName   = "auto";
+    string                      outPath;
+    vector<SlmLayoutCandidate>  candidates;
+    vector<string>              tracePaths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool               hasValue = (i + 1 < argc);
+        SlmLayoutCandidate candidate;
+        if (!strcmp(argv[i], "-nb") && hasValue)                { numBanks  = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-model") && hasValue)        { modelName = argv[++i]; }
+        else if (!strcmp(argv[i], "-grf") && hasValue)          { grfSize   = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-pitch") && hasValue)        { rowPitch  = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-o") && hasValue)            { outPath   = argv[++i]; }
+        else if (!strcmp(argv[i], "-c") && hasValue)
+        {
+            if (!SlmLayoutCandidate::Parse(argv[++i], candidate))
+            {
+                cerr << "SLM_LAYOUT_WHATIF: Invalid candidate layout " << argv[i] << endl;
+                return EXIT_FAILURE;
+            }
+            candidates.push_back(candidate);
+        }
+        else if (argv[i][0] != '-')                             { tracePaths.emplace_back(argv[i]); }
+        else
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (tracePaths.empty() || ((rowPitch == 0) && candidates.empty()))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // All candidates are evaluated in a single pass over the trace files (dispatches) of the kernel
+    unique_ptr<SlmLayoutSimulator> simulator;
+    for (const string& path : tracePaths)
+    {
+        MemTraceFileReader reader(grfSize);
+        if (!reader.Open(path))
+        {
+            cerr << "SLM_LAYOUT_WHATIF: " << reader.Error() << endl;
+            return EXIT_FAILURE;
+        }
+        if (!simulator)
+        {
+            // The "auto" model depends on the GRF size, which is known once the first trace file is open
+            SlmBankConfig bankConfig;
+            if (!SlmBankConfig::FromName(modelName, reader.GrfSize(), bankConfig))
+            {
+                cerr << "SLM_LAYOUT_WHATIF: Unknown SLM bank model " << modelName << endl;
+                return EXIT_FAILURE;
+            }
+            if (numBanks != 0)
+            {
+                bankConfig.numBanks = numBanks;
+            }
+            if (!bankConfig.IsValid())
+            {
+                cerr << "SLM_LAYOUT_WHATIF: Invalid number of SLM banks " << bankConfig.numBanks << endl;
+                return EXIT_FAILURE;
+            }
+            if (rowPitch != 0)
+            {
+                vector<SlmLayoutCandidate> standard = SlmLayoutCandidate::Standard(rowPitch, bankConfig.bankWidth);
+                candidates.insert(candidates.begin(), standard.begin(), standard.end());
+            }
+            simulator.reset(new SlmLayoutSimulator(bankConfig, candidates));
+        }
+        if (!reader.Process(*simulator))
+        {
+            cerr << "SLM_LAYOUT_WHATIF: " << reader.Error() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (outPath.empty())
+    {
+        simulator->WriteJson(cout);
+    }
+    else
+    {
+        ofstream os(outPath);
+        if (!os)
+        {
+            cerr << "SLM_LAYOUT_WHATIF: Could not create file " << outPath << endl;
+            return EXIT_FAILURE;
+        }
+        simulator->WriteJson(os);
+    }
+    return EXIT_SUCCESS;
+}
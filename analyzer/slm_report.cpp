@@ -0,0 +1,97 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Report of SLM bank conflicts: joins conflict results of slm_bank_analyzer or of the online analysis with
+ *       the source and assembly of the kernel, and writes a paginated HTML report
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "source_report.h"
+
+using namespace std;
+
+static void PrintUsage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 << " {-source <source asm file> | -asm <assembly file>} -conflicts <JSON file>"
+                                 " -kernel <name> [-page <lines>] [-o <output directory>]\n"
+         << "  -source    Source lines and assembly of the kernel printed by the cl_debug_info sample of PTI\n"
+         << "  -asm       Assembly of the kernel (" << MEMTRACE_ASM_FILE_NAME << " of the kernel), used when the source\n"
+         << "             is not available\n"
+         << "  -conflicts Conflict results of instructions: the output of slm_bank_analyzer, or memorytrace_conflicts.json\n"
+         << "  -kernel    Kernel name, used in names of report files\n"
+         << "  -page      Max number of source (or assembly) lines of a page of the report (default - 1000, 0 - all)\n"
+         << "  -o         Directory that receives the report (default - current directory)\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    uint32_t    linesPerPage = 1000;
+    string      sourcePath;
+    string      asmPath;
+    string      conflictsPath;
+    string      kernelName;
+    string      outDir;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+        if (!strcmp(argv[i], "-source") && hasValue)           { sourcePath    = argv[++i]; }
+        else if (!strcmp(argv[i], "-asm") && hasValue)         { asmPath       = argv[++i]; }
+        else if (!strcmp(argv[i], "-conflicts") && hasValue)   { conflictsPath = argv[++i]; }
+        else if (!strcmp(argv[i], "-kernel") && hasValue)      { kernelName    = argv[++i]; }
+        else if (!strcmp(argv[i], "-page") && hasValue)        { linesPerPage  = (uint32_t)strtoul(argv[++i], nullptr, 0); }
+        else if (!strcmp(argv[i], "-o") && hasValue)           { outDir        = argv[++i]; }
+        else
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((sourcePath.empty() == asmPath.empty()) || conflictsPath.empty() || kernelName.empty())
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ConflictPercentResults conflicts;
+    ifstream               is(conflictsPath);
+    if (!is || !ReadConflictsJson(is, conflicts))
+    {
+        cerr << "SLM_REPORT: Could not read conflict results from " << conflictsPath << endl;
+        return EXIT_FAILURE;
+    }
+
+    SourceAsmIndex index;
+    if (!index.Load(sourcePath.empty() ? asmPath : sourcePath))
+    {
+        cerr << "SLM_REPORT: " << index.Error() << endl;
+        return EXIT_FAILURE;
+    }
+    if (!sourcePath.empty() && !index.HasSource())
+    {
+        cerr << "SLM_REPORT: " << sourcePath << ": no source lines found, the report shows the assembly only" << endl;
+    }
+
+    vector<string> pages;
+    string         error;
+    if (!WriteSourceReport(index, conflicts, kernelName, linesPerPage, outDir, pages, error))
+    {
+        cerr << "SLM_REPORT: " << error << endl;
+        return EXIT_FAILURE;
+    }
+    for (const string& page : pages)
+    {
+        cout << page << "\n";
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,520 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the source-level report of SLM bank conflicts
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+#include "mapped_file.h"
+#include "source_report.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// @return true if the character is a hexadecimal digit
+static bool IsHexDigit(char c)
+{
+    return isxdigit((unsigned char)c) != 0;
+}
+
+/*!
+ * Parse the instruction offset at the beginning of the line: "0x<hex>", or "<hex>:"
+ * @return false if the line does not start with an instruction offset
+ */
+static bool ParseAsmOffset(const char* line, const char* lineEnd, uint32_t& offset)
+{
+    bool        hasPrefix = (lineEnd - line > 2) && (line[0] == '0') && ((line[1] == 'x') || (line[1] == 'X'));
+    const char* digits    = hasPrefix ? (line + 2) : line;
+    const char* end       = digits;
+    uint64_t    value     = 0;
+    while ((end != lineEnd) && IsHexDigit(*end) && (value <= UINT32_MAX))
+    {
+        value = (value << 4) | uint64_t(isdigit((unsigned char)*end) ? (*end - '0') : (tolower((unsigned char)*end) - 'a' + 10));
+        ++end;
+    }
+    if ((end == digits) || (value > UINT32_MAX))
+    {
+        return false;
+    }
+    bool isDelimited = (end == lineEnd) || (*end == ':') || (hasPrefix && ((*end == ' ') || (*end == '\t')));
+    if (!isDelimited)
+    {
+        return false;
+    }
+    offset = uint32_t(value);
+    return true;
+}
+
+/// Write the text with HTML special characters escaped
+static void WriteHtmlText(const char* text, size_t size, ostream& os)
+{
+    const char* run = text; // Beginning of the run of characters that are written as is
+    for (const char* p = text; p != text + size; ++p)
+    {
+        const char* entity;
+        switch (*p)
+        {
+        case '&':   entity = "&amp;";   break;
+        case '<':   entity = "&lt;";    break;
+        case '>':   entity = "&gt;";    break;
+        case '"':   entity = "&quot;";  break;
+        default:    continue;
+        }
+        os.write(run, p - run);
+        os << entity;
+        run = p + 1;
+    }
+    os.write(run, (text + size) - run);
+}
+
+static void WriteHtmlText(const string& text, ostream& os)
+{
+    WriteHtmlText(text.data(), text.size(), os);
+}
+
+/// Conflict state of an instruction or a source line
+enum class ConflictState
+{
+    UNKNOWN,        ///< No conflict results
+    NO_CONFLICTS,   ///< All accesses are conflict-free
+    CONFLICTS       ///< Some accesses have conflicts
+};
+
+/// @return Conflict state of the instruction
+static ConflictState InstructionState(const ConflictPercents& percents)
+{
+    for (const auto& bin : percents)
+    {
+        if ((bin.first != 0) && (bin.second != 0)) { return ConflictState::CONFLICTS; }
+    }
+    return ConflictState::NO_CONFLICTS;
+}
+
+/// @return CSS class attribute of elements in the specified state
+static const char* StateClass(ConflictState state)
+{
+    switch (state)
+    {
+    case ConflictState::CONFLICTS:      return " class=\"conflict\"";
+    case ConflictState::NO_CONFLICTS:   return " class=\"noconflict\"";
+    default:                            return "";
+    }
+}
+
+/// Write the summary of conflict degrees of the instruction, e.g. "  degree 2 - 12.5%, degree 4 - 3%;"
+static void WriteConflictSummary(const ConflictPercents& percents, ostream& os)
+{
+    if (InstructionState(percents) == ConflictState::NO_CONFLICTS)
+    {
+        os << "  no conflicts;";
+        return;
+    }
+    const char* sep = "  ";
+    for (const auto& bin : percents)
+    {
+        if (bin.first == 0) { continue; }
+        os << sep << "degree " << bin.first << " - " << bin.second << "%";
+        sep = ", ";
+    }
+    os << ";";
+}
+
+/// Write conflict results of the instructions in JSON format, as the "conflicts" field of the page data
+static void WriteConflictsData(const vector<uint32_t>& offsets, const ConflictPercentResults& conflicts, ostream& os)
+{
+    os << "\"conflicts\":{";
+    const char* sep = "";
+    for (uint32_t offset : offsets)
+    {
+        auto it = conflicts.find(offset);
+        if (it == conflicts.end()) { continue; }
+        os << sep << "\"" << offset << "\":[";
+        const char* binSep = "";
+        for (const auto& bin : it->second)
+        {
+            os << binSep << "[" << bin.first << "," << bin.second << "]";
+            binSep = ",";
+        }
+        os << "]";
+        sep = ",";
+    }
+    os << "}";
+}
+
+/// @return File name of the page of the report, counted from 1
+static string PageFileName(const string& kernelName, uint32_t page)
+{
+    return "report_" + kernelName + ((page == 1) ? string() : ("_" + to_string(page))) + ".html";
+}
+
+/// @return Path of the file in the directory
+static string JoinPath(const string& dir, const string& name)
+{
+    return dir.empty() ? name : (dir + "/" + name);
+}
+
+/// Write the head of the page, up to the beginning of the body
+static void WritePageHead(const string& kernelName, uint32_t page, uint32_t numPages, bool hasSource, ostream& os)
+{
+    os << "<!DOCTYPE html>\n<html>\n  <head>\n    <meta charset=\"utf-8\">\n    <title>SLM bank conflicts of ";
+    WriteHtmlText(kernelName, os);
+    os << " - page " << page << " of " << numPages << "</title>\n"
+       << "    <style>\n"
+       << "      .conflict {background-color: lightcoral;}\n"
+       << "      .noconflict {background-color: lightgreen;}\n"
+       << "      .active {outline: 2px solid darkorange;}\n"
+       << "      pre {margin: 0;}\n";
+    if (hasSource)
+    {
+        os << "      #sourcecol {height: 650px; width: 50%; float:left; outline: 1px solid grey; overflow: scroll;}\n"
+           << "      #asmcol {height: 650px; width: 50%; float:right; outline: 1px solid grey; overflow: scroll;}\n";
+    }
+    else
+    {
+        os << "      #asmcol {height: 650px; outline: 1px solid grey; overflow: scroll;}\n";
+    }
+    os << "    </style>\n";
+}
+
+/// Write the script that highlights instructions of the selected line using the data section of the page
+static void WritePageScript(ostream& os)
+{
+    os << "    <script>\n"
+       << "      var data = JSON.parse(document.getElementById(\"data\").textContent);\n"
+       << "      function selectLine(line) {\n"
+       << "        for (var elem of Array.from(document.querySelectorAll(\".active\"))) {\n"
+       << "          elem.classList.remove(\"active\");\n"
+       << "        }\n"
+       << "        document.getElementById(\"s\" + line).classList.add(\"active\");\n"
+       << "        for (var offset of (data.lines[line] || [])) {\n"
+       << "          var elem = document.getElementById(\"a\" + offset);\n"
+       << "          if (elem) {\n"
+       << "            elem.classList.add(\"active\");\n"
+       << "            elem.scrollIntoView({block: \"nearest\"});\n"
+       << "          }\n"
+       << "        }\n"
+       << "      }\n"
+       << "    </script>\n";
+}
+
+/// Write links to other pages of the report
+static void WritePageLinks(const string& kernelName, uint32_t page, uint32_t numPages, ostream& os)
+{
+    if (numPages == 1) { return; }
+    auto link = [&](uint32_t target, const char* text)
+    {
+        if ((target == page) || (target == 0) || (target > numPages))
+        {
+            os << " " << text;
+            return;
+        }
+        os << " <a href=\"";
+        WriteHtmlText(PageFileName(kernelName, target), os);
+        os << "\">" << text << "</a>";
+    };
+    os << "    <p>Page " << page << " of " << numPages << ":";
+    link(1, "first");
+    link(page - 1, "previous");
+    link(page + 1, "next");
+    link(numPages, "last");
+    os << "</p>\n";
+}
+
+/// Write the assembly line of the instruction with its conflict state and the summary of its conflict degrees
+static void WriteAsmLine(const SourceAsmIndex& index, const SourceAsmIndex::AsmLine& asmLine,
+                         const ConflictPercentResults& conflicts, ostream& os)
+{
+    auto          it    = conflicts.find(asmLine.offset);
+    ConflictState state = (it == conflicts.end()) ? ConflictState::UNKNOWN : InstructionState(it->second);
+    os << "      <pre id=\"a" << asmLine.offset << "\"" << StateClass(state) << ">";
+    WriteHtmlText(index.Data(asmLine.text), asmLine.text.size, os);
+    if (it != conflicts.end())
+    {
+        WriteConflictSummary(it->second, os);
+    }
+    os << "</pre>\n";
+}
+
+/* ============================================================================================= */
+// ReadConflictsJson implementation
+/* ============================================================================================= */
+bool ReadConflictsJson(istream& is, ConflictPercentResults& results)
+{
+    results.clear();
+    string      text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+    const char* p = text.c_str();
+
+    auto skipBlanks = [&]() { while (isspace((unsigned char)*p)) { ++p; } };
+    auto expect     = [&](char c) { skipBlanks(); if (*p != c) { return false; } ++p; return true; };
+    auto peek       = [&](char c) { skipBlanks(); return *p == c; };
+    auto number     = [&](double& value)
+    {
+        skipBlanks();
+        char* end;
+        value = strtod(p, &end);
+        if (end == p) { return false; }
+        p = end;
+        return true;
+    };
+
+    if (!expect('{')) { return false; }
+    while (!peek('}'))
+    {
+        if (!results.empty() && !expect(',')) { return false; }
+        double offset;
+        if (!expect('"') || !number(offset) || !expect('"') || !expect(':') || !expect('[') ||
+            (offset < 0) || (offset > UINT32_MAX))
+        {
+            return false;
+        }
+        ConflictPercents& percents = results[uint32_t(offset)];
+        while (!peek(']'))
+        {
+            double degree;
+            double percent;
+            if ((!percents.empty() && !expect(',')) ||
+                !expect('[') || !number(degree) || !expect(',') || !number(percent) || !expect(']') || (degree < 0))
+            {
+                return false;
+            }
+            percents.emplace_back(uint32_t(degree), percent);
+        }
+        ++p; // ']'
+    }
+    ++p; // '}'
+    skipBlanks();
+    return *p == '\0';
+}
+
+/* ============================================================================================= */
+// SourceAsmIndex implementation
+/* ============================================================================================= */
+const uint32_t SourceAsmIndex::NO_SOURCE_LINE;
+
+SourceAsmIndex::SourceAsmIndex() = default;
+SourceAsmIndex::~SourceAsmIndex() = default;
+
+bool SourceAsmIndex::Load(const string& path)
+{
+    _file.reset(new MappedFile);
+    _data = nullptr;
+    _sourceLines.clear();
+    _lineEnds.clear();
+    _lineOffsets.clear();
+    _instructions.clear();
+    if (!_file->Map(path))
+    {
+        _error = path + ": could not read the file";
+        return false;
+    }
+    _data = _file->Data();
+
+    const char* fileEnd = _data + _file->Size();
+    for (const char* line = _data; line < fileEnd; )
+    {
+        const char* lineEnd  = std::find(line, fileEnd, '\n');
+        const char* next     = (lineEnd == fileEnd) ? fileEnd : (lineEnd + 1);
+        if ((lineEnd != line) && (lineEnd[-1] == '\r')) { --lineEnd; }
+
+        if ((line != lineEnd) && (*line == '['))
+        {
+            // Source line "[<line>] <text>". Its instructions follow it
+            const char* text = std::find(line, lineEnd, ']');
+            text = (text == lineEnd) ? (line + 1) : (text + 1);
+            _sourceLines.push_back(TextRange{uint64_t(text - _data), uint32_t(lineEnd - text)});
+            _lineEnds.push_back((uint32_t)_lineOffsets.size());
+        }
+        else
+        {
+            const char* text = line;
+            while ((text != lineEnd) && ((*text == ' ') || (*text == '\t'))) { ++text; }
+            uint32_t offset;
+            if (ParseAsmOffset(text, lineEnd, offset))
+            {
+                uint32_t sourceLine = _sourceLines.empty() ? NO_SOURCE_LINE : uint32_t(_sourceLines.size() - 1);
+                _instructions.push_back(AsmLine{offset, sourceLine, TextRange{uint64_t(text - _data), uint32_t(lineEnd - text)}});
+                if (!_sourceLines.empty())
+                {
+                    _lineOffsets.push_back(offset);
+                    _lineEnds.back() = (uint32_t)_lineOffsets.size();
+                }
+            }
+        }
+        line = next;
+    }
+    if (_instructions.empty())
+    {
+        _error = path + ": no assembly lines found";
+        return false;
+    }
+
+    // An instruction listed under several source lines is shown once, at its first line in the file
+    std::stable_sort(_instructions.begin(), _instructions.end(),
+                     [](const AsmLine& lhs, const AsmLine& rhs) { return lhs.offset < rhs.offset; });
+    _instructions.erase(std::unique(_instructions.begin(), _instructions.end(),
+                                    [](const AsmLine& lhs, const AsmLine& rhs) { return lhs.offset == rhs.offset; }),
+                        _instructions.end());
+    return true;
+}
+
+const SourceAsmIndex::AsmLine* SourceAsmIndex::FindInstruction(uint32_t offset) const
+{
+    auto it = std::lower_bound(_instructions.begin(), _instructions.end(), offset,
+                               [](const AsmLine& asmLine, uint32_t value) { return asmLine.offset < value; });
+    return ((it == _instructions.end()) || (it->offset != offset)) ? nullptr : &*it;
+}
+
+/* ============================================================================================= */
+// WriteSourceReport implementation
+/* ============================================================================================= */
+bool WriteSourceReport(const SourceAsmIndex& index, const ConflictPercentResults& conflicts, const string& kernelName,
+                       uint32_t linesPerPage, const string& outDir, vector<string>& pages, string& error)
+{
+    bool     hasSource  = index.HasSource();
+    uint32_t numLines   = hasSource ? index.NumSourceLines() : (uint32_t)index.Instructions().size();
+    if (linesPerPage == 0)
+    {
+        linesPerPage = std::max(numLines, 1u);
+    }
+    uint32_t numPages = std::max((numLines + linesPerPage - 1) / linesPerPage, 1u);
+
+    // Conflict state of each source line: the most severe state of its instructions
+    vector<ConflictState> lineStates(hasSource ? numLines : 0, ConflictState::UNKNOWN);
+    for (uint32_t line = 0; line != lineStates.size(); line++)
+    {
+        SourceAsmIndex::OffsetRange offsets = index.SourceLineOffsets(line);
+        for (const uint32_t* offset = offsets.first; offset != offsets.second; ++offset)
+        {
+            auto it = conflicts.find(*offset);
+            if (it != conflicts.end())
+            {
+                lineStates[line] = std::max(lineStates[line], InstructionState(it->second));
+            }
+        }
+    }
+
+    pages.clear();
+    for (uint32_t page = 1; page <= numPages; page++)
+    {
+        uint32_t lineBegin = (page - 1) * linesPerPage;
+        uint32_t lineEnd   = std::min(lineBegin + linesPerPage, numLines);
+        string   path      = JoinPath(outDir, PageFileName(kernelName, page));
+        ofstream os(path);
+        if (!os)
+        {
+            error = "Could not create file " + path;
+            return false;
+        }
+
+        // Instructions shown on the page: instructions of its source lines, or its range of assembly lines
+        vector<uint32_t> offsets;
+        for (uint32_t line = lineBegin; line != lineEnd; line++)
+        {
+            if (hasSource)
+            {
+                SourceAsmIndex::OffsetRange lineOffsets = index.SourceLineOffsets(line);
+                offsets.insert(offsets.end(), lineOffsets.first, lineOffsets.second);
+            }
+            else
+            {
+                offsets.push_back(index.Instructions()[line].offset);
+            }
+        }
+        std::sort(offsets.begin(), offsets.end());
+        offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+        WritePageHead(kernelName, page, numPages, hasSource, os);
+        os << "    <script id=\"data\" type=\"application/json\">{\"lines\":{";
+        const char* sep = "";
+        for (uint32_t line = lineBegin; hasSource && (line != lineEnd); line++)
+        {
+            SourceAsmIndex::OffsetRange lineOffsets = index.SourceLineOffsets(line);
+            if (lineOffsets.first == lineOffsets.second) { continue; }
+            os << sep << "\"" << (line + 1) << "\":[";
+            const char* offsetSep = "";
+            for (const uint32_t* offset = lineOffsets.first; offset != lineOffsets.second; ++offset)
+            {
+                os << offsetSep << *offset;
+                offsetSep = ",";
+            }
+            os << "]";
+            sep = ",";
+        }
+        os << "},";
+        WriteConflictsData(offsets, conflicts, os);
+        os << "}</script>\n";
+        WritePageScript(os);
+        os << "  </head>\n  <body>\n"
+           << "    <h1>The Tool for analyzing conflicts in GPU localmemory banks</h1>\n"
+           << "    <h3>Report for ";
+        WriteHtmlText(kernelName, os);
+        os << "</h3>\n";
+        WritePageLinks(kernelName, page, numPages, os);
+
+        if (hasSource)
+        {
+            // Source lines with conflicts are listed on the first page, with links to their pages
+            if ((page == 1) && (numPages != 1))
+            {
+                os << "    <p>Lines with conflicts:";
+                for (uint32_t line = 0; line != numLines; line++)
+                {
+                    if (lineStates[line] != ConflictState::CONFLICTS) { continue; }
+                    os << " <a href=\"";
+                    WriteHtmlText(PageFileName(kernelName, line / linesPerPage + 1), os);
+                    os << "#s" << (line + 1) << "\">" << (line + 1) << "</a>";
+                }
+                os << "</p>\n";
+            }
+
+            os << "    <div id=\"sourcecol\">\n";
+            for (uint32_t line = lineBegin; line != lineEnd; line++)
+            {
+                SourceAsmIndex::TextRange text = index.SourceLine(line);
+                os << "      <pre id=\"s" << (line + 1) << "\"" << StateClass(lineStates[line])
+                   << " onclick=\"selectLine(" << (line + 1) << ")\">" << (line + 1) << "\t";
+                WriteHtmlText(index.Data(text), text.size, os);
+                if (lineStates[line] == ConflictState::CONFLICTS)
+                {
+                    os << "  Conflicts!";
+                }
+                else if (lineStates[line] == ConflictState::NO_CONFLICTS)
+                {
+                    os << "  No conflicts!";
+                }
+                os << "</pre>\n";
+            }
+            os << "    </div>\n";
+        }
+
+        os << "    <div id=\"asmcol\">\n";
+        for (uint32_t offset : offsets)
+        {
+            const SourceAsmIndex::AsmLine* asmLine = index.FindInstruction(offset);
+            if (asmLine != nullptr)
+            {
+                WriteAsmLine(index, *asmLine, conflicts, os);
+            }
+        }
+        os << "    </div>\n  </body>\n</html>\n";
+        if (!os.flush())
+        {
+            error = "Could not write file " + path;
+            return false;
+        }
+        pages.push_back(path);
+    }
+    return true;
+}
@@ -0,0 +1,131 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Source-level report of SLM bank conflicts: conflict results of SEND instructions are joined with source lines
+ *       and assembly of the kernel, and written as a paginated HTML report
+ */
+
+#ifndef SOURCE_REPORT_H_
+#define SOURCE_REPORT_H_
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+#define MEMTRACE_ASM_FILE_NAME "memorytrace_asm.txt"    ///< Assembly text of the kernel stored in the kernel directory
+
+/// Conflict degree -> percent of accesses of an instruction with this degree
+using ConflictPercents = std::vector<std::pair<uint32_t, double>>;
+
+/// Instruction offset -> conflict degrees of the instruction
+using ConflictPercentResults = std::map<uint32_t, ConflictPercents>;
+
+/*!
+ * Read conflict results in the format of WriteJson(): { "<offset>": [[degree, percent], ...], ... }
+ * @return false if the input is not in this format
+ */
+bool ReadConflictsJson(std::istream& is, ConflictPercentResults& results);
+
+/* ============================================================================================= */
+// Class SourceAsmIndex
+/* ============================================================================================= */
+/*!
+ * Index of the source and assembly text of a kernel, built in a single pass over the mapped file.
+ * Two formats are recognized:
+ *  - Output of the cl_debug_info sample of PTI: source lines start with '[', and are followed by tab-indented
+ *    assembly lines of the instructions generated for them
+ *  - Assembly text of the kernel without source lines, as stored by the Localmemorytrace tool
+ *    in memorytrace_asm.txt
+ * Assembly lines are those starting with the instruction offset: "0x<hex>" or "<hex>:", after optional blanks
+ */
+class SourceAsmIndex
+{
+public:
+    /// Part of the text of the file
+    struct TextRange
+    {
+        uint64_t    begin;  ///< Offset in the file
+        uint32_t    size;   ///< Size in bytes, not including the end of line
+    };
+
+    static const uint32_t NO_SOURCE_LINE = UINT32_MAX;  ///< Source line of instructions without the source
+
+    /// Assembly line of an instruction
+    struct AsmLine
+    {
+        uint32_t    offset;     ///< Instruction offset
+        uint32_t    sourceLine; ///< First source line of the instruction, counted from 0, or NO_SOURCE_LINE
+        TextRange   text;       ///< Text of the line, without leading blanks
+    };
+
+    /// Range of offsets of instructions of a source line
+    using OffsetRange = std::pair<const uint32_t*, const uint32_t*>;
+
+    SourceAsmIndex();
+    ~SourceAsmIndex();
+
+    /*!
+     * Map the file and build the index
+     * @return false if the file could not be read, or contains no assembly lines
+     */
+    bool Load(const std::string& path);
+
+    const std::string&          Error()             const { return _error; }            ///< Description of the error
+    bool                        HasSource()         const { return !_sourceLines.empty(); }
+    uint32_t                    NumSourceLines()    const { return (uint32_t)_sourceLines.size(); }
+    const std::vector<AsmLine>& Instructions()      const { return _instructions; }     ///< Sorted by offset
+
+    /// @return Text of the source line, counted from 0, without its "[<line>]" prefix
+    TextRange SourceLine(uint32_t line) const { return _sourceLines[line]; }
+
+    /// @return Offsets of instructions of the source line, counted from 0, in the order of the file
+    OffsetRange SourceLineOffsets(uint32_t line) const
+    {
+        return OffsetRange(_lineOffsets.data() + (line == 0 ? 0 : _lineEnds[line - 1]), _lineOffsets.data() + _lineEnds[line]);
+    }
+
+    /// @return Assembly line of the instruction at the specified offset, or nullptr if there is no such instruction
+    const AsmLine* FindInstruction(uint32_t offset) const;
+
+    /// @return Pointer to the text range of the mapped file
+    const char* Data(const TextRange& text) const { return _data + text.begin; }
+
+private:
+    std::unique_ptr<MappedFile> _file;          ///< Mapped file
+    const char*                 _data = nullptr;///< Contents of the mapped file
+    std::vector<TextRange>      _sourceLines;   ///< Source lines in the order of the file
+    std::vector<uint32_t>       _lineEnds;      ///< Source line -> end of its offsets in _lineOffsets
+    std::vector<uint32_t>       _lineOffsets;   ///< Offsets of instructions grouped by source lines
+    std::vector<AsmLine>        _instructions;  ///< Distinct instructions sorted by offset
+    std::string                 _error;         ///< Description of the error
+};
+
+/*!
+ * Write the HTML report of the kernel. The report is split into pages of the specified number of source lines,
+ * or of assembly lines if the index has no source. Each page contains only the assembly of its source lines, and
+ * a JSON data section with instruction offsets of the source lines and conflict results of these instructions,
+ * from which the page highlights instructions of the selected line.
+ * The first page is report_<kernel>.html, other pages are report_<kernel>_<page>.html, counted from 1
+ * @param[in]  index         Index of the source and assembly of the kernel
+ * @param[in]  conflicts     Conflict results of SEND instructions of the kernel
+ * @param[in]  kernelName    Kernel name
+ * @param[in]  linesPerPage  Max number of lines of a page
+ * @param[in]  outDir        Directory that receives the report
+ * @param[out] pages         Paths of written pages
+ * @param[out] error         Description of the error
+ * @return false if a page could not be written
+ */
+bool WriteSourceReport(const SourceAsmIndex& index, const ConflictPercentResults& conflicts, const std::string& kernelName,
+                       uint32_t linesPerPage, const std::string& outDir, std::vector<std::string>& pages, std::string& error);
+
+#endif
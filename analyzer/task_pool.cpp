@@ -0,0 +1,130 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the work-stealing pool of worker threads
+ */
+
+#include <algorithm>
+
+#include "task_pool.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// TaskPool implementation
+/* ============================================================================================= */
+TaskPool::TaskPool(uint32_t numWorkers) : _nextQueue(0)
+{
+    if (numWorkers == 0)
+    {
+        numWorkers = std::max(thread::hardware_concurrency(), 1u);
+    }
+    for (uint32_t i = 0; i != numWorkers; i++)
+    {
+        _queues.emplace_back(new WorkerQueue);
+    }
+    for (uint32_t i = 0; i != numWorkers; i++)
+    {
+        _workers.emplace_back(&TaskPool::Run, this, i);
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    Wait();
+    {
+        lock_guard<mutex> lock(_mutex);
+        _isStopped = true;
+    }
+    _taskQueued.notify_all();
+    for (thread& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void TaskPool::Submit(Task task)
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        ++_queuedTasks;
+        ++_pendingTasks;
+    }
+
+    WorkerQueue& queue = *_queues[_nextQueue++ % _queues.size()];
+    {
+        lock_guard<mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    _taskQueued.notify_one();
+}
+
+void TaskPool::Wait()
+{
+    unique_lock<mutex> lock(_mutex);
+    _allTasksDone.wait(lock, [this] { return (_pendingTasks == 0); });
+}
+
+bool TaskPool::TakeTask(uint32_t workerId, Task& task)
+{
+    // Take the most recently queued task from the own queue
+    {
+        WorkerQueue& queue = *_queues[workerId];
+        lock_guard<mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task from another worker's queue
+    for (uint32_t i = 1; i != _queues.size(); i++)
+    {
+        WorkerQueue& queue = *_queues[(workerId + i) % _queues.size()];
+        lock_guard<mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::Run(uint32_t workerId)
+{
+    for (;;)
+    {
+        Task task;
+        if (TakeTask(workerId, task))
+        {
+            {
+                lock_guard<mutex> lock(_mutex);
+                --_queuedTasks;
+            }
+            task(workerId);
+
+            lock_guard<mutex> lock(_mutex);
+            if (--_pendingTasks == 0)
+            {
+                _allTasksDone.notify_all();
+            }
+            continue;
+        }
+
+        // Sleep until a task is queued. A queued task may be not yet visible in the queues, so recheck them after waking up
+        unique_lock<mutex> lock(_mutex);
+        _taskQueued.wait(lock, [this] { return (_queuedTasks != 0) || _isStopped; });
+        if (_isStopped && (_queuedTasks == 0))
+        {
+            return;
+        }
+    }
+}
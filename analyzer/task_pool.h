@@ -0,0 +1,78 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Work-stealing pool of worker threads
+ */
+
+#ifndef TASK_POOL_H_
+#define TASK_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* ============================================================================================= */
+// Class TaskPool
+/* ============================================================================================= */
+/*!
+ * Pool of worker threads that execute submitted tasks. Each worker owns a task queue: it takes tasks from
+ * the back of its own queue and, when the queue is empty, steals tasks from the front of other workers' queues
+ */
+class TaskPool
+{
+public:
+    /// Task function. The argument is the index of the worker that executes the task, in range [0, NumWorkers())
+    using Task = std::function<void(uint32_t)>;
+
+    /// @param numWorkers  Number of worker threads. If 0, the number of hardware threads is used
+    explicit TaskPool(uint32_t numWorkers);
+    ~TaskPool();
+
+    /// Queue the task for execution
+    void Submit(Task task);
+
+    /// Wait until all submitted tasks are complete
+    void Wait();
+
+    uint32_t NumWorkers() const { return (uint32_t)_workers.size(); }
+
+private:
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator = (const TaskPool&) = delete;
+
+    /// Main function of the worker thread
+    void Run(uint32_t workerId);
+
+    /// Take a task from the worker's own queue, or steal it from another worker's queue
+    bool TakeTask(uint32_t workerId, Task& task);
+
+    /// Task queue of a worker
+    struct WorkerQueue
+    {
+        std::mutex          mutex;
+        std::deque<Task>    tasks;
+    };
+
+private:
+    std::vector<std::unique_ptr<WorkerQueue>>   _queues;                ///< Per-worker task queues
+    std::vector<std::thread>                    _workers;               ///< Worker threads
+    std::atomic<uint32_t>                       _nextQueue;             ///< Queue that receives the next submitted task
+    uint64_t                                    _queuedTasks = 0;       ///< Number of tasks in queues
+    uint64_t                                    _pendingTasks = 0;      ///< Number of queued or running tasks
+    bool                                        _isStopped = false;     ///< The pool is being destroyed
+    std::mutex                                  _mutex;                 ///< Protects the counters and _isStopped
+    std::condition_variable                     _taskQueued;            ///< Signaled when a task is queued or the pool stops
+    std::condition_variable                     _allTasksDone;          ///< Signaled when _pendingTasks drops to 0
+};
+
+#endif
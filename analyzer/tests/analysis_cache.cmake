@@ -0,0 +1,32 @@
+############################ begin_copyright_notice ############################
+### Copyright (C) 2018-2021 Intel Corporation
+###
+### SPDX-License-Identifier: MIT
+############################ end_copyright_notice ##############################
+
+# Analyses served by the analysis cache must be identical to uncached analyses: the first analysis that fills
+# the cache, the rerun that loads cached histograms, and the analysis with another bank model that maps cached
+# access patterns to banks
+
+include ( ${CMAKE_CURRENT_LIST_DIR}/trace_test_utils.cmake )
+
+run_tool ( ${MEMTRACE_GEN} -size 2 -simd 32 -stride 8 -broadcast 0.3 -o trace.bin )
+
+foreach ( model dword gen9 )
+    run_tool ( ${SLM_BANK_ANALYZER} -model ${model} -nb 16 -kernel cached -hotspots ${model}_hotspots.json
+               -o ${model}.json trace.bin )
+    foreach ( run 1 2 )
+        run_tool ( ${SLM_BANK_ANALYZER} -model ${model} -nb 16 -kernel cached -hotspots ${model}_hotspots_${run}.json
+                   -cache cache -o ${model}_${run}.json trace.bin )
+        expect_same_files ( ${model}.json ${model}_${run}.json )
+        expect_same_files ( ${model}_hotspots.json ${model}_hotspots_${run}.json )
+    endforeach ()
+endforeach ()
+
+file ( GLOB patterns ${WORK_DIR}/cache/*.patterns )
+file ( GLOB histograms ${WORK_DIR}/cache/*.histograms )
+list ( LENGTH patterns numPatterns )
+list ( LENGTH histograms numHistograms )
+if ( NOT (numPatterns EQUAL 1 AND numHistograms EQUAL 2) )
+    message ( FATAL_ERROR "Expected 1 pattern table and 2 histograms, found ${numPatterns} and ${numHistograms}" )
+endif ()
@@ -0,0 +1,117 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Reference test of lane address extraction and conflict degrees of SLM accesses
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "bank_conflicts.h"
+
+using namespace std;
+
+static uint32_t numFailures = 0;
+
+/// Report the failed check
+static void Check(bool condition, const string& what)
+{
+    if (!condition)
+    {
+        cerr << "BANK_CONFLICTS_TEST: " << what << " failed" << endl;
+        numFailures++;
+    }
+}
+
+/// @return Descriptor of an SLM scatter instruction with the specified execution size and address width
+static MemTracePackedMemIns SlmScatter(uint32_t execSize, bool is64Bit, uint32_t channelOffset = 0)
+{
+    MemTracePackedMemIns memIns;
+    memset(&memIns, 0, sizeof(memIns));
+    memIns.isSLM         = 1;
+    memIns.isScatter     = 1;
+    memIns.addressWidth  = is64Bit ? 1 : 0;
+    memIns.simdWidth     = (execSize >= 16) ? 1 : 0;
+    memIns.execSize      = execSize;
+    memIns.channelOffset = channelOffset;
+    return memIns;
+}
+
+/// @return Conflict degree of numAddrs addresses base + i * stride in numBanks banks
+static uint32_t StrideDegree(uint32_t stride, uint32_t numAddrs, uint32_t numBanks)
+{
+    uint32_t addrs[MAX_SIMD_LANES];
+    for (uint32_t i = 0; i != numAddrs; i++) { addrs[i] = 0x100 + i * stride; }
+    return ConflictDegree(addrs, numAddrs, numBanks);
+}
+
+static void TestConflictDegree()
+{
+    // Dword strides map 16 channels to 16 / gcd(stride / 4, 16) banks
+    Check(StrideDegree(4, 16, 16) == 0,   "conflict-free stride");
+    Check(StrideDegree(8, 16, 16) == 2,   "2-way conflicts of the 8-byte stride");
+    Check(StrideDegree(16, 16, 16) == 4,  "4-way conflicts of the 16-byte stride");
+    Check(StrideDegree(64, 16, 16) == 16, "16-way conflicts of the 64-byte stride");
+    Check(StrideDegree(12, 16, 16) == 0,  "conflict-free odd dword stride");
+    Check(StrideDegree(4, 32, 16) == 2,   "SIMD32 access of 16 banks");
+    Check(StrideDegree(4, 32, 32) == 0,   "SIMD32 access of 32 banks");
+    Check(StrideDegree(1, 16, 16) == 4,   "byte stride");
+
+    // Channels that access the same address of a bank are counted as conflicts, unless all of them do
+    uint32_t addrs[MAX_SIMD_LANES] = { 0, 0, 4, 8 };
+    Check(ConflictDegree(addrs, 4, 16) == 2, "partial broadcast");
+    Check(!IsBroadcast(addrs, 4), "partial broadcast is not a broadcast");
+    Check(IsBroadcast(addrs, 2), "broadcast");
+    Check(IsBroadcast(addrs, 1), "single channel");
+}
+
+static void TestLaneAddresses()
+{
+    uint32_t payload32[MAX_SIMD_LANES];
+    uint64_t payload64[MAX_SIMD_LANES];
+    for (uint32_t lane = 0; lane != MAX_SIMD_LANES; lane++)
+    {
+        payload32[lane] = lane * 4;
+        payload64[lane] = (uint64_t(0xFF) << 32) | (lane * 8);
+    }
+    uint32_t addrs[MAX_SIMD_LANES];
+
+    // Enabled channels only, in the order of channels
+    uint32_t numAddrs = GetLaneAddresses(SlmScatter(16, false), 0xFFFF00F1, (const uint8_t*)payload32, addrs);
+    Check((numAddrs == 5) && (addrs[0] == 0) && (addrs[1] == 16) && (addrs[4] == 28), "enabled channels");
+
+    // Channels beyond the execution size are not accessed
+    numAddrs = GetLaneAddresses(SlmScatter(8, false), 0xFFFFFFFF, (const uint8_t*)payload32, addrs);
+    Check(numAddrs == 8, "channels of SIMD8");
+
+    // The instruction uses the execution mask from its channel offset
+    numAddrs = GetLaneAddresses(SlmScatter(16, false, 16), 0x00030000, (const uint8_t*)payload32, addrs);
+    Check((numAddrs == 2) && (addrs[0] == 0) && (addrs[1] == 4), "channel offset");
+
+    // SLM offsets of 64-bit addresses are their low dwords
+    numAddrs = GetLaneAddresses(SlmScatter(8, true), 0x6, (const uint8_t*)payload64, addrs);
+    Check((numAddrs == 2) && (addrs[0] == 8) && (addrs[1] == 16), "64-bit addresses");
+
+    // Block messages never cause conflicts
+    MemTracePackedMemIns blockIns = SlmScatter(16, false);
+    blockIns.isScatter = 0;
+    Check(GetLaneAddresses(blockIns, 0xFFFF, (const uint8_t*)payload32, addrs) == 0, "block message");
+}
+
+int main()
+{
+    TestConflictDegree();
+    TestLaneAddresses();
+    if (numFailures != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    cout << "BANK_CONFLICTS_TEST: passed" << endl;
+    return EXIT_SUCCESS;
+}
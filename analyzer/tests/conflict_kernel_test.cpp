@@ -0,0 +1,111 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Randomized parity test of the scalar, AVX2 and AVX-512 implementations of the conflict kernel against
+ *       IsBroadcast() and ConflictDegree()
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bank_conflicts.h"
+#include "conflict_kernel.h"
+
+using namespace std;
+
+/// Number of random accesses checked for each number of banks
+static const uint32_t NUM_ACCESSES = 2000;
+
+/// Generate a random SLM access of MAX_SIMD_LANES channels: strided, clustered in a few bank words, or random
+static void RandomAccess(mt19937& rng, uint32_t* addrs, uint32_t& laneMask)
+{
+    uint32_t base = rng() % 0x10000;
+    switch (rng() % 4)
+    {
+    case 0:
+    {
+        uint32_t stride = (rng() % 33) * 4;
+        for (uint32_t lane = 0; lane != MAX_SIMD_LANES; lane++) { addrs[lane] = base + lane * stride; }
+        break;
+    }
+    case 1:
+        for (uint32_t lane = 0; lane != MAX_SIMD_LANES; lane++) { addrs[lane] = base + (rng() % 4) * 4; }
+        break;
+    case 2:
+        for (uint32_t lane = 0; lane != MAX_SIMD_LANES; lane++) { addrs[lane] = base; }
+        break;
+    default:
+        for (uint32_t lane = 0; lane != MAX_SIMD_LANES; lane++) { addrs[lane] = rng(); }
+        break;
+    }
+    static const uint32_t laneMasks[] = { 0xFFFFFFFF, 0x0000FFFF, 0xFFFF0000, 0x000000FF, 0x00000001, 0 };
+    laneMask = (rng() % 2 == 0) ? uint32_t(rng()) : laneMasks[rng() % (sizeof(laneMasks) / sizeof(laneMasks[0]))];
+}
+
+/// @return Conflict degree of the enabled channels computed by IsBroadcast() and ConflictDegree()
+static uint32_t ReferenceDegree(const uint32_t* addrs, uint32_t laneMask, uint32_t numBanks)
+{
+    uint32_t laneAddrs[MAX_SIMD_LANES];
+    uint32_t numAddrs = 0;
+    for (uint32_t lane = 0; lane != MAX_SIMD_LANES; lane++)
+    {
+        if ((laneMask & (1u << lane)) != 0) { laneAddrs[numAddrs++] = addrs[lane]; }
+    }
+    if ((numAddrs == 0) || IsBroadcast(laneAddrs, numAddrs))
+    {
+        return CONFLICT_DEGREE_SKIPPED;
+    }
+    return ConflictDegree(laneAddrs, numAddrs, numBanks);
+}
+
+int main()
+{
+    static const ConflictKernel::Isa isas[] = { ConflictKernel::Isa::SCALAR, ConflictKernel::Isa::AVX2,
+                                                ConflictKernel::Isa::AVX512 };
+
+    // All bank counts of the specialized implementations, and a large bank count of the portable one
+    vector<uint32_t> bankCounts;
+    for (uint32_t numBanks = 1; numBanks <= 256; numBanks++) { bankCounts.push_back(numBanks); }
+    bankCounts.push_back(384);
+
+    mt19937  rng(1);
+    uint32_t addrs[MAX_SIMD_LANES];
+    uint32_t laneMask    = 0;
+    uint64_t numFailures = 0;
+    for (uint32_t numBanks : bankCounts)
+    {
+        vector<ConflictKernel> kernels;
+        for (ConflictKernel::Isa isa : isas) { kernels.emplace_back(numBanks, isa); }
+        for (uint32_t i = 0; i != NUM_ACCESSES; i++)
+        {
+            RandomAccess(rng, addrs, laneMask);
+            uint32_t expected = ReferenceDegree(addrs, laneMask, numBanks);
+            for (const ConflictKernel& kernel : kernels)
+            {
+                uint32_t degree = kernel(addrs, laneMask);
+                if ((degree != expected) && (numFailures++ < 10))
+                {
+                    cerr << "CONFLICT_KERNEL_TEST: " << ConflictKernel::IsaName(kernel.GetIsa()) << " kernel of " << numBanks
+                         << " banks returned " << degree << " instead of " << expected << " for lane mask " << hex
+                         << laneMask << dec << endl;
+                }
+            }
+        }
+    }
+    if (numFailures != 0)
+    {
+        cerr << "CONFLICT_KERNEL_TEST: " << numFailures << " mismatches" << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "CONFLICT_KERNEL_TEST: passed, instruction sets:";
+    for (ConflictKernel::Isa isa : isas) { cout << " " << ConflictKernel::IsaName(ConflictKernel(1, isa).GetIsa()); }
+    cout << endl;
+    return EXIT_SUCCESS;
+}
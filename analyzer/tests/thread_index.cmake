@@ -0,0 +1,33 @@
+############################ begin_copyright_notice ############################
+### Copyright (C) 2018-2021 Intel Corporation
+###
+### SPDX-License-Identifier: MIT
+############################ end_copyright_notice ##############################
+
+# Parallel analysis of traces with the thread index must be identical to the sequential analysis, for all threads
+# and for threads of one EU, and the analysis of all threads must be identical to that of the trace without the index
+
+include ( ${CMAKE_CURRENT_LIST_DIR}/trace_test_utils.cmake )
+
+run_tool ( ${MEMTRACE_GEN} -size 2 -simd 32 -stride 8 -broadcast 0.3 -o plain.bin )
+run_tool ( ${MEMTRACE_GEN} -size 2 -simd 32 -stride 8 -broadcast 0.3 -index -o indexed.bin )
+run_tool ( ${MEMTRACE_REPLAY} -trace -format 2 -index -o indexed_v2.bin plain.bin )
+
+# Conflict histograms and the hotspot ranking, which counts executions, of the trace file
+function ( analyze trace name )
+    run_tool ( ${SLM_BANK_ANALYZER} -model gen9 -kernel index ${ARGN} -o ${name}.json -hotspots ${name}_hotspots.json
+               ${trace}.bin )
+endfunction ()
+
+analyze ( plain plain )
+analyze ( indexed eu -eu 1 )
+foreach ( trace indexed indexed_v2 )
+    foreach ( threads 1 4 )
+        analyze ( ${trace} ${trace}_${threads} -threads ${threads} )
+        analyze ( ${trace} ${trace}_${threads}_eu -threads ${threads} -eu 1 )
+        foreach ( suffix "" _hotspots )
+            expect_same_files ( plain${suffix}.json ${trace}_${threads}${suffix}.json )
+            expect_same_files ( eu${suffix}.json ${trace}_${threads}_eu${suffix}.json )
+        endforeach ()
+    endforeach ()
+endforeach ()
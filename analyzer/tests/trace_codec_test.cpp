@@ -0,0 +1,152 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Round-trip test of the version 2 codec: records of random threads are encoded and decoded back, and the
+ *       decoded records must be identical to the encoded ones
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "trace_codec.h"
+
+using namespace std;
+
+/// Record of a thread, with addresses of analyzed channels only, as they are restored by the decoder
+struct TestRecord
+{
+    uint32_t        execMask;
+    vector<uint8_t> payload;
+};
+
+/// @return Descriptor of an SLM scatter instruction at the specified offset
+static MemTracePackedMemIns SlmScatter(uint32_t offset, uint32_t execSize, bool is64Bit, uint32_t channelOffset)
+{
+    MemTracePackedMemIns memIns;
+    memset(&memIns, 0, sizeof(memIns));
+    memIns.offset            = offset;
+    memIns.isSLM             = 1;
+    memIns.isScatter         = 1;
+    memIns.addressWidth      = is64Bit ? 1 : 0;
+    memIns.simdWidth         = (execSize >= 16) ? 1 : 0;
+    memIns.execSize          = execSize;
+    memIns.channelOffset     = channelOffset;
+    memIns.addrPayloadLength = execSize * (is64Bit ? 8 : 4) / 32;
+    return memIns;
+}
+
+/// Add the instruction and its address payload to the BBL
+static void AddInstruction(MemTraceBblInfo& bbl, const MemTracePackedMemIns& memIns)
+{
+    bbl.memInstructions.push_back(memIns);
+    bbl.payloadOffsets.push_back(bbl.payloadSize);
+    bbl.payloadSize += memIns.execSize * MemTraceAddrSize(memIns);
+}
+
+/// @return Random execution mask: a typical mask of SIMD8/16/32 code or a random mask
+static uint32_t RandomExecMask(mt19937& rng)
+{
+    static const uint32_t execMasks[] = { 0xFFFFFFFF, 0x0000FFFF, 0x000000FF, 0x00000001, 0x80000000, 0 };
+    return (rng() % 4 == 0) ? uint32_t(rng()) : execMasks[rng() % (sizeof(execMasks) / sizeof(execMasks[0]))];
+}
+
+/// @return Random record of the BBL: strided addresses with occasional exceptions and wrap-arounds
+static TestRecord RandomRecord(const MemTraceBblInfo& bbl, uint32_t execMask, mt19937& rng)
+{
+    TestRecord record;
+    record.execMask = execMask;
+    record.payload.assign(bbl.payloadSize, 0);
+    for (uint32_t i = 0; i != bbl.memInstructions.size(); i++)
+    {
+        const MemTracePackedMemIns& memIns   = bbl.memInstructions[i];
+        uint32_t                    addrSize = MemTraceAddrSize(memIns);
+        uint32_t                    laneMask = MemTraceLaneMask(memIns, record.execMask);
+        uint64_t                    base     = (addrSize == sizeof(uint64_t)) ? ((uint64_t(rng()) << 32) | rng()) : rng();
+        int64_t                     stride   = int64_t(rng() % 9) * 4 - 16;
+        for (uint32_t lane = 0; laneMask != 0; lane++, laneMask >>= 1)
+        {
+            if ((laneMask & 1) == 0) { continue; }
+            uint64_t addr = base + uint64_t(lane * stride);
+            if (rng() % 8 == 0) { addr = rng(); }
+            memcpy(record.payload.data() + bbl.payloadOffsets[i] + lane * addrSize, &addr, addrSize);
+        }
+    }
+    return record;
+}
+
+int main()
+{
+    vector<MemTraceBblInfo> bbls(2);
+    bbls[0].bblId = 0;
+    AddInstruction(bbls[0], SlmScatter(0x10, 16, false, 0));
+    AddInstruction(bbls[0], SlmScatter(0x20, 16, false, 16));
+    bbls[1].bblId = 1;
+    AddInstruction(bbls[1], SlmScatter(0x30, 32, false, 0));
+    AddInstruction(bbls[1], SlmScatter(0x40, 8, true, 0));
+
+    mt19937         rng(1);
+    MemTraceEncoder encoder;
+    MemTraceDecoder decoder;
+    for (uint32_t thread = 0; thread != 64; thread++)
+    {
+        // Records of a thread, with runs of the same BBL and execution mask
+        vector<pair<uint32_t, TestRecord>> records;
+        uint32_t numRecords = rng() % 512;
+        while (records.size() < numRecords)
+        {
+            uint32_t bblId    = rng() % bbls.size();
+            uint32_t execMask = RandomExecMask(rng);
+            for (uint32_t runLength = rng() % 8 + 1; runLength != 0; runLength--)
+            {
+                records.emplace_back(bblId, RandomRecord(bbls[bblId], execMask, rng));
+            }
+        }
+
+        encoder.BeginThread();
+        for (const auto& ref : records)
+        {
+            MemTraceRecord record = { &bbls[ref.first], ref.second.execMask, ref.second.payload.data() };
+            encoder.AddRecord(record);
+        }
+        const vector<uint8_t>& encoded = encoder.EndThread();
+
+        istringstream is(string(encoded.begin(), encoded.end()));
+        decoder.BeginThread(is, encoded.size());
+        size_t          index = 0;
+        uint32_t        runLength;
+        uint32_t        bblId;
+        uint32_t        execMask;
+        vector<uint8_t> payload;
+        while (!decoder.AtEnd() && decoder.ReadRun(runLength, bblId, execMask))
+        {
+            for (; runLength != 0; runLength--, index++)
+            {
+                payload.resize(bbls[bblId].payloadSize);
+                if ((index == records.size()) || !decoder.ReadPayload(bbls[bblId], execMask, payload.data()) ||
+                    (bblId != records[index].first) || (execMask != records[index].second.execMask) ||
+                    (payload != records[index].second.payload))
+                {
+                    cerr << "TRACE_CODEC_TEST: Record " << index << " of thread " << thread << " differs" << endl;
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        if ((index != records.size()) || !decoder.AtEnd())
+        {
+            cerr << "TRACE_CODEC_TEST: Thread " << thread << " decoded " << index << " of " << records.size() << " records"
+                 << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    cout << "TRACE_CODEC_TEST: passed" << endl;
+    return EXIT_SUCCESS;
+}
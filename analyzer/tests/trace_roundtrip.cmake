@@ -0,0 +1,26 @@
+############################ begin_copyright_notice ############################
+### Copyright (C) 2018-2021 Intel Corporation
+###
+### SPDX-License-Identifier: MIT
+############################ end_copyright_notice ##############################
+
+# Round trip of a synthetic trace through all format versions: v1 -> v2 -> v3 -> v1.
+# Conflict histograms (weighted and of distinct patterns) and hotspot rankings of all versions must be identical
+
+include ( ${CMAKE_CURRENT_LIST_DIR}/trace_test_utils.cmake )
+
+run_tool ( ${MEMTRACE_GEN} -size 2 -simd 32 -stride 8 -broadcast 0.3 -o v1.bin )
+run_tool ( ${MEMTRACE_REPLAY} -trace -format 2 -o v2.bin v1.bin )
+run_tool ( ${MEMTRACE_REPLAY} -trace -format 3 -o v3.bin v2.bin )
+run_tool ( ${MEMTRACE_REPLAY} -trace -format 1 -o v1_v3.bin v3.bin )
+
+foreach ( trace v1 v2 v3 v1_v3 )
+    run_tool ( ${SLM_BANK_ANALYZER} -nb 16 -o ${trace}.json ${trace}.bin )
+    run_tool ( ${SLM_BANK_ANALYZER} -nb 16 -unique -o ${trace}_unique.json ${trace}.bin )
+    run_tool ( ${SLM_BANK_ANALYZER} -model gen9 -kernel roundtrip -hotspots ${trace}_hotspots.json ${trace}.bin )
+    if ( NOT trace STREQUAL v1 )
+        expect_same_files ( v1.json ${trace}.json )
+        expect_same_files ( v1_unique.json ${trace}_unique.json )
+        expect_same_files ( v1_hotspots.json ${trace}_hotspots.json )
+    endif ()
+endforeach ()
@@ -0,0 +1,30 @@
+############################ begin_copyright_notice ############################
+### Copyright (C) 2018-2021 Intel Corporation
+###
+### SPDX-License-Identifier: MIT
+############################ end_copyright_notice ##############################
+
+# Helpers of the trace tests, which ctest runs in the CMake script mode:
+#   cmake -DMEMTRACE_GEN=<path> -DMEMTRACE_REPLAY=<path> -DSLM_BANK_ANALYZER=<path> -DWORK_DIR=<path> -P <test>.cmake
+# The tools run in WORK_DIR, which is emptied at the start of the test
+
+file ( REMOVE_RECURSE ${WORK_DIR} )
+file ( MAKE_DIRECTORY ${WORK_DIR} )
+
+# Run the command in WORK_DIR, fail the test if the command fails
+function ( run_tool )
+    execute_process ( COMMAND ${ARGN} WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE result
+                      OUTPUT_VARIABLE output ERROR_VARIABLE output )
+    if ( NOT result EQUAL 0 )
+        message ( FATAL_ERROR "${ARGN} failed (${result}):\n${output}" )
+    endif ()
+endfunction ()
+
+# Fail the test if the files in WORK_DIR differ
+function ( expect_same_files expected actual )
+    execute_process ( COMMAND ${CMAKE_COMMAND} -E compare_files ${expected} ${actual} WORKING_DIRECTORY ${WORK_DIR}
+                      RESULT_VARIABLE result )
+    if ( NOT result EQUAL 0 )
+        message ( FATAL_ERROR "${actual} differs from ${expected}" )
+    endif ()
+endfunction ()
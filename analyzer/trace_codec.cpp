@@ -0,0 +1,285 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the codec of per-thread trace records in the version 2 trace format
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "trace_codec.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// @return Difference (a - b) modulo 2^(8 * addrSize), sign-extended to 64 bits
+static int64_t AddrDiff(uint64_t a, uint64_t b, uint32_t addrSize)
+{
+    uint64_t diff = a - b;
+    return (addrSize == sizeof(uint64_t)) ? (int64_t)diff : (int64_t)(int32_t)(uint32_t)diff;
+}
+
+static uint64_t Zigzag(int64_t val)     { return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63); }
+static int64_t  Unzigzag(uint64_t val)  { return (int64_t)(val >> 1) ^ -(int64_t)(val & 1); }
+
+static void PutVarint(vector<uint8_t>& out, uint64_t val)
+{
+    for (; val >= 0x80; val >>= 7)
+    {
+        out.push_back(uint8_t(val) | 0x80);
+    }
+    out.push_back(uint8_t(val));
+}
+
+/*!
+ * Get analyzed channels of the specified memory instruction whose addresses fit in the instruction's payload
+ * @param[out] lanes  Array of 32 elements that receives indices of the channels
+ * @return Number of channels stored in lanes
+ */
+static uint32_t GetAnalyzedLanes(const MemTraceBblInfo& bbl, uint32_t insIndex, uint32_t execMask, uint32_t* lanes)
+{
+    const MemTracePackedMemIns& memIns = bbl.memInstructions[insIndex];
+    uint32_t payloadEnd  = (insIndex + 1 < bbl.payloadOffsets.size()) ? bbl.payloadOffsets[insIndex + 1] : bbl.payloadSize;
+    uint32_t maxLanes    = (payloadEnd - bbl.payloadOffsets[insIndex]) / MemTraceAddrSize(memIns);
+    uint32_t laneMask    = MemTraceLaneMask(memIns, execMask);
+    if (maxLanes < 32) { laneMask &= ((1u << maxLanes) - 1); }
+
+    uint32_t numLanes = 0;
+    for (uint32_t lane = 0; laneMask != 0; lane++, laneMask >>= 1)
+    {
+        if ((laneMask & 1) != 0) { lanes[numLanes++] = lane; }
+    }
+    return numLanes;
+}
+
+/* ============================================================================================= */
+// MemTraceCodecState implementation
+/* ============================================================================================= */
+uint64_t& MemTraceCodecState::PrevBase(uint32_t bblId, uint32_t insIndex)
+{
+    if (bblId >= _states.size()) { _states.resize(bblId + 1); }
+    vector<InsState>& bblStates = _states[bblId];
+    if (insIndex >= bblStates.size()) { bblStates.resize(insIndex + 1); }
+
+    InsState& state = bblStates[insIndex];
+    if (state.generation != _generation)
+    {
+        state.prevBase   = 0;
+        state.generation = _generation;
+    }
+    return state.prevBase;
+}
+
+/* ============================================================================================= */
+// MemTraceEncoder implementation
+/* ============================================================================================= */
+void MemTraceEncoder::BeginThread()
+{
+    _state.Reset();
+    _out.clear();
+    _run.clear();
+    _runLength = 0;
+}
+
+void MemTraceEncoder::AddRecord(const MemTraceRecord& record)
+{
+    if ((_runLength != 0) && ((record.bbl->bblId != _runBblId) || (record.execMask != _runExecMask)))
+    {
+        FlushRun();
+    }
+    _runBblId    = record.bbl->bblId;
+    _runExecMask = record.execMask;
+    ++_runLength;
+
+    for (uint32_t i = 0; i != record.bbl->memInstructions.size(); i++)
+    {
+        EncodeAddresses(record, i);
+    }
+}
+
+const vector<uint8_t>& MemTraceEncoder::EndThread()
+{
+    FlushRun();
+    return _out;
+}
+
+void MemTraceEncoder::FlushRun()
+{
+    if (_runLength == 0) { return; }
+
+    PutVarint(_out, _runLength);
+    PutVarint(_out, _runBblId);
+    PutVarint(_out, _runExecMask);
+    _out.insert(_out.end(), _run.begin(), _run.end());
+    _run.clear();
+    _runLength = 0;
+}
+
+void MemTraceEncoder::EncodeAddresses(const MemTraceRecord& record, uint32_t insIndex)
+{
+    uint32_t lanes[32];
+    uint32_t numLanes = GetAnalyzedLanes(*record.bbl, insIndex, record.execMask, lanes);
+    if (numLanes == 0) { return; }
+
+    const uint8_t* payload  = record.InsPayload(insIndex);
+    uint32_t       addrSize = MemTraceAddrSize(record.bbl->memInstructions[insIndex]);
+    auto loadAddr = [&](uint32_t lane) { uint64_t addr = 0; memcpy(&addr, payload + lane * addrSize, addrSize); return addr; };
+
+    // Base address, relative to the base of the previous access of the instruction
+    uint64_t  base     = loadAddr(lanes[0]);
+    uint64_t& prevBase = _state.PrevBase(record.bbl->bblId, insIndex);
+    PutVarint(_run, Zigzag(AddrDiff(base, prevBase, addrSize)));
+    prevBase = base;
+    if (numLanes == 1) { return; }
+
+    // Stride between addresses of adjacent channels, derived from the first two analyzed channels
+    int64_t span   = lanes[1] - lanes[0];
+    int64_t diff   = AddrDiff(loadAddr(lanes[1]), base, addrSize);
+    int64_t stride = ((diff % span) == 0) ? (diff / span) : 0;
+    PutVarint(_run, Zigzag(stride));
+
+    // Channels whose addresses differ from the prediction
+    uint32_t excIndices[32];
+    int64_t  excDiffs[32];
+    uint32_t numExceptions = 0;
+    for (uint32_t k = 1; k != numLanes; k++)
+    {
+        uint64_t predicted = base + (uint64_t)(lanes[k] - lanes[0]) * (uint64_t)stride;
+        int64_t  excDiff   = AddrDiff(loadAddr(lanes[k]), predicted, addrSize);
+        if (excDiff != 0)
+        {
+            excIndices[numExceptions] = k;
+            excDiffs[numExceptions]   = excDiff;
+            numExceptions++;
+        }
+    }
+    PutVarint(_run, numExceptions);
+    for (uint32_t e = 0, prevIndex = 0; e != numExceptions; prevIndex = excIndices[e++])
+    {
+        PutVarint(_run, excIndices[e] - prevIndex);
+        PutVarint(_run, Zigzag(excDiffs[e]));
+    }
+}
+
+/* ============================================================================================= */
+// MemTraceDecoder implementation
+/* ============================================================================================= */
+void MemTraceDecoder::BeginThread(istream& is, uint64_t size)
+{
+    _state.Reset();
+    _is        = &is;
+    _pos       = 0;
+    _end       = 0;
+    _remaining = size;
+}
+
+void MemTraceDecoder::Refill()
+{
+    size_t unread = _end - _pos;
+    memmove(_chunk.data(), _chunk.data() + _pos, unread);
+    _pos = 0;
+    _end = unread;
+
+    size_t readSize = (size_t)std::min<uint64_t>(_remaining, _chunk.size() - unread);
+    if (_is->read((char*)_chunk.data() + _end, readSize))
+    {
+        _end       += readSize;
+        _remaining -= readSize;
+    }
+    else
+    {
+        _remaining = 0; // Truncated file - decoding stops at the end of the data read so far
+    }
+}
+
+bool MemTraceDecoder::ReadVarint(uint64_t& val)
+{
+    if ((_end - _pos < _maxVarintSize) && (_remaining != 0))
+    {
+        Refill();
+    }
+    uint64_t result = 0;
+    for (uint32_t shift = 0; (_pos != _end) && (shift < 64); shift += 7)
+    {
+        uint8_t byte = _chunk[_pos++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            val = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MemTraceDecoder::ReadZigzag(int64_t& val)
+{
+    uint64_t encoded = 0;
+    if (!ReadVarint(encoded)) { return false; }
+    val = Unzigzag(encoded);
+    return true;
+}
+
+bool MemTraceDecoder::ReadRun(uint32_t& numRecords, uint32_t& bblId, uint32_t& execMask)
+{
+    uint64_t vals[3];
+    for (uint64_t& val : vals)
+    {
+        if (!ReadVarint(val) || (val > UINT32_MAX)) { return false; }
+    }
+    numRecords = (uint32_t)vals[0];
+    bblId      = (uint32_t)vals[1];
+    execMask   = (uint32_t)vals[2];
+    return (numRecords != 0);
+}
+
+bool MemTraceDecoder::ReadPayload(const MemTraceBblInfo& bbl, uint32_t execMask, uint8_t* payload)
+{
+    memset(payload, 0, bbl.payloadSize);
+    for (uint32_t i = 0; i != bbl.memInstructions.size(); i++)
+    {
+        uint32_t lanes[32];
+        uint32_t numLanes = GetAnalyzedLanes(bbl, i, execMask, lanes);
+        if (numLanes == 0) { continue; }
+
+        uint8_t* insPayload = payload + bbl.payloadOffsets[i];
+        uint32_t addrSize   = MemTraceAddrSize(bbl.memInstructions[i]);
+        auto storeAddr = [&](uint32_t lane, uint64_t addr) { memcpy(insPayload + lane * addrSize, &addr, addrSize); };
+
+        int64_t baseDiff = 0;
+        if (!ReadZigzag(baseDiff)) { return false; }
+        uint64_t& prevBase = _state.PrevBase(bbl.bblId, i);
+        uint64_t  base     = prevBase + (uint64_t)baseDiff;
+        if (addrSize != sizeof(uint64_t)) { base = (uint32_t)base; }
+        prevBase = base;
+        storeAddr(lanes[0], base);
+        if (numLanes == 1) { continue; }
+
+        int64_t  stride        = 0;
+        uint64_t numExceptions = 0;
+        if (!ReadZigzag(stride) || !ReadVarint(numExceptions) || (numExceptions >= numLanes)) { return false; }
+        for (uint32_t k = 1; k != numLanes; k++)
+        {
+            storeAddr(lanes[k], base + (uint64_t)(lanes[k] - lanes[0]) * (uint64_t)stride);
+        }
+        for (uint64_t e = 0, index = 0; e != numExceptions; e++)
+        {
+            uint64_t indexDelta = 0;
+            int64_t  excDiff    = 0;
+            if (!ReadVarint(indexDelta) || !ReadZigzag(excDiff) || (indexDelta == 0) || (indexDelta >= numLanes - index))
+            {
+                return false;
+            }
+            index += indexDelta;
+            uint32_t lane = lanes[index];
+            storeAddr(lane, base + (uint64_t)(lane - lanes[0]) * (uint64_t)stride + (uint64_t)excDiff);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,145 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Codec of per-thread trace records in the version 2 trace format
+ *
+ * The records of a thread are grouped into runs of consecutive records with the same (bblId, execMask):
+ *
+ *   run     = varint(numRecords), varint(bblId), varint(execMask), numRecords x record
+ *   record  = one encoded address vector per memory instruction of the BBL
+ *
+ * Channel addresses of an instruction are predicted as base + (lane - firstLane) * stride:
+ *
+ *   addrs   = nothing, if no channel is analyzed (see MemTraceLaneMask), otherwise
+ *             zigzag(base - previous base of the instruction in the thread),
+ *             [ zigzag(stride), varint(numExceptions),
+ *               numExceptions x { varint(channel index delta), zigzag(address - predicted address) } ]
+ *
+ * The bracketed part is present only if more than one channel is analyzed. The stride is derived from the first
+ * two analyzed channels, and channel indices of exceptions are counted among analyzed channels.
+ * Differences are computed modulo 2^(8 * address size) and sign-extended.
+ */
+
+#ifndef TRACE_CODEC_H_
+#define TRACE_CODEC_H_
+
+#include <istream>
+#include <vector>
+
+#include "trace_reader.h"
+
+/* ============================================================================================= */
+// Class MemTraceCodecState
+/* ============================================================================================= */
+/*!
+ * Prediction state shared by the encoder and the decoder: the last base address of each memory instruction
+ * in the current thread
+ */
+class MemTraceCodecState
+{
+public:
+    /// Forget the state of the previous thread
+    void Reset() { ++_generation; }
+
+    /// @return Reference to the last base address of the specified instruction in the current thread
+    uint64_t& PrevBase(uint32_t bblId, uint32_t insIndex);
+
+private:
+    struct InsState
+    {
+        uint64_t prevBase   = 0;
+        uint32_t generation = 0;    ///< Thread that set prevBase
+    };
+
+    std::vector<std::vector<InsState>>  _states;            ///< BBL ID -> state of each memory instruction
+    uint32_t                            _generation = 1;    ///< Current thread
+};
+
+/* ============================================================================================= */
+// Class MemTraceEncoder
+/* ============================================================================================= */
+/*!
+ * Encoder of the records of a thread
+ */
+class MemTraceEncoder
+{
+public:
+    /// Start encoding records of a new thread
+    void BeginThread();
+
+    /// Encode the record. Records must be added in the order of their appearance in the thread
+    void AddRecord(const MemTraceRecord& record);
+
+    /// Complete encoding of the thread
+    /// @return Encoded records. The data remains valid until the next call to BeginThread()
+    const std::vector<uint8_t>& EndThread();
+
+private:
+    /// Move the pending run to the output
+    void FlushRun();
+
+    /// Encode addresses of the specified memory instruction into the pending run
+    void EncodeAddresses(const MemTraceRecord& record, uint32_t insIndex);
+
+private:
+    MemTraceCodecState      _state;                 ///< Prediction state
+    std::vector<uint8_t>    _out;                   ///< Encoded records of the thread
+    std::vector<uint8_t>    _run;                   ///< Encoded records of the pending run
+    uint32_t                _runLength = 0;         ///< Number of records in the pending run
+    uint32_t                _runBblId = 0;          ///< BBL ID of the pending run
+    uint32_t                _runExecMask = 0;       ///< Execution mask of the pending run
+};
+
+/* ============================================================================================= */
+// Class MemTraceDecoder
+/* ============================================================================================= */
+/*!
+ * Streaming decoder of the records of a thread. The encoded data is read from the input stream
+ * in fixed-size chunks, so the memory usage does not depend on the size of the trace
+ */
+class MemTraceDecoder
+{
+public:
+    MemTraceDecoder() : _chunk(_chunkSize) {}
+
+    /// Start decoding records of a thread, encoded in the next size bytes of the stream
+    void BeginThread(std::istream& is, uint64_t size);
+
+    /// Read the header of the next run of records with the same BBL and execution mask
+    bool ReadRun(uint32_t& numRecords, uint32_t& bblId, uint32_t& execMask);
+
+    /*!
+     * Decode address payloads of the next record in the current run
+     * @param[in]  bbl       BBL of the run
+     * @param[in]  execMask  Execution mask of the run
+     * @param[out] payload   Buffer of bbl.payloadSize bytes that receives address payloads
+     */
+    bool ReadPayload(const MemTraceBblInfo& bbl, uint32_t execMask, uint8_t* payload);
+
+    /// @return true if all encoded data of the thread has been consumed
+    bool AtEnd() const { return (_pos == _end) && (_remaining == 0); }
+
+private:
+    /// Read more encoded data from the stream, keeping the unread data
+    void Refill();
+
+    bool ReadVarint(uint64_t& val);
+    bool ReadZigzag(int64_t& val);
+
+private:
+    static const size_t _chunkSize      = 0x10000;  ///< Size of the chunk read from the stream
+    static const size_t _maxVarintSize  = 10;       ///< Max size of an encoded 64-bit value
+
+    MemTraceCodecState      _state;                 ///< Prediction state
+    std::istream*           _is = nullptr;          ///< Input stream
+    std::vector<uint8_t>    _chunk;                 ///< Encoded data read from the stream
+    size_t                  _pos = 0;               ///< Position of the next byte to decode in _chunk
+    size_t                  _end = 0;               ///< End of the read data in _chunk
+    uint64_t                _remaining = 0;         ///< Number of encoded bytes not yet read from the stream
+};
+
+#endif
@@ -0,0 +1,247 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the buffered binary writer of trace files
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(TARGET_WINDOWS)
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "trace_file_writer.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// TraceFileWriter implementation
+/* ============================================================================================= */
+TraceFileWriter::TraceFileWriter(size_t bufferSize) :
+    _bufferSize(std::max((bufferSize + _directAlignment - 1) / _directAlignment, size_t(1)) * _directAlignment)
+{
+#if !defined(TARGET_WINDOWS)
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, _directAlignment, _bufferSize) == 0)
+    {
+        _buffer = (uint8_t*)buffer;
+    }
+#else
+    _buffer = (uint8_t*)malloc(_bufferSize);
+#endif
+    _slices.reserve(_maxSlices);
+}
+
+TraceFileWriter::~TraceFileWriter()
+{
+    Close();
+    free(_buffer);
+}
+
+bool TraceFileWriter::Open(const string& path, Sink sink)
+{
+    Close();
+    _bufferUsed     = 0;
+    _bytesWritten   = 0;
+    _writeSeconds   = 0;
+    _sink           = Sink::BUFFERED;
+    _slices.clear();
+    if (_buffer == nullptr)
+    {
+        return false;
+    }
+
+#if !defined(TARGET_WINDOWS)
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if defined(O_DIRECT)
+    if (sink == Sink::DIRECT)
+    {
+        _fd = open(path.c_str(), flags | O_DIRECT, 0644);
+        _sink = (_fd >= 0) ? Sink::DIRECT : Sink::BUFFERED;   // Fall back to buffered writes if O_DIRECT is rejected
+    }
+#else
+    (void)sink;
+#endif
+    if (_fd < 0)
+    {
+        _fd = open(path.c_str(), flags, 0644);
+    }
+    _isOpen = (_fd >= 0);
+#else
+    (void)sink;
+    _fs.open(path, ios::binary);
+    _isOpen = (bool)_fs;
+#endif
+    _isOk = _isOpen;
+    return _isOpen;
+}
+
+void TraceFileWriter::Write(const void* data, size_t size)
+{
+    const uint8_t* src = (const uint8_t*)data;
+    _bytesWritten += size;
+    while (size != 0)
+    {
+        if ((_bufferUsed == _bufferSize) || (_slices.size() == _maxSlices))
+        {
+            Flush();
+        }
+        size_t chunkSize = std::min(size, _bufferSize - _bufferUsed);
+        uint8_t* dst = _buffer + _bufferUsed;
+        memcpy(dst, src, chunkSize);
+        _bufferUsed += chunkSize;
+
+        // Extend the last slice if it ends at the copied data
+        if (_sink == Sink::BUFFERED)
+        {
+            if (!_slices.empty() && ((const uint8_t*)_slices.back().data + _slices.back().size == dst))
+            {
+                _slices.back().size += chunkSize;
+            }
+            else
+            {
+                _slices.push_back(Slice{dst, chunkSize});
+            }
+        }
+        src  += chunkSize;
+        size -= chunkSize;
+    }
+}
+
+void TraceFileWriter::WriteRef(const void* data, size_t size)
+{
+    if ((size < _minRefSize) || (_sink == Sink::DIRECT))
+    {
+        Write(data, size);
+        return;
+    }
+    if (_slices.size() == _maxSlices) { Flush(); }
+    _slices.push_back(Slice{data, size});
+    _bytesWritten += size;
+}
+
+bool TraceFileWriter::Flush()
+{
+    if (!_isOpen)
+    {
+        return false;
+    }
+    bool isOk = (_sink == Sink::DIRECT) ? WriteDirect(false) : WriteSlices();
+    if (_sink == Sink::BUFFERED)
+    {
+        _bufferUsed = 0;
+    }
+    return isOk;
+}
+
+bool TraceFileWriter::Close()
+{
+    if (!_isOpen)
+    {
+        return _isOk;
+    }
+    bool isOk = (_sink == Sink::DIRECT) ? WriteDirect(true) : WriteSlices();
+    _bufferUsed = 0;
+
+#if !defined(TARGET_WINDOWS)
+    if (_sink == Sink::DIRECT)
+    {
+        // The last block was padded to the alignment - cut the file to its actual size
+        isOk = isOk && (ftruncate(_fd, (off_t)_bytesWritten) == 0);
+    }
+    isOk = (close(_fd) == 0) && isOk;
+    _fd = -1;
+#else
+    _fs.close();
+    isOk = isOk && !_fs.fail();
+#endif
+    _isOpen = false;
+    _isOk   = _isOk && isOk;
+    return _isOk;
+}
+
+bool TraceFileWriter::WriteSlices()
+{
+    auto startTime = chrono::steady_clock::now();
+    bool isOk = true;
+
+#if !defined(TARGET_WINDOWS)
+    iovec iov[_maxSlices];
+    size_t numSlices = _slices.size();
+    for (size_t i = 0; i != numSlices; i++)
+    {
+        iov[i].iov_base = const_cast<void*>(_slices[i].data);
+        iov[i].iov_len  = _slices[i].size;
+    }
+
+    // Repeat writev until all slices are written, skipping the part written by the previous call
+    for (size_t first = 0; isOk && (first != numSlices);)
+    {
+        ssize_t written = writev(_fd, iov + first, (int)(numSlices - first));
+        isOk = (written > 0);
+        for (size_t rest = (isOk ? (size_t)written : 0); rest != 0;)
+        {
+            size_t consumed = std::min(rest, iov[first].iov_len);
+            iov[first].iov_base = (uint8_t*)iov[first].iov_base + consumed;
+            iov[first].iov_len -= consumed;
+            rest -= consumed;
+            if (iov[first].iov_len == 0) { first++; }
+        }
+        while ((first != numSlices) && (iov[first].iov_len == 0)) { first++; }
+    }
+#else
+    for (const Slice& slice : _slices)
+    {
+        _fs.write((const char*)slice.data, slice.size);
+    }
+    isOk = !_fs.fail();
+#endif
+
+    _slices.clear();
+    _writeSeconds += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    _isOk = _isOk && isOk;
+    return isOk;
+}
+
+bool TraceFileWriter::WriteDirect(bool isFinal)
+{
+#if !defined(TARGET_WINDOWS)
+    auto startTime = chrono::steady_clock::now();
+
+    // Only whole aligned blocks may be written. The final block is padded with zeros
+    size_t writeSize = _bufferUsed / _directAlignment * _directAlignment;
+    size_t tailSize  = _bufferUsed - writeSize;
+    if (isFinal && (tailSize != 0))
+    {
+        memset(_buffer + _bufferUsed, 0, _directAlignment - tailSize);
+        writeSize += _directAlignment;
+        tailSize   = 0;
+    }
+
+    bool isOk = true;
+    for (size_t offset = 0; isOk && (offset != writeSize);)
+    {
+        ssize_t written = write(_fd, _buffer + offset, writeSize - offset);
+        isOk = (written > 0);
+        offset += (isOk ? (size_t)written : 0);
+    }
+    memmove(_buffer, _buffer + std::min(writeSize, _bufferUsed), tailSize);
+    _bufferUsed = tailSize;
+
+    _writeSeconds += chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    _isOk = _isOk && isOk;
+    return isOk;
+#else
+    (void)isFinal;
+    return false;
+#endif
+}
@@ -0,0 +1,105 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Buffered binary writer of trace files
+ */
+
+#ifndef TRACE_FILE_WRITER_H_
+#define TRACE_FILE_WRITER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* ============================================================================================= */
+// Class TraceFileWriter
+/* ============================================================================================= */
+/*!
+ * Binary file writer optimized for many small writes interleaved with large data slices.
+ * Small values are copied into a large user-space buffer. Large slices are referenced in place, without
+ * copying, and written together with the buffered data by gathered writes (writev).
+ * The direct sink (O_DIRECT, where supported) copies all data into an aligned buffer and bypasses the page cache.
+ * The writer accumulates the number of written bytes and the time spent in system calls
+ */
+class TraceFileWriter
+{
+public:
+    /// Output sink
+    enum class Sink
+    {
+        BUFFERED,   ///< Buffered writes through the page cache
+        DIRECT      ///< Unbuffered writes that bypass the page cache (O_DIRECT)
+    };
+
+    static const size_t DEFAULT_BUFFER_SIZE = 0x400000;     ///< Default size of the user-space buffer (4 MB)
+
+    explicit TraceFileWriter(size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~TraceFileWriter();
+
+    /// Create the file. If the direct sink is not supported, the buffered sink is used
+    bool Open(const std::string& path, Sink sink = Sink::BUFFERED);
+
+    /// Copy the data into the buffer
+    void Write(const void* data, size_t size);
+
+    /// Write a value of type T in binary format
+    template <typename T> void Store(const T& val) { Write(&val, sizeof(T)); }
+
+    /*!
+     * Write the data slice. Large slices are not copied: the memory must remain valid and unchanged until
+     * the next Flush() or Close()
+     */
+    void WriteRef(const void* data, size_t size);
+
+    /// Write all buffered and referenced data to the file
+    bool Flush();
+
+    /// Flush the data and close the file
+    bool Close();
+
+    bool        IsOpen()        const { return _isOpen; }
+    bool        IsOk()          const { return _isOk; }
+    uint64_t    BytesWritten()  const { return _bytesWritten; }     ///< Number of bytes written to the file
+    double      WriteSeconds()  const { return _writeSeconds; }     ///< Time spent in writing the file
+
+private:
+    TraceFileWriter(const TraceFileWriter&) = delete;
+    TraceFileWriter& operator = (const TraceFileWriter&) = delete;
+
+    /// Data slice pending to be written
+    struct Slice
+    {
+        const void* data;
+        size_t      size;
+    };
+
+    /// Write pending slices by gathered writes
+    bool WriteSlices();
+
+    /// Write the whole aligned part of the buffer in the direct mode. The tail is moved to the beginning of the buffer
+    bool WriteDirect(bool isFinal);
+
+private:
+    static const size_t _minRefSize     = 0x1000;   ///< Slices smaller than this size are copied into the buffer
+    static const size_t _maxSlices      = 1024;     ///< Max number of slices in a gathered write
+    static const size_t _directAlignment = 0x1000;  ///< Alignment of buffers and sizes in the direct mode
+
+    uint8_t*            _buffer = nullptr;      ///< User-space buffer (aligned for the direct mode)
+    size_t              _bufferSize;            ///< Size of the buffer
+    size_t              _bufferUsed = 0;        ///< Number of bytes in the buffer
+    std::vector<Slice>  _slices;                ///< Slices pending to be written (buffered mode)
+    Sink                _sink = Sink::BUFFERED; ///< Output sink
+    int                 _fd = -1;               ///< File descriptor
+    std::ofstream       _fs;                    ///< File stream, used on platforms without POSIX I/O
+    bool                _isOpen = false;
+    bool                _isOk = false;
+    uint64_t            _bytesWritten = 0;      ///< Number of bytes passed to the writer
+    double              _writeSeconds = 0;      ///< Time spent in writing the file
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the generator of synthetic SLM traces
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "trace_generator.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// MemTraceGenConfig implementation
+/* ============================================================================================= */
+bool MemTraceGenConfig::ParseOption(int argc, const char* argv[], int& i)
+{
+    if (i + 1 >= argc)
+    {
+        return false;
+    }
+    const char* option = argv[i];
+    const char* value  = argv[i + 1];
+    if (!strcmp(option, "-threads"))            { numThreads        = (uint32_t)strtoul(value, nullptr, 0); }
+    else if (!strcmp(option, "-bbls"))          { numBbls           = (uint32_t)strtoul(value, nullptr, 0); }
+    else if (!strcmp(option, "-ins"))           { numInsPerBbl      = (uint32_t)strtoul(value, nullptr, 0); }
+    else if (!strcmp(option, "-simd"))          { simdWidth         = (uint32_t)strtoul(value, nullptr, 0); }
+    else if (!strcmp(option, "-stride"))        { stride            = (uint32_t)strtoul(value, nullptr, 0); }
+    else if (!strcmp(option, "-broadcast"))     { broadcastFraction = strtod(value, nullptr); }
+    else if (!strcmp(option, "-slm"))           { slmSize           = (uint32_t)strtoul(value, nullptr, 0); }
+    else if (!strcmp(option, "-grf"))           { grfSize           = (uint32_t)strtoul(value, nullptr, 0); }
+    else if (!strcmp(option, "-seed"))          { seed              = strtoull(value, nullptr, 0); }
+    else
+    {
+        return false;
+    }
+    ++i;
+    return true;
+}
+
+const char* MemTraceGenConfig::OptionsUsage()
+{
+    return "  -threads    Number of HW threads that generate records (default - 448)\n"
+           "  -bbls       Number of BBLs that access SLM (default - 4)\n"
+           "  -ins        Number of SLM instructions in each BBL (default - 2)\n"
+           "  -simd       SIMD width of SLM instructions: 8, 16 or 32 (default - 16)\n"
+           "  -stride     Distance between addresses of adjacent channels in bytes (default - 4)\n"
+           "  -broadcast  Fraction of accesses where all channels access the same address (default - 0.1)\n"
+           "  -slm        Size of the accessed SLM range in bytes (default - 65536)\n"
+           "  -grf        Size of the GRF register in bytes (default - 32)\n"
+           "  -seed       Seed of the pseudo-random generator (default - 1)\n";
+}
+
+bool MemTraceGenConfig::IsValid() const
+{
+    bool isSimdValid = (simdWidth == 8) || (simdWidth == 16) || (simdWidth == 32);
+    bool isGrfValid  = (grfSize >= sizeof(MemTraceRecordHeader)) && ((grfSize & (grfSize - 1)) == 0);
+    return isSimdValid && isGrfValid &&
+           (numThreads != 0) && (numThreads <= MEMTRACE_NUM_SR0_VALUES) &&
+           (numBbls != 0) && (numBbls <= UINT16_MAX + 1) &&
+           (numInsPerBbl != 0) && (numInsPerBbl <= 64) &&
+           (slmSize >= sizeof(uint32_t)) && (broadcastFraction >= 0) && (broadcastFraction <= 1);
+}
+
+/* ============================================================================================= */
+// MemTraceGenerator implementation
+/* ============================================================================================= */
+MemTraceGenerator::MemTraceGenerator(const MemTraceGenConfig& config) : _config(config)
+{
+    uint32_t simdWidth = _config.simdWidth;
+    uint32_t addrPayloadLength = (simdWidth * sizeof(uint32_t) + _config.grfSize - 1) / _config.grfSize;
+
+    // BBLs of SLM scatter instructions with 32-bit addresses
+    _layout.grfSize = _config.grfSize;
+    for (uint32_t bblId = 0; bblId != _config.numBbls; bblId++)
+    {
+        for (uint32_t i = 0; i != _config.numInsPerBbl; i++)
+        {
+            MemTracePackedMemIns memIns;
+            memset(&memIns, 0, sizeof(memIns));
+            memIns.offset               = (bblId * _config.numInsPerBbl + i) * 16;
+            memIns.isScatter            = 1;
+            memIns.isSLM                = 1;
+            memIns.simdWidth            = (simdWidth >= 16);
+            memIns.elementSize          = sizeof(uint32_t);
+            memIns.numElements          = 1;
+            memIns.addrPayloadLength    = addrPayloadLength;
+            memIns.execSize             = simdWidth;
+            _layout.AddMemIns(bblId, memIns);
+        }
+    }
+    _bblPayloadSize = _layout.bblInfos[0].payloadSize;
+
+    // Threads are identified by the low bits of sr0
+    _layout.sr0Tids.resize(MEMTRACE_NUM_SR0_VALUES);
+    for (uint32_t sr0 = 0; sr0 != MEMTRACE_NUM_SR0_VALUES; sr0++)
+    {
+        _layout.sr0Tids[sr0] = sr0 % _config.numThreads;
+    }
+    _layout.threads.resize(_config.numThreads);
+    for (uint32_t tid = 0; tid != _config.numThreads; tid++)
+    {
+        _layout.threads[tid] = MemTraceGlobalTid{0, UINT32_MAX, 0, tid / 8, tid % 8};
+    }
+
+    _execMask           = (simdWidth == 32) ? UINT32_MAX : ((1u << simdWidth) - 1);
+    _broadcastThreshold = (_config.broadcastFraction >= 1) ? UINT64_MAX :
+                                                             (uint64_t)(_config.broadcastFraction * 18446744073709551616.0);
+    _state              = (_config.seed != 0) ? _config.seed : 1;
+}
+
+void MemTraceGenerator::GeneratePayload(uint8_t* payload)
+{
+    const MemTraceBblInfo& bblInfo = _layout.bblInfos[0];
+    for (uint32_t i = 0; i != _config.numInsPerBbl; i++)
+    {
+        uint32_t* addrs       = (uint32_t*)(payload + bblInfo.payloadOffsets[i]);
+        uint32_t  base        = (uint32_t)((Random() >> 32) % _config.slmSize) & ~3u;
+        bool      isBroadcast = (Random() < _broadcastThreshold);
+        for (uint32_t lane = 0; lane != _config.simdWidth; lane++)
+        {
+            addrs[lane] = isBroadcast ? base : (uint32_t)((base + uint64_t(lane) * _config.stride) % _config.slmSize);
+        }
+    }
+}
+
+void MemTraceGenerator::GenerateRawTrace(uint64_t numRecords, vector<uint8_t>& trace)
+{
+    uint32_t recordSize        = RawRecordSize();
+    uint32_t alignedHeaderSize = _layout.AlignedHeaderSize();
+    trace.assign(numRecords * recordSize, 0);
+
+    // HW threads of the dispatch run concurrently, so their records are interleaved in the trace
+    for (uint64_t r = 0; r != numRecords; r++)
+    {
+        uint8_t*             record = trace.data() + r * recordSize;
+        MemTraceRecordHeader header;
+        memset(&header, 0, sizeof(header));
+        header.bblId = (uint16_t)(Random() % _config.numBbls);
+        header.sr0   = (uint16_t)(r % _config.numThreads);
+        header.ce    = _execMask;
+        header.dm    = _execMask;
+        memcpy(record, &header, sizeof(header));
+        GeneratePayload(record + alignedHeaderSize);
+    }
+}
+
+bool MemTraceGenerator::StoreTraceFile(const string& path, uint32_t version, uint64_t numRecords, bool storeIndex)
+{
+    uint32_t numThreads = (uint32_t)std::min<uint64_t>(_config.numThreads, numRecords);
+    if (numRecords / std::max(numThreads, 1u) >= UINT32_MAX)
+    {
+        return false; // The number of records of a thread does not fit in the file format
+    }
+
+    TraceFileWriter fs;
+    if (!fs.Open(path))
+    {
+        return false;
+    }
+    if (version == 3)
+    {
+        // Columns are laid out by the serializer, which groups records of the raw trace by threads
+        vector<uint8_t>             rawTrace;
+        MemTraceSerializer::Scratch scratch;
+        GenerateRawTrace(numRecords, rawTrace);
+        MemTraceSerializer(_layout, version).Store(rawTrace.data(), rawTrace.size(), scratch, fs);
+        return fs.Close();
+    }
+    if (version == 2)
+    {
+        fs.Store(MEMTRACE_V2_SIGNATURE);
+        fs.Store(_layout.grfSize);
+    }
+    uint64_t staticInfoOffset = fs.BytesWritten();
+    StoreBblInfos(_layout, fs);
+    fs.Store(numThreads);
+
+    vector<uint8_t>     payload(_bblPayloadSize, 0);
+    MemTraceEncoder     encoder;
+    MemTraceThreadIndex threadIndex;
+    for (uint32_t tid = 0; tid != numThreads; tid++)
+    {
+        uint32_t numThreadRecords = (uint32_t)(numRecords / numThreads + ((tid < numRecords % numThreads) ? 1 : 0));
+        threadIndex.push_back(MemTraceThreadIndexEntry{_layout.threads[tid], numThreadRecords, fs.BytesWritten()});
+        fs.Store(_layout.threads[tid]);
+        fs.Store(numThreadRecords);
+
+        if (version == 2)
+        {
+            encoder.BeginThread();
+        }
+        for (uint32_t r = 0; r != numThreadRecords; r++)
+        {
+            uint32_t bblId = (uint32_t)(Random() % _config.numBbls);
+            GeneratePayload(payload.data());
+            if (version == 2)
+            {
+                encoder.AddRecord(MemTraceRecord{&_layout.bblInfos[bblId], _execMask, payload.data()});
+                continue;
+            }
+            fs.Store(bblId);
+            fs.Store(_execMask);
+            fs.Write(payload.data(), payload.size());
+        }
+        if (version == 2)
+        {
+            const vector<uint8_t>& encoded = encoder.EndThread();
+            fs.Store((uint32_t)encoded.size());
+            fs.Write(encoded.data(), encoded.size());
+        }
+    }
+    if (storeIndex)
+    {
+        StoreThreadIndex(threadIndex, staticInfoOffset, fs);
+    }
+    return fs.Close();
+}
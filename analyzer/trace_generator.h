@@ -0,0 +1,107 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Generator of synthetic SLM traces, used to produce trace files and raw dispatch traces
+ *       of arbitrary size and shape for benchmarking
+ */
+
+#ifndef TRACE_GENERATOR_H_
+#define TRACE_GENERATOR_H_
+
+#include <string>
+#include <vector>
+
+#include "dispatch_trace.h"
+
+/* ============================================================================================= */
+// Struct MemTraceGenConfig
+/* ============================================================================================= */
+/*!
+ * Shape of the synthetic trace. Each BBL contains the same number of SLM scatter instructions of the same
+ * SIMD width; each record is generated by a random BBL of a thread, with all channels enabled
+ */
+struct MemTraceGenConfig
+{
+    uint32_t    grfSize             = 32;       ///< Size of the GRF register in bytes
+    uint32_t    numThreads          = 448;      ///< Number of HW threads that generate records
+    uint32_t    numBbls             = 4;        ///< Number of BBLs that access SLM
+    uint32_t    numInsPerBbl        = 2;        ///< Number of SLM instructions in each BBL
+    uint32_t    simdWidth           = 16;       ///< SIMD width of SLM instructions: 8, 16 or 32
+    uint32_t    stride              = 4;        ///< Distance between addresses of adjacent channels in bytes
+    double      broadcastFraction   = 0.1;      ///< Fraction of accesses where all channels access the same address
+    uint32_t    slmSize             = 0x10000;  ///< Size of the accessed SLM range in bytes
+    uint64_t    seed                = 1;        ///< Seed of the pseudo-random generator
+
+    /*!
+     * Parse the generator option at argv[i], and advance i past the option value
+     * @return false if argv[i] is not a generator option
+     */
+    bool ParseOption(int argc, const char* argv[], int& i);
+
+    /// @return Description of the generator options, for the usage message
+    static const char* OptionsUsage();
+
+    /// @return false if the configuration is invalid
+    bool IsValid() const;
+};
+
+/* ============================================================================================= */
+// Class MemTraceGenerator
+/* ============================================================================================= */
+/*!
+ * Generator of synthetic trace records. Records are generated thread by thread, so trace files of any size
+ * are produced with bounded memory
+ */
+class MemTraceGenerator
+{
+public:
+    explicit MemTraceGenerator(const MemTraceGenConfig& config);
+
+    /// @return Layout of the synthetic kernel
+    const MemTraceKernelLayout& Layout() const { return _layout; }
+
+    /// @return Size of a record in the version 1 trace file, in bytes
+    uint32_t FileRecordSize() const { return 2 * sizeof(uint32_t) + _bblPayloadSize; }
+
+    /// @return Size of a record in the raw dispatch trace, in bytes
+    uint32_t RawRecordSize() const { return _layout.AlignedHeaderSize() + _bblPayloadSize; }
+
+    /// Generate a raw dispatch trace of the specified number of records, with records of threads interleaved
+    void GenerateRawTrace(uint64_t numRecords, std::vector<uint8_t>& trace);
+
+    /*!
+     * Store a trace file of the specified number of records
+     * @param version     Version of the trace file format, 1, 2 or 3. Version 3 files are serialized from a raw
+     *                    dispatch trace, which is held in memory
+     * @param storeIndex  Append the thread index to the file. Ignored by version 3, which stores the thread table
+     * @return false if the file could not be written
+     */
+    bool StoreTraceFile(const std::string& path, uint32_t version, uint64_t numRecords, bool storeIndex = false);
+
+private:
+    /// Generate the next pseudo-random number (xorshift64*)
+    uint64_t Random()
+    {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 0x2545F4914F6CDD1DULL;
+    }
+
+    /// Generate address payloads of a record. All BBLs have the same payload layout
+    void GeneratePayload(uint8_t* payload);
+
+private:
+    MemTraceGenConfig       _config;                ///< Shape of the trace
+    MemTraceKernelLayout    _layout;                ///< Layout of the synthetic kernel
+    uint32_t                _bblPayloadSize;        ///< Size of address payloads of a record
+    uint32_t                _execMask;              ///< Execution mask of all records
+    uint64_t                _broadcastThreshold;    ///< Random values below the threshold generate broadcasts
+    uint64_t                _state;                 ///< State of the pseudo-random generator
+};
+
+#endif
@@ -0,0 +1,447 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the reader of memorytrace_compressed.bin files
+ */
+
+#include <bitset>
+#include <cstring>
+
+#include "trace_codec.h"
+#include "trace_reader.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// MemTraceFileReader implementation
+/* ============================================================================================= */
+MemTraceFileReader::MemTraceFileReader(uint32_t grfSize) : _streamBuffer(_streamBufferSize), _grfSize(grfSize) {}
+
+MemTraceFileReader::~MemTraceFileReader() = default;
+
+bool MemTraceFileReader::Open(const string& path)
+{
+    _path = path;
+    _fs.rdbuf()->pubsetbuf(_streamBuffer.data(), _streamBuffer.size());
+    _fs.open(path, ios::binary);
+    if (!_fs)
+    {
+        return Fail("could not open file");
+    }
+    _fs.seekg(0, ios::end);
+    _fileSize = (uint64_t)_fs.tellg();
+    _fs.seekg(0, ios::beg);
+
+    // Read the header of the version 2 format, which stores the GRF size
+    uint32_t numBbls = 0;
+    if (!Load(numBbls)) { return Fail("could not read the number of BBLs"); }
+    if (numBbls == MEMTRACE_V2_SIGNATURE)
+    {
+        _version = 2;
+        if (!Load(_grfSize) || !Load(numBbls)) { return Fail("could not read the file header"); }
+        _decoder.reset(new MemTraceDecoder);
+    }
+    else if (numBbls == MEMTRACE_V3_SIGNATURE)
+    {
+        _version = 3;
+        if (!Load(_grfSize) || !Load(numBbls)) { return Fail("could not read the file header"); }
+        if (_grfSize == 0) { return Fail("invalid GRF size"); }
+    }
+
+    // Read static information about memory accesses in BBLs
+
+    _bbls.resize(numBbls);
+    for (MemTraceBblInfo& bblInfo : _bbls)
+    {
+        uint32_t numMemInstructions = 0;
+        if (!Load(bblInfo.bblId) || !Load(numMemInstructions))
+        {
+            return Fail("could not read BBL information");
+        }
+        bblInfo.memInstructions.resize(numMemInstructions);
+        for (MemTracePackedMemIns& memIns : bblInfo.memInstructions)
+        {
+            if (!Load(memIns)) { return Fail("could not read memory instruction descriptor"); }
+        }
+        if (bblInfo.bblId >= _bblIndex.size())
+        {
+            _bblIndex.resize(bblInfo.bblId + 1, -1);
+        }
+        _bblIndex[bblInfo.bblId] = int32_t(&bblInfo - _bbls.data());
+    }
+
+    if (!Load(_numThreads)) { return Fail("could not read the number of threads"); }
+    _tracesOffset = _fs.tellg();
+    if ((_version == 3) ? !ReadColumns() : !ReadThreadIndex()) { return false; }
+
+    // Compute the layout of trace records. Detect the GRF size if it is not specified
+    if ((_grfSize != 0) || (_version != 1))
+    {
+        ComputePayloadLayout(_grfSize);
+        return true;
+    }
+    for (uint32_t grfSize : {32, 64})
+    {
+        ComputePayloadLayout(grfSize);
+        if (CheckLayout())
+        {
+            _grfSize = grfSize;
+            return true;
+        }
+    }
+    return Fail("could not detect the GRF size - the file is truncated or corrupted");
+}
+
+bool MemTraceFileReader::ReadThreadIndex()
+{
+    _tracesEnd = _fileSize;
+    MemTraceIndexTrailer trailer;
+    if (_fileSize < (uint64_t)_tracesOffset + sizeof(trailer))
+    {
+        return true;
+    }
+    _fs.seekg(_fileSize - sizeof(trailer));
+    if (!Load(trailer)) { return Fail("could not read the end of file"); }
+
+    // Version 1 files without the index end with address payloads, which may match the signature. The trailer
+    // is accepted only if it is consistent with the static part of the file
+    uint64_t staticInfoOffset = ((_version == 2) ? 2 * sizeof(uint32_t) : 0);
+    uint64_t indexSize        = uint64_t(trailer.numThreads) * sizeof(MemTraceThreadIndexEntry);
+    if ((trailer.signature != MEMTRACE_INDEX_SIGNATURE) || (trailer.staticInfoOffset != staticInfoOffset) ||
+        (trailer.numThreads != _numThreads) || (trailer.indexOffset < (uint64_t)_tracesOffset) ||
+        (trailer.indexOffset > _fileSize) || (trailer.indexOffset + indexSize + sizeof(trailer) != _fileSize))
+    {
+        _fs.seekg(_tracesOffset);
+        return true;
+    }
+
+    _threadIndex.resize(trailer.numThreads);
+    _fs.seekg(trailer.indexOffset);
+    if (!_fs.read((char*)_threadIndex.data(), indexSize)) { return Fail("could not read the thread index"); }
+    for (const MemTraceThreadIndexEntry& entry : _threadIndex)
+    {
+        if ((entry.offset < (uint64_t)_tracesOffset) || (entry.offset >= trailer.indexOffset))
+        {
+            return Fail("corrupted thread index");
+        }
+    }
+    _hasIndex  = true;
+    _tracesEnd = trailer.indexOffset;
+    _fs.seekg(_tracesOffset);
+    return true;
+}
+
+bool MemTraceFileReader::ReadColumns()
+{
+    // The thread table locates records of threads in columns
+    _threadIndex.resize(_numThreads);
+    uint64_t tableSize = uint64_t(_numThreads) * sizeof(MemTraceThreadIndexEntry);
+    if ((uint64_t)_tracesOffset + tableSize > _fileSize || !_fs.read((char*)_threadIndex.data(), tableSize))
+    {
+        return Fail("could not read the thread table");
+    }
+    uint64_t headerOffset = (uint64_t)_tracesOffset + tableSize;
+    headerOffset = (headerOffset + MEMTRACE_COLUMN_ALIGNMENT - 1) / MEMTRACE_COLUMN_ALIGNMENT * MEMTRACE_COLUMN_ALIGNMENT;
+    MemTraceColumnsHeader header;
+    _fs.seekg((streamoff)headerOffset);
+    if (!Load(header)) { return Fail("could not read the columns header"); }
+
+    // Check that the columns are aligned and fit in the file
+    auto isValidColumn = [&](uint64_t offset, uint64_t count, uint64_t elementSize)
+    {
+        return (offset % MEMTRACE_COLUMN_ALIGNMENT == 0) && (offset >= headerOffset + sizeof(header)) &&
+               (offset <= _fileSize) && (count <= (_fileSize - offset) / elementSize);
+    };
+    if ((header.numRecords >= UINT64_MAX / sizeof(uint64_t)) ||
+        !isValidColumn(header.bblIdsOffset, header.numRecords, sizeof(uint16_t)) ||
+        !isValidColumn(header.execMasksOffset, header.numRecords, sizeof(uint32_t)) ||
+        !isValidColumn(header.threadAddrsOffset, _numThreads, sizeof(uint64_t)) ||
+        !isValidColumn(header.addressesOffset, header.numAddresses, sizeof(uint32_t)))
+    {
+        return Fail("corrupted columns header");
+    }
+    for (const MemTraceThreadIndexEntry& entry : _threadIndex)
+    {
+        if ((entry.offset > header.numRecords) || (entry.numRecords > header.numRecords - entry.offset))
+        {
+            return Fail("corrupted thread table");
+        }
+    }
+
+    _mappedFile.reset(new MappedFile);
+    if (!_mappedFile->Map(_path) || (_mappedFile->Size() != _fileSize))
+    {
+        return Fail("could not map the file");
+    }
+    const char* data = _mappedFile->Data();
+    _columns.numRecords   = header.numRecords;
+    _columns.numAddresses = header.numAddresses;
+    _columns.bblIds       = (const uint16_t*)(data + header.bblIdsOffset);
+    _columns.execMasks    = (const uint32_t*)(data + header.execMasksOffset);
+    _columns.threadAddrs  = (const uint64_t*)(data + header.threadAddrsOffset);
+    _columns.addresses    = (const uint32_t*)(data + header.addressesOffset);
+    for (uint32_t t = 0; t != _numThreads; t++)
+    {
+        uint64_t threadEnd = (t + 1 == _numThreads) ? _columns.numAddresses : _columns.threadAddrs[t + 1];
+        if (_columns.threadAddrs[t] > threadEnd)
+        {
+            return Fail("corrupted thread addresses");
+        }
+    }
+    _hasIndex  = true;
+    _tracesEnd = _fileSize;
+    return true;
+}
+
+vector<uint32_t> MemTraceFileReader::SelectThreads(const MemTraceThreadFilter& filter) const
+{
+    vector<uint32_t> threads;
+    for (uint32_t i = 0; i != _threadIndex.size(); i++)
+    {
+        if (filter.Matches(_threadIndex[i].gtid)) { threads.push_back(i); }
+    }
+    return threads;
+}
+
+const MemTraceBblInfo* MemTraceFileReader::GetBblInfo(uint32_t bblId) const
+{
+    if (bblId >= _bblIndex.size() || _bblIndex[bblId] < 0)
+    {
+        return nullptr;
+    }
+    return &_bbls[_bblIndex[bblId]];
+}
+
+void MemTraceFileReader::ComputePayloadLayout(uint32_t grfSize)
+{
+    for (MemTraceBblInfo& bblInfo : _bbls)
+    {
+        bblInfo.payloadOffsets.clear();
+        bblInfo.payloadSize = 0;
+        for (const MemTracePackedMemIns& memIns : bblInfo.memInstructions)
+        {
+            bblInfo.payloadOffsets.push_back(bblInfo.payloadSize);
+            bblInfo.payloadSize += memIns.addrPayloadLength * grfSize;
+        }
+    }
+}
+
+bool MemTraceFileReader::CheckLayout()
+{
+    _fs.clear();
+    _fs.seekg(_tracesOffset);
+
+    // Skip payloads without seeking, which would discard the stream buffer, and track the file position locally
+    uint64_t offset  = (uint64_t)_tracesOffset;
+    bool     isValid = true;
+    for (uint32_t i = 0; (i != _numThreads) && isValid; i++)
+    {
+        MemTraceGlobalTid gtid;
+        uint32_t numRecords = 0;
+        isValid = Load(gtid) && Load(numRecords);
+        offset += sizeof(gtid) + sizeof(numRecords);
+        for (uint32_t r = 0; (r != numRecords) && isValid; r++)
+        {
+            uint32_t bblId    = 0;
+            uint32_t execMask = 0;
+            const MemTraceBblInfo* bblInfo = nullptr;
+            isValid = Load(bblId) && Load(execMask) && ((bblInfo = GetBblInfo(bblId)) != nullptr);
+            if (isValid)
+            {
+                offset += sizeof(bblId) + sizeof(execMask) + bblInfo->payloadSize;
+                isValid = (offset <= _tracesEnd) && (bool)_fs.ignore(bblInfo->payloadSize);
+            }
+        }
+    }
+    isValid = isValid && (offset == _tracesEnd);
+
+    _fs.clear();
+    _fs.seekg(_tracesOffset);
+    return isValid;
+}
+
+bool MemTraceFileReader::Process(MemTraceVisitor& visitor)
+{
+    if (_version == 3)
+    {
+        for (uint32_t index = 0; index != _threadIndex.size(); index++)
+        {
+            if (!ProcessColumnarThread(visitor, index)) { return false; }
+        }
+        return true;
+    }
+    _fs.clear();
+    _fs.seekg(_tracesOffset);
+
+    for (uint32_t i = 0; i != _numThreads; i++)
+    {
+        if (!ProcessThread(visitor)) { return false; }
+    }
+    return true;
+}
+
+bool MemTraceFileReader::ProcessThreads(MemTraceVisitor& visitor, const vector<uint32_t>& threads)
+{
+    if (!_hasIndex)
+    {
+        return Fail("the file has no thread index");
+    }
+    for (uint32_t index : threads)
+    {
+        if (index >= _threadIndex.size())
+        {
+            return Fail("invalid thread index " + to_string(index));
+        }
+        if (_version == 3)
+        {
+            if (!ProcessColumnarThread(visitor, index)) { return false; }
+            continue;
+        }
+        _fs.clear();
+        _fs.seekg((streamoff)_threadIndex[index].offset);
+        if (!ProcessThread(visitor)) { return false; }
+    }
+    return true;
+}
+
+bool MemTraceFileReader::ProcessThread(MemTraceVisitor& visitor)
+{
+    MemTraceGlobalTid gtid;
+    uint32_t numRecords = 0;
+    if (!Load(gtid) || !Load(numRecords))
+    {
+        return Fail("could not read thread header");
+    }
+    visitor.OnThread(gtid, numRecords);
+    return (_version == 2) ? ProcessEncodedThread(visitor, numRecords) : ProcessRawThread(visitor, numRecords);
+}
+
+bool MemTraceFileReader::ProcessRawThread(MemTraceVisitor& visitor, uint32_t numRecords)
+{
+    for (uint32_t r = 0; r != numRecords; r++)
+    {
+        MemTraceRecord record;
+        uint32_t bblId = 0;
+        if (!Load(bblId) || !Load(record.execMask))
+        {
+            return Fail("could not read record header");
+        }
+        record.bbl = GetBblInfo(bblId);
+        if (record.bbl == nullptr)
+        {
+            return Fail("unknown BBL ID " + to_string(bblId));
+        }
+        _payload.resize(record.bbl->payloadSize);
+        if (!_fs.read((char*)_payload.data(), _payload.size()))
+        {
+            return Fail("could not read address payload");
+        }
+        record.payload = _payload.data();
+        visitor.OnRecord(record);
+    }
+    return true;
+}
+
+bool MemTraceFileReader::ProcessEncodedThread(MemTraceVisitor& visitor, uint32_t numRecords)
+{
+    uint32_t encodedSize = 0;
+    if (!Load(encodedSize)) { return Fail("could not read thread header"); }
+    _decoder->BeginThread(_fs, encodedSize);
+
+    // Records are decoded run by run, where all records of a run have the same BBL and execution mask
+    for (uint32_t r = 0; r != numRecords;)
+    {
+        MemTraceRecord record;
+        uint32_t runLength = 0;
+        uint32_t bblId     = 0;
+        if (!_decoder->ReadRun(runLength, bblId, record.execMask) || (runLength > numRecords - r))
+        {
+            return Fail("corrupted record header");
+        }
+        record.bbl = GetBblInfo(bblId);
+        if (record.bbl == nullptr)
+        {
+            return Fail("unknown BBL ID " + to_string(bblId));
+        }
+        _payload.resize(record.bbl->payloadSize);
+        record.payload = _payload.data();
+        for (r += runLength; runLength != 0; runLength--)
+        {
+            if (!_decoder->ReadPayload(*record.bbl, record.execMask, _payload.data()))
+            {
+                return Fail("corrupted address payload");
+            }
+            visitor.OnRecord(record);
+        }
+    }
+    if (!_decoder->AtEnd())
+    {
+        return Fail("unexpected size of the encoded thread trace");
+    }
+    return true;
+}
+
+bool MemTraceFileReader::ProcessColumnarThread(MemTraceVisitor& visitor, uint32_t index)
+{
+    const MemTraceThreadIndexEntry& thread = _threadIndex[index];
+    const uint32_t* addr      = _columns.addresses + _columns.threadAddrs[index];
+    const uint32_t* threadEnd = _columns.addresses +
+                                ((index + 1 == _threadIndex.size()) ? _columns.numAddresses : _columns.threadAddrs[index + 1]);
+    bool consumesColumns = visitor.ConsumesColumns();
+    visitor.OnThread(thread.gtid, thread.numRecords);
+    for (uint64_t r = thread.offset; r != thread.offset + thread.numRecords; r++)
+    {
+        MemTraceColumnarRecord record;
+        record.execMask  = _columns.execMasks[r];
+        record.grfSize   = _grfSize;
+        record.addresses = addr;
+        record.bbl       = GetBblInfo(_columns.bblIds[r]);
+        if (record.bbl == nullptr)
+        {
+            return Fail("unknown BBL ID " + to_string(_columns.bblIds[r]));
+        }
+
+        // Addresses of the record follow from the BBL and the execution mask. Columns are passed to the visitor
+        // as they are, otherwise addresses of analyzed channels are scattered to their places in the payload,
+        // and other bytes are zeros
+        if (!consumesColumns)
+        {
+            _payload.assign(record.bbl->payloadSize, 0);
+        }
+        for (uint32_t i = 0; i != record.bbl->memInstructions.size(); i++)
+        {
+            const MemTracePackedMemIns& memIns   = record.bbl->memInstructions[i];
+            uint32_t                    laneMask = MemTraceColumnLaneMask(memIns, record.execMask, _grfSize);
+            size_t                      numAddrs = bitset<32>(laneMask).count();
+            if (size_t(threadEnd - addr) < numAddrs)
+            {
+                return Fail("corrupted address column");
+            }
+            if (!consumesColumns)
+            {
+                uint8_t* insAddrs = _payload.data() + record.bbl->payloadOffsets[i];
+                uint32_t addrSize = MemTraceAddrSize(memIns);
+                for (uint32_t lane = 0, a = 0; laneMask != 0; lane++, laneMask >>= 1)
+                {
+                    if ((laneMask & 1) != 0) { memcpy(insAddrs + lane * addrSize, addr + a++, sizeof(uint32_t)); }
+                }
+            }
+            addr += numAddrs;
+        }
+        if (consumesColumns)
+        {
+            visitor.OnColumnarRecord(record);
+            continue;
+        }
+        visitor.OnRecord(MemTraceRecord{record.bbl, record.execMask, _payload.data()});
+    }
+    if (addr != threadEnd)
+    {
+        return Fail("corrupted address column");
+    }
+    return true;
+}
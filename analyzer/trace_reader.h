@@ -0,0 +1,252 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Reader of memorytrace_compressed.bin files
+ */
+
+#ifndef TRACE_READER_H_
+#define TRACE_READER_H_
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "memtrace_format.h"
+
+class MemTraceDecoder;
+
+/* ============================================================================================= */
+// Struct MemTraceBblInfo
+/* ============================================================================================= */
+/*!
+ * Static information about SLM accesses in a basic block, as read from the trace file
+ */
+struct MemTraceBblInfo
+{
+    uint32_t                            bblId;              ///< BBL ID
+    std::vector<MemTracePackedMemIns>   memInstructions;    ///< Memory instructions in the BBL
+    std::vector<uint32_t>               payloadOffsets;     ///< Offset of each instruction's address payload in the record
+    uint32_t                            payloadSize = 0;    ///< Total size of address payloads in the record
+};
+
+/* ============================================================================================= */
+// Struct MemTraceRecord
+/* ============================================================================================= */
+/*!
+ * View of a single trace record. Valid only within the MemTraceVisitor::OnRecord callback
+ */
+struct MemTraceRecord
+{
+    const MemTraceBblInfo*  bbl;        ///< BBL that generated the record
+    uint32_t                execMask;   ///< Dynamic execution mask (ce & dm)
+    const uint8_t*          payload;    ///< Address payloads of all memory instructions in the BBL
+
+    /// @return Address payload of the specified memory instruction in the BBL
+    const uint8_t* InsPayload(uint32_t insIndex) const { return payload + bbl->payloadOffsets[insIndex]; }
+};
+
+/* ============================================================================================= */
+// Struct MemTraceColumnarRecord
+/* ============================================================================================= */
+/*!
+ * View of a trace record of a version 3 file in the columns of the mapped file, without restored address payloads.
+ * Valid only within the MemTraceVisitor::OnColumnarRecord callback
+ */
+struct MemTraceColumnarRecord
+{
+    const MemTraceBblInfo*  bbl;        ///< Static information about the BBL that generated the record
+    uint32_t                execMask;   ///< Dynamic execution mask
+    uint32_t                grfSize;    ///< Size of the GRF register, which limits channels of MemTraceColumnLaneMask()
+    const uint32_t*         addresses;  ///< Addresses of channels of MemTraceColumnLaneMask() of all instructions
+                                        ///< of the BBL, in the order of instructions and channels
+};
+
+/* ============================================================================================= */
+// Class MemTraceVisitor
+/* ============================================================================================= */
+/*!
+ * Interface of a consumer of trace records
+ */
+class MemTraceVisitor
+{
+public:
+    virtual ~MemTraceVisitor() = default;
+
+    /// Called at the beginning of each thread's trace
+    virtual void OnThread(const MemTraceGlobalTid& gtid, uint32_t numRecords) { (void)gtid; (void)numRecords; }
+
+    /// Called for each trace record of the current thread
+    virtual void OnRecord(const MemTraceRecord& record) = 0;
+
+    /*!
+     * @return true if records of version 3 files are passed to OnColumnarRecord() instead of OnRecord(), so that
+     *         address payloads are not restored from the address column
+     */
+    virtual bool ConsumesColumns() const { return false; }
+
+    /// Called for each trace record of the current thread of a version 3 file if ConsumesColumns()
+    virtual void OnColumnarRecord(const MemTraceColumnarRecord& record) { (void)record; }
+};
+
+/* ============================================================================================= */
+// Struct MemTraceColumns
+/* ============================================================================================= */
+/*!
+ * Columns of a version 3 trace file, mapped into memory. Each column is aligned to MEMTRACE_COLUMN_ALIGNMENT bytes.
+ * Addresses of thread t of the thread table start at addresses[threadAddrs[t]]; each record of the thread takes
+ * the addresses of channels of MemTraceColumnLaneMask() of its instructions
+ */
+struct MemTraceColumns
+{
+    uint64_t            numRecords   = 0;           ///< Number of records of all threads
+    uint64_t            numAddresses = 0;           ///< Number of channel addresses of all records
+    const uint16_t*     bblIds       = nullptr;     ///< BBL IDs of records
+    const uint32_t*     execMasks    = nullptr;     ///< Dynamic execution masks of records
+    const uint64_t*     threadAddrs  = nullptr;     ///< Index of the first address of each thread of the thread table
+    const uint32_t*     addresses    = nullptr;     ///< Addresses of analyzed channels (see MemTraceColumnLaneMask)
+};
+
+/// Thread index of a trace file: locations of traces of all threads, in the order of the threads in the file
+using MemTraceThreadIndex = std::vector<MemTraceThreadIndexEntry>;
+
+/* ============================================================================================= */
+// Struct MemTraceThreadFilter
+/* ============================================================================================= */
+/*!
+ * Selection of threads by their location in the GPU. Fields set to ANY match all values
+ */
+struct MemTraceThreadFilter
+{
+    static const uint32_t ANY = UINT32_MAX;
+
+    uint32_t    sliceId     = ANY;  ///< Slice
+    uint32_t    subSliceId  = ANY;  ///< Subslice
+    uint32_t    euId        = ANY;  ///< EU
+    uint32_t    threadSlot  = ANY;  ///< Thread slot of the EU
+
+    /// @return true if the filter matches all threads
+    bool IsEmpty() const { return (sliceId == ANY) && (subSliceId == ANY) && (euId == ANY) && (threadSlot == ANY); }
+
+    /// @return true if the thread matches the filter
+    bool Matches(const MemTraceGlobalTid& gtid) const
+    {
+        return ((sliceId == ANY) || (gtid.sliceId == sliceId)) && ((subSliceId == ANY) || (gtid.subSliceId == subSliceId)) &&
+               ((euId == ANY) || (gtid.euId == euId)) && ((threadSlot == ANY) || (gtid.threadSlot == threadSlot));
+    }
+};
+
+/* ============================================================================================= */
+// Class MemTraceFileReader
+/* ============================================================================================= */
+/*!
+ * Reader of a memorytrace_compressed.bin file in the version 1, 2 or 3 format. Traces are read sequentially, or, if
+ * the file has the thread index, thread by thread in any order. Version 3 files are mapped into memory: records are
+ * presented to visitors as in other versions, and columns are available to analyses that process them directly
+ */
+class MemTraceFileReader
+{
+public:
+    /*!
+     * @param grfSize  Size of the GRF register in bytes, which defines the size of address payloads.
+     *                 If 0, the size is detected by checking which GRF size matches the file size
+     */
+    explicit MemTraceFileReader(uint32_t grfSize = 0);
+    ~MemTraceFileReader();
+
+    /// Open the trace file and read static information about SLM accesses
+    bool Open(const std::string& path);
+
+    /// Read all per-thread traces and pass the records to the visitor
+    bool Process(MemTraceVisitor& visitor);
+
+    /*!
+     * Read traces of the specified threads and pass the records to the visitor. Requires the thread index
+     * @param threads  Indices of threads in ThreadIndex()
+     */
+    bool ProcessThreads(MemTraceVisitor& visitor, const std::vector<uint32_t>& threads);
+
+    /// @return Indices of threads in ThreadIndex() that match the filter
+    std::vector<uint32_t> SelectThreads(const MemTraceThreadFilter& filter) const;
+
+    /// @return Static information about the specified BBL, or nullptr if the BBL is not recorded in the file
+    const MemTraceBblInfo* GetBblInfo(uint32_t bblId) const;
+
+    const std::vector<MemTraceBblInfo>& Bbls()          const { return _bbls; }
+    uint32_t                            GrfSize()       const { return _grfSize; }
+    uint32_t                            Version()       const { return _version; }
+    uint32_t                            NumThreads()    const { return _numThreads; }
+    const std::string&                  Path()          const { return _path; }
+    const std::string&                  Error()         const { return _error; }
+    bool                                HasIndex()      const { return !_threadIndex.empty(); }
+
+    const MemTraceThreadIndex&          ThreadIndex()   const { return _threadIndex; }   ///< Empty if the file has no index
+    const MemTraceColumns&              Columns()       const { return _columns; }       ///< Empty unless version 3
+
+private:
+    /// Read a value of type T in binary format
+    template <typename T> bool Load(T& val) { return (bool)_fs.read((char*)&val, sizeof(T)); }
+
+    /// Compute sizes of address payloads for the specified GRF size
+    void ComputePayloadLayout(uint32_t grfSize);
+
+    /*!
+     * Read the thread index if the file ends with a valid index trailer. Otherwise, the file has no index.
+     * @return false if the index trailer is valid, but the index could not be read
+     */
+    bool ReadThreadIndex();
+
+    /// Read the thread table and the columns header of the version 3 format, and map the columns
+    bool ReadColumns();
+
+    /// Walk through the per-thread traces without processing them.
+    /// @return true if the traces end exactly at the end of traces (the thread index or the end of file)
+    bool CheckLayout();
+
+    /// Read the header of the current thread and its records, and pass them to the visitor
+    bool ProcessThread(MemTraceVisitor& visitor);
+
+    /// Read records of the current thread in the version 1 format and pass them to the visitor
+    bool ProcessRawThread(MemTraceVisitor& visitor, uint32_t numRecords);
+
+    /// Decode records of the current thread in the version 2 format and pass them to the visitor
+    bool ProcessEncodedThread(MemTraceVisitor& visitor, uint32_t numRecords);
+
+    /*!
+     * Pass records of the thread in the version 3 format to the visitor: with addresses in the address column if
+     * the visitor consumes columns, or with restored address payloads otherwise
+     * @param index  Index of the thread in the thread table
+     */
+    bool ProcessColumnarThread(MemTraceVisitor& visitor, uint32_t index);
+
+    bool Fail(const std::string& msg) { _error = _path + ": " + msg; return false; }
+
+private:
+    static const size_t _streamBufferSize = 0x100000;  ///< Size of the file stream buffer
+
+    std::ifstream                        _fs;                ///< Trace file stream
+    std::vector<char>                    _streamBuffer;      ///< Buffer of the file stream
+    std::string                          _path;              ///< Path to the trace file
+    std::string                          _error;             ///< Description of the last error
+    uint32_t                             _grfSize;           ///< Size of the GRF register in bytes
+    uint32_t                             _version = 1;       ///< Version of the file format
+    std::unique_ptr<MemTraceDecoder>     _decoder;           ///< Decoder of thread traces in the version 2 format
+    uint64_t                             _fileSize = 0;      ///< Size of the trace file
+    std::streamoff                       _tracesOffset = 0;  ///< File offset of per-thread traces
+    uint64_t                             _tracesEnd = 0;     ///< File offset of the end of per-thread traces
+    bool                                 _hasIndex = false;  ///< The file has the thread index
+    MemTraceThreadIndex                  _threadIndex;       ///< Thread index
+    uint32_t                             _numThreads = 0;    ///< Number of profiled threads
+    std::vector<MemTraceBblInfo>         _bbls;              ///< Static information about BBLs that access SLM
+    std::vector<int32_t>                 _bblIndex;          ///< BBL ID -> index in _bbls, or -1
+    std::vector<uint8_t>                 _payload;           ///< Address payloads of the current record
+    std::unique_ptr<MappedFile>          _mappedFile;        ///< Mapping of the file in the version 3 format
+    MemTraceColumns                      _columns;           ///< Columns of the file in the version 3 format
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the sampling parameters of traces
+ */
+
+#include <cstdlib>
+#include <fstream>
+
+#include "trace_sampling.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// Write the field of the thread filter
+static void WriteFilterField(const char* key, uint32_t value, ostream& os)
+{
+    os << key << " ";
+    if (value == MemTraceThreadFilter::ANY) { os << "any"; } else { os << value; }
+    os << "\n";
+}
+
+/// Parse the field of the thread filter. @return false if the value is neither "any" nor a number
+static bool ParseFilterField(const string& str, uint32_t& value)
+{
+    if (str == "any")
+    {
+        value = MemTraceThreadFilter::ANY;
+        return true;
+    }
+    char*         end;
+    unsigned long number = strtoul(str.c_str(), &end, 0);
+    if (str.empty() || (str[0] == '-') || (*end != '\0') || (number >= MemTraceThreadFilter::ANY)) { return false; }
+    value = (uint32_t)number;
+    return true;
+}
+
+/* ============================================================================================= */
+// MemTraceSampling implementation
+/* ============================================================================================= */
+double MemTraceSampling::Scale() const
+{
+    double scale = 1;
+    if (numTracedDispatches != 0)
+    {
+        scale *= double(numDispatches) / double(numTracedDispatches);
+    }
+    if (numTracedThreads != 0)
+    {
+        scale *= double(numThreads) / double(numTracedThreads);
+    }
+    return scale;
+}
+
+void MemTraceSampling::Write(ostream& os) const
+{
+    os << "dispatch_percent " << dispatchPercent << "\n"
+       << "dispatches " << numDispatches << "\n"
+       << "traced_dispatches " << numTracedDispatches << "\n";
+    WriteFilterField("slice", threads.sliceId, os);
+    WriteFilterField("subslice", threads.subSliceId, os);
+    WriteFilterField("eu", threads.euId, os);
+    WriteFilterField("thread_slot", threads.threadSlot, os);
+    os << "threads " << numThreads << "\n"
+       << "traced_threads " << numTracedThreads << "\n";
+}
+
+bool MemTraceSampling::Read(istream& is)
+{
+    *this = MemTraceSampling();
+    string key;
+    string value;
+    while (is >> key >> value)
+    {
+        bool isValid = true;
+        if (key == "dispatch_percent")          { isValid = ParseFilterField(value, dispatchPercent) && (dispatchPercent != 0) &&
+                                                            (dispatchPercent <= 100); }
+        else if (key == "dispatches")           { numDispatches       = strtoull(value.c_str(), nullptr, 0); }
+        else if (key == "traced_dispatches")    { numTracedDispatches = strtoull(value.c_str(), nullptr, 0); }
+        else if (key == "slice")                { isValid = ParseFilterField(value, threads.sliceId); }
+        else if (key == "subslice")             { isValid = ParseFilterField(value, threads.subSliceId); }
+        else if (key == "eu")                   { isValid = ParseFilterField(value, threads.euId); }
+        else if (key == "thread_slot")          { isValid = ParseFilterField(value, threads.threadSlot); }
+        else if (key == "threads")              { numThreads       = (uint32_t)strtoul(value.c_str(), nullptr, 0); }
+        else if (key == "traced_threads")       { numTracedThreads = (uint32_t)strtoul(value.c_str(), nullptr, 0); }
+        if (!isValid) { return false; }         // Unknown keys are skipped, for compatibility with newer files
+    }
+    return is.eof() && (numTracedDispatches <= numDispatches) && (numTracedThreads <= numThreads);
+}
+
+bool MemTraceSampling::Load(const string& path)
+{
+    ifstream is(path);
+    return is && Read(is);
+}
@@ -0,0 +1,70 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Statistical sampling of traces: parameters of the sampling and scaling of sampled counts to full-run estimates
+ */
+
+#ifndef TRACE_SAMPLING_H_
+#define TRACE_SAMPLING_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "trace_reader.h"
+
+/// Name of the file that records the sampling parameters of a kernel, stored in the kernel directory
+static const char* const MEMTRACE_SAMPLING_FILE_NAME = "memorytrace_sampling.txt";
+
+/* ============================================================================================= */
+// Struct MemTraceSampling
+/* ============================================================================================= */
+/*!
+ * Sampling of traces of a kernel: a fraction of its dispatches and a subset of hardware threads are traced.
+ * The parameters are stored with traces, so that analyzers can scale dynamic counts of the sample back to
+ * full-run estimates. The file is a list of "<key> <value>" lines; fields of the thread filter are "any"
+ * if they match all values
+ */
+struct MemTraceSampling
+{
+    uint32_t                dispatchPercent     = 100;  ///< Percentage of dispatches of the kernel that are traced
+    MemTraceThreadFilter    threads;                    ///< Traced hardware threads
+    uint64_t                numDispatches       = 0;    ///< Number of dispatches selected by kernel and dispatch filters
+    uint64_t                numTracedDispatches = 0;    ///< Number of traced dispatches
+    uint32_t                numThreads          = 0;    ///< Number of hardware threads of the platform
+    uint32_t                numTracedThreads    = 0;    ///< Number of hardware threads that match the thread filter
+
+    /// @return true if only a part of dispatches or threads is traced
+    bool IsEnabled() const { return (dispatchPercent < 100) || !threads.IsEmpty(); }
+
+    /*!
+     * @return true if the dispatch with the specified index, counted from 0 among dispatches selected by kernel and
+     *         dispatch filters, is traced. Traced dispatches are spread evenly, starting from the first one
+     */
+    bool IsDispatchTraced(uint64_t index) const { return (index * dispatchPercent) % 100 < dispatchPercent; }
+
+    /// @return Factor that scales dynamic counts of the sample to the full-run estimate, 1 if nothing is sampled
+    double Scale() const;
+
+    /// Write the parameters in the text format of the sampling file
+    void Write(std::ostream& os) const;
+
+    /*!
+     * Read the parameters in the text format of the sampling file
+     * @return false if the input is malformed
+     */
+    bool Read(std::istream& is);
+
+    /*!
+     * Read the parameters from the specified sampling file
+     * @return false if the file could not be read or is malformed
+     */
+    bool Load(const std::string& path);
+};
+
+#endif
@@ -0,0 +1,149 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Implementation of the statistics of the tool
+ */
+
+#include <algorithm>
+
+#include "hotspots.h"
+#include "trace_stats.h"
+
+using namespace std;
+
+/* ============================================================================================= */
+// Free functions
+/* ============================================================================================= */
+/// Add times and counters of the dispatch to the totals
+static void Accumulate(MemTraceDispatchStats& total, const MemTraceDispatchStats& stats)
+{
+    total.readSeconds       += stats.readSeconds;
+    total.bucketSeconds     += stats.bucketSeconds;
+    total.storeSeconds      += stats.storeSeconds;
+    total.writeSeconds      += stats.writeSeconds;
+    total.analyzeSeconds    += stats.analyzeSeconds;
+    total.bytesRead         += stats.bytesRead;
+    total.numRecords        += stats.numRecords;
+    total.numThreads         = std::max(total.numThreads, stats.numThreads);
+    total.maxThreadRecords   = std::max(total.maxThreadRecords, stats.maxThreadRecords);
+    total.isTruncated        = total.isTruncated || stats.isTruncated;
+    total.bytesWritten      += stats.bytesWritten;
+}
+
+/// Write stage times and counters of the dispatch, or of totals of a kernel, as JSON fields
+static void WriteJsonFields(const MemTraceDispatchStats& stats, ostream& os)
+{
+    os << "\"read_seconds\": " << stats.readSeconds << ", \"bucket_seconds\": " << stats.bucketSeconds
+       << ", \"store_seconds\": " << stats.storeSeconds << ", \"write_seconds\": " << stats.writeSeconds
+       << ", \"analyze_seconds\": " << stats.analyzeSeconds << ", \"bytes_read\": " << stats.bytesRead
+       << ", \"records\": " << stats.numRecords << ", \"bytes_written\": " << stats.bytesWritten;
+}
+
+/* ============================================================================================= */
+// MemTraceStats implementation
+/* ============================================================================================= */
+void MemTraceStats::AddKernel(const MemTraceKernelStats& stats)
+{
+    lock_guard<mutex> lock(_mutex);
+    MemTraceKernelStats& kernel = _kernels[stats.name];
+    kernel.name               = stats.name;
+    kernel.instrumentSeconds += stats.instrumentSeconds;
+    kernel.traceCapacity      = std::max(kernel.traceCapacity, stats.traceCapacity);
+    kernel.maxTraceSize       = std::max(kernel.maxTraceSize, stats.maxTraceSize);
+}
+
+void MemTraceStats::AddDispatch(const MemTraceDispatchStats& stats)
+{
+    lock_guard<mutex> lock(_mutex);
+    auto ret = _dispatches.emplace(DispatchKey(stats.kernel, stats.dispatch), stats);
+    if (!ret.second)
+    {
+        Accumulate(ret.first->second, stats);
+    }
+}
+
+void MemTraceStats::WriteJson(ostream& os) const
+{
+    lock_guard<mutex> lock(_mutex);
+
+    // Totals of dispatches of each kernel. Kernels without statistics of their own are reported too
+    struct KernelTotals
+    {
+        MemTraceKernelStats     kernel;
+        MemTraceDispatchStats   dispatches;
+        uint64_t                numDispatches           = 0;
+        uint64_t                numTruncatedDispatches  = 0;
+    };
+    map<string, KernelTotals> kernels;
+    for (const auto& entry : _kernels)
+    {
+        kernels[entry.first].kernel = entry.second;
+    }
+    for (const auto& entry : _dispatches)
+    {
+        const MemTraceDispatchStats& stats  = entry.second;
+        KernelTotals&                totals = kernels[stats.kernel];
+        totals.kernel.name = stats.kernel;
+        Accumulate(totals.dispatches, stats);
+        totals.numDispatches++;
+        if (stats.isTruncated) { totals.numTruncatedDispatches++; }
+    }
+
+    os << "{\n  \"kernels\": [";
+    const char* sep = "";
+    for (const auto& entry : kernels)
+    {
+        const KernelTotals& totals = entry.second;
+        os << sep << "\n    {\"name\": ";
+        WriteJsonString(totals.kernel.name, os);
+        os << ", \"instrument_seconds\": " << totals.kernel.instrumentSeconds
+           << ", \"trace_capacity\": " << totals.kernel.traceCapacity << ", \"max_trace_size\": " << totals.kernel.maxTraceSize
+           << ", \"dispatches\": " << totals.numDispatches << ", \"truncated_dispatches\": " << totals.numTruncatedDispatches
+           << ", ";
+        WriteJsonFields(totals.dispatches, os);
+        os << "}";
+        sep = ",";
+    }
+
+    os << "\n  ],\n  \"dispatches\": [";
+    sep = "";
+    for (const auto& entry : _dispatches)
+    {
+        const MemTraceDispatchStats& stats = entry.second;
+        os << sep << "\n    {\"kernel\": ";
+        WriteJsonString(stats.kernel, os);
+        os << ", \"dispatch\": " << stats.dispatch << ", ";
+        WriteJsonFields(stats, os);
+        os << ", \"threads\": " << stats.numThreads << ", \"max_thread_records\": " << stats.maxThreadRecords
+           << ", \"truncated\": " << (stats.isTruncated ? "true" : "false") << "}";
+        sep = ",";
+    }
+    os << "\n  ]\n}\n";
+}
+
+void MemTraceStats::WriteCsv(ostream& os) const
+{
+    lock_guard<mutex> lock(_mutex);
+    os << "kernel,dispatch,read_seconds,bucket_seconds,store_seconds,write_seconds,analyze_seconds,bytes_read,records,"
+          "threads,max_thread_records,truncated,bytes_written\n";
+    for (const auto& entry : _dispatches)
+    {
+        const MemTraceDispatchStats& stats = entry.second;
+
+        // Kernel names are quoted, since they may contain commas
+        os << '"';
+        for (char c : stats.kernel)
+        {
+            if (c == '"') { os << '"'; }
+            os << c;
+        }
+        os << "\"," << stats.dispatch << "," << stats.readSeconds << "," << stats.bucketSeconds << "," << stats.storeSeconds
+           << "," << stats.writeSeconds << "," << stats.analyzeSeconds << "," << stats.bytesRead << "," << stats.numRecords
+           << "," << stats.numThreads << "," << stats.maxThreadRecords << "," << (stats.isTruncated ? 1 : 0)
+           << "," << stats.bytesWritten << "\n";
+    }
+}
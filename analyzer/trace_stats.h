@@ -0,0 +1,111 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Statistics of the tool itself: time spent in processing stages and counters of traces, per kernel and
+ *       per dispatch, for finding the source of the tool's overhead and tuning trace buffer sizes
+ */
+
+#ifndef TRACE_STATS_H_
+#define TRACE_STATS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+/* ============================================================================================= */
+// Class Stopwatch
+/* ============================================================================================= */
+/*!
+ * Measures the time elapsed since the construction
+ */
+class Stopwatch
+{
+public:
+    Stopwatch() : _start(std::chrono::steady_clock::now()) {}
+
+    /// @return Seconds elapsed since the construction
+    double Seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+
+private:
+    std::chrono::steady_clock::time_point _start;   ///< Construction time
+};
+
+/* ============================================================================================= */
+// Struct MemTraceKernelStats
+/* ============================================================================================= */
+/*!
+ * Statistics of a kernel that do not depend on its dispatches
+ */
+struct MemTraceKernelStats
+{
+    std::string name;                       ///< Kernel name
+    double      instrumentSeconds   = 0;    ///< Instrumentation of the kernel
+    uint64_t    traceCapacity       = 0;    ///< Capacity of the profile buffer in bytes
+    uint64_t    maxTraceSize        = 0;    ///< Max size of dispatch traces in profile buffers
+};
+
+/* ============================================================================================= */
+// Struct MemTraceDispatchStats
+/* ============================================================================================= */
+/*!
+ * Statistics of a traced dispatch. Stages are measured where they run, so the statistics of a dispatch are
+ * accumulated from several parts (see MemTraceStats::AddDispatch)
+ */
+struct MemTraceDispatchStats
+{
+    std::string kernel;                     ///< Kernel name
+    uint64_t    dispatch            = 0;    ///< Index of the traced dispatch of the kernel, counted from 0
+    double      readSeconds         = 0;    ///< Copying the trace from the profile buffer
+    double      bucketSeconds       = 0;    ///< Grouping records by threads
+    double      storeSeconds        = 0;    ///< Serializing and writing the trace file
+    double      writeSeconds        = 0;    ///< Part of storeSeconds spent in file writes
+    double      analyzeSeconds      = 0;    ///< Conflict analysis of the trace ("analyze" mode)
+    uint64_t    bytesRead           = 0;    ///< Bytes of records copied from the profile buffer
+    uint64_t    numRecords          = 0;    ///< Number of parsed records
+    uint32_t    numThreads          = 0;    ///< Number of threads that have records
+    uint64_t    maxThreadRecords    = 0;    ///< Max number of records of a thread
+    bool        isTruncated         = false;///< The trace overflowed the profile buffer
+    uint64_t    bytesWritten        = 0;    ///< Size of the trace file
+};
+
+/* ============================================================================================= */
+// Class MemTraceStats
+/* ============================================================================================= */
+/*!
+ * Thread-safe collection of statistics of kernels and dispatches
+ */
+class MemTraceStats
+{
+public:
+    /// Add statistics of the kernel. Times of the same kernel are summed, sizes are maximized
+    void AddKernel(const MemTraceKernelStats& stats);
+
+    /// Add a part of statistics of the dispatch. Times and counters of the same dispatch are summed
+    void AddDispatch(const MemTraceDispatchStats& stats);
+
+    /*!
+     * Write statistics in JSON format: { "kernels": [...], "dispatches": [...] }. Kernel entries also include
+     * totals of their dispatches
+     */
+    void WriteJson(std::ostream& os) const;
+
+    /// Write statistics of dispatches in CSV format, one dispatch per line
+    void WriteCsv(std::ostream& os) const;
+
+private:
+    using DispatchKey = std::pair<std::string, uint64_t>;   ///< Kernel name, dispatch index
+
+    mutable std::mutex                              _mutex;         ///< Protects the statistics
+    std::map<std::string, MemTraceKernelStats>      _kernels;       ///< Kernel name -> statistics
+    std::map<DispatchKey, MemTraceDispatchStats>    _dispatches;    ///< Dispatch -> statistics
+};
+
+#endif
@@ -8,9 +8,12 @@ SPDX-License-Identifier: MIT
  * @file Implementation of the Memorytrace tool
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 
-#include "memorytrace.h"
+#include "localmemorytrace.h"
 #include "gtpin_tool_utils.h"
 
 using namespace gtpin;
@@ -20,7 +23,202 @@ using namespace std;
 // Configuration
 /* ============================================================================================= */
 Knob<int>  knobMaxTraceBufferInMB("max_buffer_mb", 3072, "memorytrace - the max allowed size of the trace buffer per kernel in MB\n");
-Knob<int>  knobPhase("phase", 0, "tracing tool - processing phase\n { 1 - pre-processing, 2 - processing - trace gathering} ");
+Knob<int>  knobPhase("phase", 0, "tracing tool - processing phase\n { 0 - single pass, trace sizes are taken from the trace size cache,\n"
+                                 "   1 - pre-processing, 2 - processing - trace gathering} ");
+Knob<int>  knobDefaultTraceBufferInMB("default_buffer_mb", 256, "memorytrace - the size of the trace buffer per kernel in MB used in the\n"
+                                                                "single-pass mode for kernels missing in the trace size cache\n");
+Knob<string> knobTraceSizeCache("trace_size_cache", "memorytrace_size_cache.txt", "memorytrace - file that stores trace sizes of kernels\n"
+                                                                                  "across runs of the single-pass mode\n");
+Knob<bool> knobAnalyze("analyze", false, "localmemorytrace - analyze SLM bank conflicts while the application runs and store\n"
+                                         "conflict histograms instead of full traces\n");
+Knob<string> knobBankModel("bank_model", "auto", "localmemorytrace - SLM bank model used in the analyze mode\n"
+                                                " {auto - selected by the GPU platform of the kernel, dword, gen9, xe-hpc}\n");
+Knob<int>  knobNumBanks("num_banks", 0, "localmemorytrace - number of SLM banks used in the analyze mode\n"
+                                        " {0 - number of banks of the SLM bank model}\n");
+Knob<bool> knobStream("stream", false, "localmemorytrace - store traces by a background thread as soon as kernel dispatches complete\n");
+Knob<int>  knobStreamQueue("stream_queue", 4, "localmemorytrace - max number of dispatch traces pending to be stored in the stream mode\n");
+Knob<int>  knobPostProcessThreads("post_process_threads", 0, "localmemorytrace - number of threads that store traces at exit\n"
+                                                             " {0 - number of hardware threads, 1 - serial processing}\n");
+Knob<int>  knobTraceFormat("trace_format", 1, "localmemorytrace - version of the trace file format\n"
+                                              " {1 - raw address payloads, 2 - delta/varint encoded channel addresses,\n"
+                                              "  3 - columnar: aligned columns of BBL IDs, execution masks and SLM channel addresses}\n");
+Knob<string> knobKernelFilter("kernel_filter", "", "localmemorytrace - comma-separated names or glob patterns of kernels to be traced.\n"
+                                                  "Both kernel names and extended kernel names are matched. By default, all kernels are traced\n");
+Knob<string> knobKernelExclude("kernel_exclude", "", "localmemorytrace - comma-separated names or glob patterns of kernels that are not traced\n");
+Knob<string> knobDispatchRange("dispatch_range", "", "localmemorytrace - range of traced dispatches of each kernel, counted from 0\n"
+                                                     " {first-last, first-, -last or index. By default, all dispatches are traced}\n");
+Knob<int>  knobTraceSegmentMB("trace_segment_mb", 64, "localmemorytrace - size of segments in which dispatch traces are copied from\n"
+                                                      "profile buffers in MB\n");
+Knob<bool> knobTraceIndex("trace_index", false, "localmemorytrace - append the thread index to trace files, so that analyzers can read\n"
+                                               "traces of threads in parallel or select threads by slice, subslice and EU\n");
+Knob<bool> knobDirectIo("direct_io", false, "localmemorytrace - store trace files with unbuffered I/O that bypasses the page cache\n");
+Knob<bool> knobCaptureRaw("capture_raw", false, "localmemorytrace - also store raw dispatch traces in memorytrace_dispatch.raw files,\n"
+                                                "which can be post-processed offline by memtrace_replay\n");
+Knob<int>  knobSampleDispatchPercent("sample_dispatch_percent", 100, "localmemorytrace - percentage of dispatches of each kernel that are\n"
+                                                                     "traced, spread evenly over dispatches selected by dispatch_range\n");
+Knob<int>  knobSampleSlice("sample_slice", -1, "localmemorytrace - trace hardware threads of the specified slice only {-1 - all slices}\n");
+Knob<int>  knobSampleSubSlice("sample_subslice", -1, "localmemorytrace - trace hardware threads of the specified subslice only\n"
+                                                     " {-1 - all subslices}\n");
+Knob<int>  knobSampleEu("sample_eu", -1, "localmemorytrace - trace hardware threads of the specified EU only {-1 - all EUs}\n");
+Knob<int>  knobSampleThreadSlot("sample_thread_slot", -1, "localmemorytrace - trace hardware threads of the specified thread slot of\n"
+                                                          "the EU only {-1 - all thread slots}. Other threads do not allocate\n"
+                                                          "records in the profile buffer\n");
+Knob<bool> knobStats("stats", false, "localmemorytrace - store times of processing stages and trace counters of the tool per kernel\n"
+                                     "and dispatch in memorytrace_stats.json and memorytrace_stats.csv, and report the write\n"
+                                     "throughput of stored traces at exit\n");
+
+/* ============================================================================================= */
+// Kernel and dispatch selection
+/* ============================================================================================= */
+/// @return true if the kernel is selected for tracing by the kernel_filter and kernel_exclude knobs
+static bool IsKernelTraced(const IGtKernel& kernel)
+{
+    static const KernelFilter filter(knobKernelFilter, knobKernelExclude);
+    return filter.IsEmpty() || filter.Matches(GlueString(kernel.Name()), ExtendedKernelName(kernel));
+}
+
+/// @return Range of traced dispatches of each kernel, specified by the dispatch_range knob
+static const DispatchRange& TracedDispatches()
+{
+    static const DispatchRange range = []
+    {
+        DispatchRange dispatchRange;
+        if (!dispatchRange.Parse(knobDispatchRange))
+        {
+            GTPIN_ERROR_MSG("MEMORYTRACE: Invalid dispatch range " + string(knobDispatchRange));
+        }
+        return dispatchRange;
+    }();
+    return range;
+}
+
+/*!
+ * @return Sampling of traces specified by the sample_* knobs. Counts of dispatches and threads are filled by
+ *         each kernel
+ */
+static const MemTraceSampling& TraceSampling()
+{
+    static const MemTraceSampling sampling = []
+    {
+        auto filterField = [](int value) { return (value < 0) ? MemTraceThreadFilter::ANY : uint32_t(value); };
+        MemTraceSampling traceSampling;
+        if ((knobSampleDispatchPercent <= 0) || (knobSampleDispatchPercent > 100))
+        {
+            GTPIN_ERROR_MSG("MEMORYTRACE: Invalid percentage of sampled dispatches " + to_string(knobSampleDispatchPercent));
+        }
+        traceSampling.dispatchPercent       = uint32_t(knobSampleDispatchPercent);
+        traceSampling.threads.sliceId       = filterField(knobSampleSlice);
+        traceSampling.threads.subSliceId    = filterField(knobSampleSubSlice);
+        traceSampling.threads.euId          = filterField(knobSampleEu);
+        traceSampling.threads.threadSlot    = filterField(knobSampleThreadSlot);
+        return traceSampling;
+    }();
+    return sampling;
+}
+
+/// @return Statistics of the tool, collected if the stats knob is set
+static MemTraceStats& ToolStats()
+{
+    static MemTraceStats stats;
+    return stats;
+}
+
+/*!
+ * Drop records of threads that do not match the filter from the raw trace. Records of selected threads are moved
+ * to the beginning of the trace, in their original order
+ * @return Size of the records of selected threads
+ */
+static uint64_t SelectThreadRecords(const MemTraceKernelLayout& layout, const MemTraceThreadFilter& filter,
+                                    uint8_t* trace, uint64_t traceSize)
+{
+    uint8_t* selectedEnd = trace;
+    ForEachRawRecord(layout, trace, traceSize, [&](const MemTraceRecordHeader* header, uint32_t recordSize)
+    {
+        if (filter.Matches(layout.threads[layout.sr0Tids[header->sr0]]))
+        {
+            if (selectedEnd != (const uint8_t*)header)
+            {
+                memmove(selectedEnd, header, recordSize);
+            }
+            selectedEnd += recordSize;
+        }
+    });
+    return uint64_t(selectedEnd - trace);
+}
+
+/*!
+ * Express the thread filter as a test of sr0.0 bits, so that the instrumentation can skip records of threads that
+ * are not sampled: a thread is selected iff (sr0.0 & mask) == value. sr0 values that do not identify a hardware
+ * thread of the kernel's platform are ignored
+ * @return false if no thread matches the filter, or the selected threads cannot be identified by sr0.0 bits
+ */
+static bool Sr0ThreadSelection(const MemTraceKernelLayout& layout, const MemTraceThreadFilter& filter,
+                               uint32_t& mask, uint32_t& value)
+{
+    enum : uint8_t { INVALID, SKIPPED, SELECTED };
+    std::vector<uint8_t> state(MEMTRACE_NUM_SR0_VALUES);
+    for (uint32_t sr0 = 0; sr0 != MEMTRACE_NUM_SR0_VALUES; sr0++)
+    {
+        uint32_t gtid = layout.sr0Tids[sr0];
+        state[sr0] = (gtid >= layout.NumThreads()) ? INVALID : (filter.Matches(layout.threads[gtid]) ? SELECTED : SKIPPED);
+    }
+
+    // Bits that tell selected threads from the others in any pair of sr0 values
+    mask = 0;
+    uint32_t firstSelected = MEMTRACE_NUM_SR0_VALUES;
+    for (uint32_t sr0 = 0; sr0 != MEMTRACE_NUM_SR0_VALUES; sr0++)
+    {
+        if (state[sr0] == INVALID) { continue; }
+        if ((state[sr0] == SELECTED) && (firstSelected == MEMTRACE_NUM_SR0_VALUES)) { firstSelected = sr0; }
+        for (uint32_t bit = 1; bit != MEMTRACE_NUM_SR0_VALUES; bit <<= 1)
+        {
+            uint8_t other = state[sr0 ^ bit];
+            if ((other != INVALID) && (other != state[sr0])) { mask |= bit; }
+        }
+    }
+    if (firstSelected == MEMTRACE_NUM_SR0_VALUES) { return false; }
+    value = firstSelected & mask;
+
+    for (uint32_t sr0 = 0; sr0 != MEMTRACE_NUM_SR0_VALUES; sr0++)
+    {
+        if ((state[sr0] != INVALID) && ((state[sr0] == SELECTED) != ((sr0 & mask) == value))) { return false; }
+    }
+    return true;
+}
+
+/*!
+ * @return Platform of the SLM bank model of the kernel. Gen12 platforms (Xe-LP through Xe-HPC) share the GPU platform
+ *         and differ in the GRF size; platforms unknown to the bank models are identified by the GRF size
+ */
+static SlmPlatform KernelSlmPlatform(GtGpuPlatform platform, const IGtGenModel& genModel)
+{
+    switch (platform)
+    {
+    case GPU_GEN9:  return SlmPlatform::GEN9;
+    case GPU_GEN11: return SlmPlatform::GEN11;
+    case GPU_GEN12: return (genModel.GrfRegSize() >= 64) ? SlmPlatform::XE_HPC : SlmPlatform::XE_LP;
+    default:        return SlmPlatform::UNKNOWN;
+    }
+}
+
+/// @return SLM bank model of the kernel's platform, selected by the bank_model and num_banks knobs
+static SlmBankConfig KernelBankModel(GtGpuPlatform platform, const IGtGenModel& genModel)
+{
+    SlmBankConfig config;
+    if (!SlmBankConfig::FromName(knobBankModel, genModel.GrfRegSize(), config, KernelSlmPlatform(platform, genModel)))
+    {
+        GTPIN_ERROR_MSG("MEMORYTRACE: Unknown SLM bank model " + string(knobBankModel));
+    }
+    if (knobNumBanks > 0)
+    {
+        config.numBanks = (uint32_t)knobNumBanks;
+    }
+    if (!config.IsValid())
+    {
+        GTPIN_ERROR_MSG("MEMORYTRACE: Invalid number of SLM banks " + to_string(config.numBanks));
+    }
+    return config;
+}
 
 /* ============================================================================================= */
 // BblMemAccessInfo implementation
@@ -42,7 +240,7 @@ BblMemAccessInfo& BblMemAccessInfo::Build(const IGtKernelInstrument& kernelInstr
             if ((msg.IsValid() || ins.IsEot()) && msg.IsSlm())
             {
                 addrPayloadSize += (msg.AddrPayloadLength() * genModel.GrfRegSize());   // Accumulate SEND address payloads
-                headerSize = MemTraceRecordHeader::AlignedSize(genModel);               // Add one trace record header per BBL
+                headerSize = MemTraceRecordHeader::AlignedSize(genModel.GrfRegSize());   // Add one trace record header per BBL
                 _memInstructions.emplace_back(MemIns{ins.Id(), cfg.GetInstructionOffset(ins), std::move(msg)});
             }
         }
@@ -56,9 +254,12 @@ BblMemAccessInfo& BblMemAccessInfo::Build(const IGtKernelInstrument& kernelInstr
 /* ============================================================================================= */
 KernelMemAccessInfo& KernelMemAccessInfo::Build(const IGtKernelInstrument& kernelInstrument)
 {
-    const IGtCfg&  cfg = kernelInstrument.Cfg();
+    const IGtCfg&       cfg      = kernelInstrument.Cfg();
+    const IGtGenModel&  genModel = kernelInstrument.Kernel().GenModel();
 
     _memAccessMap.clear();
+    _layout = MemTraceKernelLayout();
+    _layout.grfSize = genModel.GrfRegSize();
     _maxRecordSize = 0;
     for (auto bblPtr : cfg.Bbls())
     {
@@ -67,12 +268,45 @@ KernelMemAccessInfo& KernelMemAccessInfo::Build(const IGtKernelInstrument& kerne
         if (!bblMemAccessInfo.IsEmpty())
         {
             _maxRecordSize = std::max(_maxRecordSize, bblMemAccessInfo.RecordSize());
+            for (const auto& memIns : bblMemAccessInfo.MemInstructions())
+            {
+                _layout.AddMemIns(bbl.Id(), PackedMemIns(memIns));
+            }
+            GTPIN_ASSERT(_layout.RecordSize(bbl.Id()) == bblMemAccessInfo.RecordSize());
             _memAccessMap.emplace(bbl.Id(), std::move(bblMemAccessInfo));
         }
     }
+    BuildThreadMap(genModel);
     return *this;
 }
 
+void KernelMemAccessInfo::BuildThreadMap(const IGtGenModel& genModel)
+{
+    const GtStateRegAccessor& sra = genModel.StateRegAccessor();
+
+    // sr0 -> global thread ID, resolved for all possible values of sr0.0[0:15] in the record header
+    _layout.sr0Tids.resize(MEMTRACE_NUM_SR0_VALUES);
+    for (uint32_t sr0 = 0; sr0 != MEMTRACE_NUM_SR0_VALUES; sr0++)
+    {
+        _layout.sr0Tids[sr0] = sra.GetGlobalTid(sr0);
+    }
+
+    // Global thread ID -> fields of the thread identifier, as stored in the trace file
+    _layout.threads.resize(genModel.MaxThreads());
+    for (uint32_t gtid = 0; gtid != _layout.NumThreads(); gtid++)
+    {
+        uint32_t sr0 = sra.SetGlobalTid(0, gtid);
+        auto getSr0Field = [&](const ScatteredBitFieldU32& sbf) { return (sbf.IsEmpty() ? UINT32_MAX : sbf.GetValue(sr0)); };
+
+        MemTraceGlobalTid& thread = _layout.threads[gtid];
+        thread.sliceId          = getSr0Field(sra.SliceIdField());
+        thread.dualSubSliceId   = getSr0Field(sra.DualSubSliceIdField());
+        thread.subSliceId       = getSr0Field(sra.SubSliceIdField());
+        thread.euId             = getSr0Field(sra.EuIdField());
+        thread.threadSlot       = getSr0Field(sra.ThreadSlotField());
+    }
+}
+
 const BblMemAccessInfo* KernelMemAccessInfo::GetBblInfo(BblId bblId) const 
 {
     auto it = _memAccessMap.find(bblId);
@@ -82,17 +316,77 @@ const BblMemAccessInfo* KernelMemAccessInfo::GetBblInfo(BblId bblId) const
 /* ============================================================================================= */
 // MemTraceDispatch implementation
 /* ============================================================================================= */
-bool MemTraceDispatch::ReadTrace(const GtProfileTrace& traceAccessor, const IGtProfileBuffer& profileBuffer)
+bool MemTraceDispatch::ReadTrace(const GtProfileTrace& traceAccessor, const IGtProfileBuffer& profileBuffer,
+                                 const MemTraceKernelLayout& layout, const MemTraceThreadFilter& threadFilter)
 {
-    uint32_t traceSize = traceAccessor.Size(profileBuffer);
-    _rawTrace.resize(traceSize);
+    Stopwatch stopwatch;
+    _traceSize = traceAccessor.Size(profileBuffer);
+    _bytesRead = 0;
     _isTrimmed = traceAccessor.IsTruncated(profileBuffer);
-    return traceAccessor.Read(profileBuffer, _rawTrace.data(), 0, traceSize);
+    _segments.clear();
+
+    // Each segment starts with the incomplete record carried over from the end of the previous segment, followed
+    // by the next chunk of the profile buffer. Offsets in the profile buffer are 32-bit in the GTPin API
+    uint64_t       chunkSize = uint64_t(std::max(int(knobTraceSegmentMB), 1)) * 0x100000;
+    const uint8_t* carry     = nullptr; // Incomplete record at the end of the previous segment
+    uint64_t       carrySize = 0;
+    for (uint64_t offset = 0, i = 0; offset < _traceSize; i++)
+    {
+        if (i == _buffers.size()) { _buffers.emplace_back(); }
+        vector<uint8_t>& buffer = _buffers[i];
+        uint64_t         size   = std::min(chunkSize, _traceSize - offset);
+        buffer.resize(carrySize + size);
+        if (carrySize != 0)
+        {
+            memcpy(buffer.data(), carry, carrySize);
+        }
+        if (!traceAccessor.Read(profileBuffer, buffer.data() + carrySize, uint32_t(offset), uint32_t(size)))
+        {
+            return false;
+        }
+        offset     += size;
+        _bytesRead += size;
+
+        bool     isEnd       = false;
+        uint64_t segmentSize = CompleteRawRecordsSize(layout, buffer.data(), buffer.size(), isEnd);
+        carry     = buffer.data() + segmentSize;
+        carrySize = buffer.size() - segmentSize;
+        if (!threadFilter.IsEmpty())
+        {
+            // The instrumentation skips records of threads that are not sampled; the filter drops the remaining ones
+            // if the selection could not be expressed by sr0 bits. Records of selected threads are compacted at the
+            // beginning of the buffer. The carried record stays in place
+            segmentSize = SelectThreadRecords(layout, threadFilter, buffer.data(), segmentSize);
+        }
+        if (segmentSize != 0)
+        {
+            _segments.push_back(MemTraceRawSegment{buffer.data(), segmentSize});
+        }
+        if (isEnd) { break; }
+    }
+    _readSeconds = stopwatch.Seconds();
+    return true;
 }
 
-bool MemTraceDispatch::IsEmpty() const
+/* ============================================================================================= */
+// MemTraceConflictProfile implementation
+/* ============================================================================================= */
+MemTraceConflictProfile::MemTraceConflictProfile(const KernelMemAccessInfo& memAccessInfo, const SlmBankConfig& bankConfig) :
+    _layout(memAccessInfo.Layout()), _histograms(bankConfig) {}
+
+uint64_t MemTraceConflictProfile::AddTrace(const MemTraceDispatch& trace)
 {
-    return _rawTrace.size() < sizeof(MemTraceRecordHeader);
+    uint32_t alignedHeaderSize = _layout.AlignedHeaderSize();
+    uint64_t numRecords        = 0;
+    ForEachRawRecord(_layout, trace.Segments(), [&](const MemTraceRecordHeader* header, uint32_t)
+    {
+        MemTraceRecord record{&_layout.bblInfos[header->bblId], header->ce & header->dm,
+                              (const uint8_t*)header + alignedHeaderSize};
+        _histograms.OnRecord(record);
+        ++numRecords;
+    });
+    ++_numDispatches;
+    return numRecords;
 }
 
 /* ============================================================================================= */
@@ -107,30 +401,60 @@ MemTraceKernel::MemTraceKernel(const IGtKernelInstrument& kernelInstrument)
     _extName    = ExtendedKernelName(kernel);
     _platform   = kernel.GpuPlatform();
     _genId      = kernel.GenModel().Id();
+    _genModel   = &kernel.GenModel();
     _asmText    = CfgAsmText(cfg);
 
     // Build static information about memory accesses in the kernel
     _memAccessInfo.Build(kernelInstrument);
 
-    // Initialize trace accessor. The trace capacity is expected to be computed during the preprocessing phase.
-    uint64_t traceCapacity =  MemoryTracePreProcessor::Instance()->TraceSize(_extName);
+    // Initialize trace accessor. The trace capacity is expected to be computed during the preprocessing phase,
+    // or taken from the trace size cache in the single-pass mode
+    uint64_t traceCapacity = (knobPhase == 2) ? MemoryTracePreProcessor::Instance()->TraceSize(_extName) :
+                                                TraceSizeCache::Instance()->TraceSize(_extName);
     if (traceCapacity == 0)
     {
-        traceCapacity = UINT32_MAX; // Unknown trace capacity
+        // Unknown trace capacity. The single-pass mode records the actual size in the cache for the next run
+        traceCapacity = (knobPhase == 2) ? UINT32_MAX : uint64_t(knobDefaultTraceBufferInMB) * 0x100000;
     }
     else
     {
-        traceCapacity += 0x2000; // Add some space to account for possible fluctuation of trace sizes between phases
+        // Add some space to account for possible fluctuation of trace sizes between phases. The capacity of
+        // the profile buffer is limited by the 32-bit sizes of GtProfileTrace; larger traces are trimmed
+        traceCapacity += 0x2000;
         if (traceCapacity > UINT32_MAX)
         {
-            GTPIN_WARNING("MEMORYTRACE: Too big trace capacity required for kernel " + _name);
+            GTPIN_WARNING("MEMORYTRACE: Trace capacity of " + to_string(traceCapacity >> 20) + " MB required for kernel " +
+                          _name + " exceeds the 4 GB limit of the profile buffer. Traces of the kernel will be trimmed");
             traceCapacity = UINT32_MAX;
         }
     }
     traceCapacity = std::min(uint64_t(knobMaxTraceBufferInMB) * 0x100000, traceCapacity);
     uint32_t maxRecordSize = _memAccessInfo.MaxRecordSize();
-    _traceAccessor = GtProfileTrace((uint32_t)traceCapacity, maxRecordSize);
+    _traceCapacity = (uint32_t)traceCapacity;
+    _traceAccessor = GtProfileTrace(_traceCapacity, maxRecordSize);
     _traceAccessor.Allocate(kernelInstrument.ProfileBufferAllocator());
+
+    if (knobAnalyze)
+    {
+        _conflictProfile.reset(new MemTraceConflictProfile(_memAccessInfo, KernelBankModel(_platform, *_genModel)));
+    }
+
+    _sampling = TraceSampling();
+    const MemTraceKernelLayout& layout = _memAccessInfo.Layout();
+    _sampling.numThreads = layout.NumThreads();
+    _sampling.numTracedThreads = (uint32_t)std::count_if(layout.threads.begin(), layout.threads.end(),
+                                                         [&](const MemTraceGlobalTid& gtid) { return _sampling.threads.Matches(gtid); });
+    if (_sampling.numTracedThreads == 0)
+    {
+        GTPIN_WARNING("MEMORYTRACE: No hardware threads match the sample_* knobs. The trace of kernel " + _name + " will be empty");
+    }
+    else if (!_sampling.threads.IsEmpty() && !Sr0ThreadSelection(layout, _sampling.threads, _sr0SampleMask, _sr0SampleValue))
+    {
+        // Trace all threads; records of the other threads are dropped when the trace is read
+        _sr0SampleMask = 0;
+        GTPIN_WARNING("MEMORYTRACE: Threads selected by the sample_* knobs cannot be identified by sr0 bits. Kernel " + _name +
+                      " traces all threads, and records of the other threads are dropped when the trace is read");
+    }
 }
 
 MemTraceDispatch& MemTraceKernel::AddMemTrace(IGtKernelDispatch& kernelDispatch)
@@ -138,21 +462,172 @@ MemTraceDispatch& MemTraceKernel::AddMemTrace(IGtKernelDispatch& kernelDispatch)
     // Create a new MemTraceDispatch object and store the entire trace within this object
     _traces.emplace_back(kernelDispatch);
     MemTraceDispatch& memTraceDispatch  = _traces.back();
-    if (!memTraceDispatch.ReadTrace(_traceAccessor, *kernelDispatch.GetProfileBuffer()))
+    if (!memTraceDispatch.ReadTrace(_traceAccessor, *kernelDispatch.GetProfileBuffer(), _memAccessInfo.Layout(), _sampling.threads))
+    {
+        GTPIN_ERROR_MSG("MEMORYTRACE: Failed to read profile buffer for kernel " + _name);
+    }
+    CountTrace(memTraceDispatch);
+    return memTraceDispatch;
+}
+
+unique_ptr<MemTraceDispatch> MemTraceKernel::ReadMemTrace(IGtKernelDispatch& kernelDispatch, MemTraceDispatch::Buffers&& buffers)
+{
+    unique_ptr<MemTraceDispatch> memTraceDispatch(new MemTraceDispatch(kernelDispatch));
+    memTraceDispatch->AdoptBuffers(std::move(buffers));
+    if (!memTraceDispatch->ReadTrace(_traceAccessor, *kernelDispatch.GetProfileBuffer(), _memAccessInfo.Layout(), _sampling.threads))
     {
         GTPIN_ERROR_MSG("MEMORYTRACE: Failed to read profile buffer for kernel " + _name);
+        return nullptr;
     }
+    CountTrace(*memTraceDispatch);
     return memTraceDispatch;
 }
 
+void MemTraceKernel::AnalyzeMemTrace(IGtKernelDispatch& kernelDispatch)
+{
+    GTPIN_ASSERT(_conflictProfile);
+
+    // The trace is released as soon as its records are folded into the conflict profile
+    MemTraceDispatch memTraceDispatch(kernelDispatch);
+    if (!memTraceDispatch.ReadTrace(_traceAccessor, *kernelDispatch.GetProfileBuffer(), _memAccessInfo.Layout(), _sampling.threads))
+    {
+        GTPIN_ERROR_MSG("MEMORYTRACE: Failed to read profile buffer for kernel " + _name);
+        return;
+    }
+    if (memTraceDispatch.IsTrimmed())
+    {
+        GTPIN_WARNING("MEMORYTRACE: Detected trace buffer overflow in kernel " + _name);
+    }
+    CountTrace(memTraceDispatch);
+
+    Stopwatch stopwatch;
+    uint64_t  numRecords = _conflictProfile->AddTrace(memTraceDispatch);
+    if (knobStats)
+    {
+        MemTraceDispatchStats stats;
+        stats.kernel            = _name;
+        stats.dispatch          = memTraceDispatch.Index();
+        stats.analyzeSeconds    = stopwatch.Seconds();
+        stats.numRecords        = numRecords;
+        ToolStats().AddDispatch(stats);
+    }
+}
+
 void MemTraceKernel::DumpAsm() const
 {
     DumpKernelAsmText(_name, _asmText);
 }
 
+uint64_t MemTraceKernel::RequiredTraceSize() const
+{
+    return (_isTrimmed ? (2 * uint64_t(_traceCapacity)) : _maxTraceSize);
+}
+
+bool MemTraceKernel::SampleDispatch()
+{
+    return _sampling.IsDispatchTraced(_sampling.numDispatches++);
+}
+
+void MemTraceKernel::CountTrace(MemTraceDispatch& trace)
+{
+    trace.SetIndex(_sampling.numTracedDispatches++);
+    _maxTraceSize = std::max(_maxTraceSize, trace.Size());
+    _isTrimmed    = _isTrimmed || trace.IsTrimmed();
+
+    if (knobStats)
+    {
+        MemTraceDispatchStats stats;
+        stats.kernel        = _name;
+        stats.dispatch      = trace.Index();
+        stats.readSeconds   = trace.ReadSeconds();
+        stats.bytesRead     = trace.BytesRead();
+        stats.isTruncated   = trace.IsTrimmed();
+        ToolStats().AddDispatch(stats);
+    }
+}
+
+/* ============================================================================================= */
+// MemTraceWriter implementation
+/* ============================================================================================= */
+MemTraceWriter::MemTraceWriter(const IGtCore& gtpinCore, uint32_t maxQueuedTraces) :
+    _gtpinCore(gtpinCore), _maxQueuedTraces(std::max(maxQueuedTraces, 1u)), _thread(&MemTraceWriter::Run, this) {}
+
+MemTraceDispatch::Buffers MemTraceWriter::AcquireBuffers()
+{
+    lock_guard<mutex> lock(_mutex);
+    if (_bufferPool.empty())
+    {
+        return MemTraceDispatch::Buffers();
+    }
+    MemTraceDispatch::Buffers buffers = std::move(_bufferPool.back());
+    _bufferPool.pop_back();
+    return buffers;
+}
+
+void MemTraceWriter::Push(const MemTraceKernel& kernel, unique_ptr<MemTraceDispatch> trace)
+{
+    if (trace == nullptr) { return; }
+
+    unique_lock<mutex> lock(_mutex);
+    _queueNotFull.wait(lock, [this] { return (_queue.size() < _maxQueuedTraces) || _isStopped; });
+    if (_isStopped)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Trace writer is stopped. The trace of kernel " + kernel.Name() + " is dropped");
+        return;
+    }
+    _queue.push_back(QueuedTrace{&kernel, std::move(trace)});
+    _queueNotEmpty.notify_one();
+}
+
+void MemTraceWriter::Stop()
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        _isStopped = true;
+    }
+    _queueNotEmpty.notify_all();
+    _queueNotFull.notify_all();
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void MemTraceWriter::Run()
+{
+    for (;;)
+    {
+        QueuedTrace queuedTrace;
+        {
+            unique_lock<mutex> lock(_mutex);
+            _queueNotEmpty.wait(lock, [this] { return !_queue.empty() || _isStopped; });
+            if (_queue.empty())
+            {
+                return; // Stopped, and all queued traces are written
+            }
+            queuedTrace = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        _queueNotFull.notify_one();
+
+        MemoryTracePostProcessor(_gtpinCore, *queuedTrace.kernel).Store(*queuedTrace.trace);
+
+        // Return the trace storage to the pool. Keep at most as many buffers as may be in flight
+        lock_guard<mutex> lock(_mutex);
+        if (_bufferPool.size() <= _maxQueuedTraces)
+        {
+            _bufferPool.push_back(queuedTrace.trace->ReleaseBuffers());
+        }
+    }
+}
+
 /* ============================================================================================= */
 // MemTrace implementation
 /* ============================================================================================= */
+const char* MemTrace::_hotspotsFileName = "memorytrace_hotspots.json";
+const char* MemTrace::_statsJsonFileName = "memorytrace_stats.json";
+const char* MemTrace::_statsCsvFileName  = "memorytrace_stats.csv";
+
 MemTrace* MemTrace::Instance()
 {
     static MemTrace instance;
@@ -169,12 +644,21 @@ bool MemTrace::Register(IGtCore* gtpinCore)
         return false;
     }
     _gtpinCore = gtpinCore;
+    if (knobStream && !knobAnalyze)
+    {
+        _writer.reset(new MemTraceWriter(*_gtpinCore, knobStreamQueue));
+    }
     return true;
 }
 
 void MemTrace::OnKernelBuild(IGtKernelInstrument& instrumentor)
 {
     const IGtKernel& kernel = instrumentor.Kernel();
+    if (!IsKernelTraced(kernel))
+    {
+        return; // The kernel is filtered out and runs uninstrumented
+    }
+    Stopwatch stopwatch;
 
     // Create new KernelData object and add it to the data base
     auto ret = _kernels.emplace(kernel.Id(), instrumentor);
@@ -200,6 +684,14 @@ void MemTrace::OnKernelBuild(IGtKernelInstrument& instrumentor)
         {
             InstrumentBbl(instrumentor, *bblPtr, memTraceKernel);
         }
+
+        if (knobStats)
+        {
+            MemTraceKernelStats stats;
+            stats.name              = memTraceKernel.Name();
+            stats.instrumentSeconds = stopwatch.Seconds();
+            ToolStats().AddKernel(stats);
+        }
     }
 }
 
@@ -208,25 +700,28 @@ void MemTrace::OnKernelRun(IGtKernelDispatch& dispatcher)
     bool isProfileEnabled = false;
 
     const IGtKernel& kernel = dispatcher.Kernel();
+    auto it = _kernels.find(kernel.Id());
+    if ((it == _kernels.end()) || !TracedDispatches().Contains(it->second.NextDispatchIndex()) || !it->second.SampleDispatch())
+    {
+        dispatcher.SetProfilingMode(false);
+        return; // The kernel or the dispatch is filtered out, or the dispatch is not sampled
+    }
+
     GtKernelExecDesc execDesc; dispatcher.GetExecDescriptor(execDesc);
     if (IsKernelExecProfileEnabled(execDesc, kernel.GpuPlatform()))
     {
-        auto it = _kernels.find(kernel.Id());
-        if (it != _kernels.end())
+        const MemTraceKernel&  memTraceKernel = it->second;
+        if (memTraceKernel.IsEnabled())
         {
-            const MemTraceKernel&  memTraceKernel = it->second;
-            if (memTraceKernel.IsEnabled())
+            IGtProfileBuffer*     buffer        = dispatcher.CreateProfileBuffer(); GTPIN_ASSERT(buffer);
+            const GtProfileTrace& traceAccessor = memTraceKernel.TraceAccessor();
+            if (traceAccessor.Initialize(*buffer))
+            {
+                isProfileEnabled = true;
+            }
+            else
             {
-                IGtProfileBuffer*     buffer        = dispatcher.CreateProfileBuffer(); GTPIN_ASSERT(buffer);
-                const GtProfileTrace& traceAccessor = memTraceKernel.TraceAccessor();
-                if (traceAccessor.Initialize(*buffer))
-                {
-                    isProfileEnabled = true;
-                }
-                else
-                {
-                    GTPIN_ERROR_MSG("MEMORYTRACE: Failed to write into memory buffer for kernel " + string(kernel.Name()));
-                }
+                GTPIN_ERROR_MSG("MEMORYTRACE: Failed to write into memory buffer for kernel " + string(kernel.Name()));
             }
         }
     }
@@ -246,7 +741,18 @@ void MemTrace::OnKernelComplete(IGtKernelDispatch& dispatcher)
     {
         // Read the trace from the profile buffer
         MemTraceKernel&  memTraceKernel = it->second;
-        memTraceKernel.AddMemTrace(dispatcher);
+        if (knobAnalyze)
+        {
+            memTraceKernel.AnalyzeMemTrace(dispatcher);
+        }
+        else if (_writer != nullptr)
+        {
+            _writer->Push(memTraceKernel, memTraceKernel.ReadMemTrace(dispatcher, _writer->AcquireBuffers()));
+        }
+        else
+        {
+            memTraceKernel.AddMemTrace(dispatcher);
+        }
     }
 }
 
@@ -327,16 +833,38 @@ void MemTrace::StoreRecordHeader(GtGenProcedure& proc, const IGtGenCoder& coder,
     proc += insF.MakeMov(flag1FieldReg, FlagReg(1));                        // flag1FieldReg     = FlagReg(1)
     if (bbl.IsEntry()) { proc += insF.MakeMov(cr0FieldReg, ControlReg()); } // cr0FieldReg       = ControlReg()()
 
+    // Threads that are not sampled (samplePredicate == false) get _offsetReg = 0 and do not execute the allocation
+    uint32_t    sr0SampleMask = memTraceKernel.Sr0SampleMask();
+    GtPredicate samplePredicate(FlagReg(1));
+    if (sr0SampleMask != 0)
+    {
+        proc += insF.MakeAnd(_offsetReg, StateReg(0), GtImmU32(sr0SampleMask));                    // _offsetReg = sr0.0 & mask
+        proc += insF.MakeCmp(GED_COND_MODIFIER_z, FlagReg(1), _offsetReg, memTraceKernel.Sr0SampleValue(), {16});
+        proc += insF.MakeMov(_offsetReg, 0).SetPredicate(!samplePredicate);
+    }
+
     // Allocate new record in the trace.
     // Set _offsetReg = offset of the allocated record in the profile buffer, _addrReg = address of the allocated record
-    memTraceKernel.TraceAccessor().ComputeNewRecordOffset(coder, proc, recordSize, _offsetReg);
+    GtGenProcedure allocProc;
+    memTraceKernel.TraceAccessor().ComputeNewRecordOffset(coder, allocProc, recordSize, _offsetReg);
+    if (sr0SampleMask != 0)
+    {
+        for (auto& ins : allocProc) { ins->SetPredicate(samplePredicate); }
+    }
+    proc += allocProc;
     coder.ComputeAddress(proc, _addrReg, _offsetReg);
 
     // Zero _offsetReg if the trace buffer is overflowed (predicate == true)
     proc += insF.MakeMov(_offsetReg, 0).SetPredicate(predicate);
+    if (sr0SampleMask != 0)
+    {
+        // The predicate of threads that are not sampled is not updated by the allocation.
+        // predicate = (_offsetReg == 0) = the trace is overflowed or the thread is not sampled
+        proc += insF.MakeCmp(GED_COND_MODIFIER_z, FlagReg(0), _offsetReg, 0, {16});
+    }
 
     //if (!predicate) { STORE buffer[_offsetReg] = _dataReg;  _offsetReg += aligned-header-size}
-    uint32_t alignedHeaderSize = MemTraceRecordHeader::AlignedSize(memTraceKernel.GenModel());
+    uint32_t alignedHeaderSize = MemTraceRecordHeader::AlignedSize(memTraceKernel.GenModel().GrfRegSize());
     coder.StoreMemBlock(proc, _addrReg, _dataReg, alignedHeaderSize, !predicate);
     proc += insF.MakeAdd(_offsetReg, _offsetReg, alignedHeaderSize).SetPredicate(!predicate);
 
@@ -375,12 +903,141 @@ void MemTrace::StoreRegRange(GtGenProcedure& proc, const IGtGenCoder& coder, uin
 void MemTrace::OnFini()
 {
     MemTrace& me = *Instance();
+    if (me._writer != nullptr)
+    {
+        me._writer->Stop(); // Store the traces that are still queued
+    }
+    if (knobPhase == 0)
+    {
+        me.UpdateTraceSizeCache();
+    }
+    if (knobAnalyze)
+    {
+        me.StoreHotspots();
+    }
+    if (knobPostProcessThreads == 1)
+    {
+        for (auto& ref : me._kernels)
+        {
+            const MemTraceKernel&  memTraceKernel = ref.second;
+            MemoryTracePostProcessor(*me._gtpinCore, memTraceKernel)();
+            memTraceKernel.DumpAsm();
+        }
+        MemoryTracePostProcessor::ReportWriteThroughput();
+        me.StoreStats();
+        return;
+    }
+
+    // Store traces of all (kernel, dispatch) pairs concurrently
+    TaskPool pool(knobPostProcessThreads);
+    vector<MemoryTracePostProcessor::ThreadTraceRecords> workerScratch(pool.NumWorkers());
+    list<MemoryTracePostProcessor> postProcessors;
     for (auto& ref : me._kernels)
     {
         const MemTraceKernel&  memTraceKernel = ref.second;
-        MemoryTracePostProcessor(*me._gtpinCore, memTraceKernel)();
+        postProcessors.emplace_back(*me._gtpinCore, memTraceKernel);
+        postProcessors.back().Schedule(pool, workerScratch);
         memTraceKernel.DumpAsm();
     }
+    pool.Wait();
+    MemoryTracePostProcessor::ReportWriteThroughput();
+    me.StoreStats();
+}
+
+void MemTrace::UpdateTraceSizeCache() const
+{
+    TraceSizeCache& cache = *TraceSizeCache::Instance();
+    for (const auto& ref : _kernels)
+    {
+        const MemTraceKernel& memTraceKernel = ref.second;
+        if (memTraceKernel.IsTrimmed())
+        {
+            GTPIN_WARNING("MEMORYTRACE: The trace of kernel " + memTraceKernel.Name() + " is incomplete. " +
+                          "The trace size cache is updated - rerun the application to collect the complete trace");
+        }
+        cache.Update(memTraceKernel.ExtendedName(), memTraceKernel.RequiredTraceSize());
+    }
+    cache.Store();
+}
+
+void MemTrace::StoreHotspots() const
+{
+    vector<SlmKernelCosts> kernels;
+    for (const auto& ref : _kernels)
+    {
+        const MemTraceKernel&           memTraceKernel  = ref.second;
+        const MemTraceConflictProfile*  conflictProfile = memTraceKernel.ConflictProfile();
+        if ((conflictProfile == nullptr) || (conflictProfile->NumDispatches() == 0))
+        {
+            continue; // The kernel has not been profiled
+        }
+        kernels.emplace_back(memTraceKernel.Name(), conflictProfile->Histograms());
+
+        // Cross-check traced BBL executions against BBL frequencies of the pre-processing phase. Sampled traces
+        // are scaled instead, since the pre-processing phase counts all dispatches and threads
+        const MemTraceSampling& sampling = memTraceKernel.Sampling();
+        if (sampling.IsEnabled())
+        {
+            kernels.back().samplingScale = sampling.Scale();
+        }
+        else if (knobPhase == 2)
+        {
+            SlmKernelCosts& kernelCosts = kernels.back();
+            kernelCosts.expectedBblExecutions = MemoryTracePreProcessor::Instance()->BblFrequencies(memTraceKernel.ExtendedName());
+            uint32_t numMismatches = kernelCosts.NumBblMismatches();
+            if (numMismatches != 0)
+            {
+                GTPIN_WARNING("MEMORYTRACE: Traced executions of " + to_string(numMismatches) + " BBLs of kernel " +
+                              memTraceKernel.Name() + " differ from the pre-processing phase");
+            }
+        }
+    }
+    if (kernels.empty())
+    {
+        return;
+    }
+
+    string   filePath = JoinPath(string(_gtpinCore->ProfileDir()), _hotspotsFileName);
+    ofstream fs(filePath);
+    if (!fs)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not create file " + filePath);
+        return;
+    }
+    WriteHotspotsJson(kernels, 0, fs);
+}
+
+void MemTrace::StoreStats() const
+{
+    if (!knobStats)
+    {
+        return;
+    }
+
+    // Trace sizes are known once all dispatches complete
+    MemTraceStats& stats = ToolStats();
+    for (const auto& ref : _kernels)
+    {
+        const MemTraceKernel& memTraceKernel = ref.second;
+        MemTraceKernelStats   kernelStats;
+        kernelStats.name            = memTraceKernel.Name();
+        kernelStats.traceCapacity   = memTraceKernel.TraceCapacity();
+        kernelStats.maxTraceSize    = memTraceKernel.MaxTraceSize();
+        stats.AddKernel(kernelStats);
+    }
+
+    ofstream jsonFs(_statsJsonFileName);
+    if (jsonFs) { stats.WriteJson(jsonFs); }
+    if (!jsonFs)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not write file " + string(_statsJsonFileName));
+    }
+    ofstream csvFs(_statsCsvFileName);
+    if (csvFs) { stats.WriteCsv(csvFs); }
+    if (!csvFs)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not write file " + string(_statsCsvFileName));
+    }
 }
 
 /* ============================================================================================= */
@@ -411,6 +1068,14 @@ void MemoryTracePreProcessor::OnFini()
     MemoryTracePreProcessor&  tool = *Instance();
     tool.DumpKernelProfiles(_kernelPreProcessFileName);
     tool.DumpDispatchProfiles(_dispatchPreProcessFileName);
+
+    // Seed the trace size cache, so that subsequent runs may use the single-pass mode
+    TraceSizeCache& cache = *TraceSizeCache::Instance();
+    for (const auto& entry : tool._kernelCounters)
+    {
+        cache.Update(entry.first, entry.second.weight);
+    }
+    cache.Store();
 }
 
 uint64_t MemoryTracePreProcessor::TraceSize(const string& extKernelName) const
@@ -419,6 +1084,16 @@ uint64_t MemoryTracePreProcessor::TraceSize(const string& extKernelName) const
     return ((it == _kernelCounters.end()) ? 0 : it->second.weight);
 }
 
+BblExecutionCounts MemoryTracePreProcessor::BblFrequencies(const string& extKernelName) const
+{
+    auto it = _kernelCounters.find(extKernelName);
+    if (it == _kernelCounters.end())
+    {
+        return BblExecutionCounts();
+    }
+    return BblExecutionCounts(it->second.freq.begin(), it->second.freq.end());
+}
+
 uint32_t MemoryTracePreProcessor::GetBblWeight(IGtKernelInstrument& kernelInstrument, const IGtBbl& bbl) const
 {
     // For the memorytrace tool, the weight of the BBL is the trace record size in this BBL
@@ -431,10 +1106,98 @@ void MemoryTracePreProcessor::AggregateDispatchCounters(KernelWeightCounters& kc
     kc.freq += dc.freq;
 }
 
+void MemoryTracePreProcessor::OnKernelBuild(IGtKernelInstrument& instrumentor)
+{
+    const IGtKernel& kernel = instrumentor.Kernel();
+    if (IsKernelTraced(kernel))
+    {
+        _numDispatches.emplace(kernel.Id(), 0);
+        KernelWeight::OnKernelBuild(instrumentor);
+    }
+}
+
+void MemoryTracePreProcessor::OnKernelRun(IGtKernelDispatch& dispatcher)
+{
+    auto it = _numDispatches.find(dispatcher.Kernel().Id());
+    if ((it == _numDispatches.end()) || !TracedDispatches().Contains(it->second++))
+    {
+        dispatcher.SetProfilingMode(false);
+        return; // The kernel or the dispatch is filtered out
+    }
+    KernelWeight::OnKernelRun(dispatcher);
+}
+
+/* ============================================================================================= */
+// TraceSizeCache implementation
+/* ============================================================================================= */
+TraceSizeCache::TraceSizeCache() : _path(knobTraceSizeCache)
+{
+    // Each line of the cache file is "<trace size> <extended kernel name>"
+    std::ifstream is(_path);
+    uint64_t traceSize = 0;
+    string   extKernelName;
+    while ((is >> traceSize) && getline(is >> std::ws, extKernelName))
+    {
+        _traceSizes[extKernelName] = traceSize;
+    }
+}
+
+TraceSizeCache* TraceSizeCache::Instance()
+{
+    static TraceSizeCache instance;
+    return &instance;
+}
+
+uint64_t TraceSizeCache::TraceSize(const string& extKernelName) const
+{
+    auto it = _traceSizes.find(extKernelName);
+    return ((it == _traceSizes.end()) ? 0 : it->second);
+}
+
+void TraceSizeCache::Update(const string& extKernelName, uint64_t traceSize)
+{
+    if (traceSize != 0)
+    {
+        uint64_t& cachedSize = _traceSizes[extKernelName];
+        cachedSize = std::max(cachedSize, traceSize);
+    }
+}
+
+bool TraceSizeCache::Store() const
+{
+    // Write a temporary file and rename it, so that concurrent runs never read a partially written cache
+    string tmpPath = _path + ".tmp";
+    {
+        ofstream os(tmpPath);
+        for (const auto& entry : _traceSizes)
+        {
+            os << entry.second << " " << entry.first << "\n";
+        }
+        if (!os.flush())
+        {
+            GTPIN_WARNING("MEMORYTRACE: Could not write file " + tmpPath);
+            return false;
+        }
+    }
+    if ((std::rename(tmpPath.c_str(), _path.c_str()) != 0) &&
+        ((std::remove(_path.c_str()) != 0) || (std::rename(tmpPath.c_str(), _path.c_str()) != 0)))
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not update the trace size cache " + _path);
+        return false;
+    }
+    return true;
+}
+
 /* ============================================================================================= */
 // MemoryTracePostProcessor implementation
 /* ============================================================================================= */
-const char* MemoryTracePostProcessor::_traceFileName = "memorytrace_compressed.bin";
+const char* MemoryTracePostProcessor::_traceFileName     = MEMTRACE_FILE_NAME;
+const char* MemoryTracePostProcessor::_rawTraceFileName  = MEMTRACE_RAW_FILE_NAME;
+const char* MemoryTracePostProcessor::_conflictsFileName = "memorytrace_conflicts.json";
+const char* MemoryTracePostProcessor::_samplingFileName  = MEMTRACE_SAMPLING_FILE_NAME;
+const char* MemoryTracePostProcessor::_asmFileName       = MEMTRACE_ASM_FILE_NAME;
+atomic<uint64_t> MemoryTracePostProcessor::_storedBytes(0);
+atomic<uint64_t> MemoryTracePostProcessor::_writeMicroseconds(0);
 
 MemoryTracePostProcessor::MemoryTracePostProcessor(const IGtCore& gtpinCore, const MemTraceKernel& memTraceKernel) :
     _kernel(&memTraceKernel), _memAccessInfo(&memTraceKernel.GetMemAccessInfo()),
@@ -447,140 +1210,226 @@ bool MemoryTracePostProcessor::operator()()
         GTPIN_WARNING("MEMORYTRACE: Could not create directory " + _kernelDir);
         return false;
     }
+    StoreSampling();
+    StoreAsm();
+
+    // In the "analyze" mode, traces have already been folded into the conflict profile
+    if (_kernel->ConflictProfile() != nullptr)
+    {
+        return StoreConflictProfile(*_kernel->ConflictProfile());
+    }
 
     // Process traces recorded in kernel dispatches
     for (const MemTraceDispatch& trace : _kernel->GetTraces())
     {
-        if (!trace.IsEmpty())
-        {
-            if (trace.IsTrimmed())
-            {
-                GTPIN_WARNING("MEMORYTRACE: Detected trace buffer overflow in kernel " + _kernel->Name());
-            }
-
-            string subdir   = trace.KernelExecDesc().ToString(_kernel->Platform(), ExecDescFileNameFormat());
-            string dir      = MakeSubDirectory(_kernelDir, subdir);
-            string filePath = JoinPath(dir, _traceFileName);
-
-            ofstream fs(filePath, std::ios::binary);
-            if (!fs)
-            {
-                GTPIN_WARNING("MEMORYTRACE: Could not create file " + filePath);
-                continue;
-            }
-            StoreTrace(trace, fs);
-        }
+        StoreDispatch(trace);
     }
     return true;
 }
 
-void MemoryTracePostProcessor::StoreTrace(const MemTraceDispatch& trace, std::ofstream& fs)
+bool MemoryTracePostProcessor::Schedule(TaskPool& pool, vector<ThreadTraceRecords>& workerScratch)
 {
-    const uint8_t* traceData         = trace.Data();
-    uint32_t       traceSize         = trace.Size();
-    uint32_t       alignedHeaderSize = MemTraceRecordHeader::AlignedSize(_kernel->GenModel());
+    if (!MakeDirectory(_kernelDir))
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not create directory " + _kernelDir);
+        return false;
+    }
+    StoreSampling();
+    StoreAsm();
 
-    // Associate trace records with threads - populate _threadTraceRecords array
-    const GtStateRegAccessor& sra = _kernel->GenModel().StateRegAccessor();
-    uint32_t maxThreads = _kernel->GenModel().MaxThreads(); // Max number of HW threads
-    _threadTraceRecords.clear();
-    _threadTraceRecords.resize(maxThreads);
+    if (_kernel->ConflictProfile() != nullptr)
+    {
+        return StoreConflictProfile(*_kernel->ConflictProfile());
+    }
 
-    uint32_t numProfiledThreads = 0; // Number of profiled (active) threads
-    for (uint32_t recordOffset = 0; recordOffset + sizeof(MemTraceRecordHeader) <= traceSize;)
+    // Dispatches with equal execution descriptors share the trace file. In the serial processing, the file
+    // is overwritten by each of them, so only the last dispatch is stored
+    map<string, const MemTraceDispatch*> traceFiles;
+    for (const MemTraceDispatch& trace : _kernel->GetTraces())
     {
-        // Retrive thread ID and BBL ID from the record header
-        const MemTraceRecordHeader* header = (const MemTraceRecordHeader*)(traceData + recordOffset);
-        uint32_t tid   = sra.GetGlobalTid(header->sr0);
-        uint32_t bblId = header->bblId;
-        const BblMemAccessInfo* bblInfoPtr = _memAccessInfo->GetBblInfo(bblId); GTPIN_ASSERT(bblInfoPtr != nullptr);
-        uint32_t recordSize = bblInfoPtr->RecordSize();
-        if (recordOffset + recordSize > traceSize)
+        if (!trace.IsEmpty())
         {
-            break; // end of trace
+            traceFiles[MakeDispatchDir(trace)] = &trace;
         }
+    }
 
-        // Add a new trace record reference to _threadTraceRecords
-        if (_threadTraceRecords[tid].empty()) { ++numProfiledThreads; } // Increment thread count on the first relevant record
-        _threadTraceRecords[tid].emplace_back(TraceRecord{header, recordSize});
-
-        recordOffset += recordSize;
+    for (const auto& entry : traceFiles)
+    {
+        string                  dispatchDir = entry.first;
+        const MemTraceDispatch* trace       = entry.second;
+        pool.Submit([this, dispatchDir, trace, &workerScratch](uint32_t workerId)
+        {
+            StoreTraceFile(*trace, dispatchDir, workerScratch[workerId]);
+        });
     }
+    return true;
+}
 
-    StoreMemAccessInfo(fs);         // Store static information about memory accesses in the kernel
-    Store(numProfiledThreads, fs);  // Store the number of profiled threads
+bool MemoryTracePostProcessor::Store(const MemTraceDispatch& trace)
+{
+    if (!MakeDirectory(_kernelDir))
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not create directory " + _kernelDir);
+        return false;
+    }
+    return StoreDispatch(trace);
+}
 
-    // Store per-thread traces
-    for (uint32_t tid = 0; tid < maxThreads; tid++)
+bool MemoryTracePostProcessor::StoreDispatch(const MemTraceDispatch& trace)
+{
+    if (trace.IsEmpty())
     {
-        const TraceRecordList& traceRecordList = _threadTraceRecords[tid];
-        if (traceRecordList.empty()) { continue; }
+        return true;
+    }
+    return StoreTraceFile(trace, MakeDispatchDir(trace), _threadTraceRecords);
+}
 
-        StoreGlobalTid(tid, fs);    // Store Global Thread Identifier
+string MemoryTracePostProcessor::MakeDispatchDir(const MemTraceDispatch& trace) const
+{
+    string subdir   = trace.KernelExecDesc().ToString(_kernel->Platform(), ExecDescFileNameFormat());
+    return MakeSubDirectory(_kernelDir, subdir);
+}
 
-        uint32_t numRecords = (uint32_t)traceRecordList.size();
-        Store(numRecords, fs);      // Store #records collected in the thread
+bool MemoryTracePostProcessor::StoreTraceFile(const MemTraceDispatch& trace, const string& dispatchDir,
+                                              ThreadTraceRecords& threadTraceRecords) const
+{
+    if (trace.IsTrimmed())
+    {
+        GTPIN_WARNING("MEMORYTRACE: Detected trace buffer overflow in kernel " + _kernel->Name());
+    }
+    if (knobCaptureRaw)
+    {
+        StoreRawTraceFile(trace, dispatchDir);
+    }
 
-        // Store trace records
-        for (const auto& record : traceRecordList)
-        {
-            const auto& header   = *(record.header);
-            uint32_t    bblId    = header.bblId;
-            uint32_t    execMask = header.ce & header.dm;
+    string          filePath = JoinPath(dispatchDir, _traceFileName);
+    TraceFileWriter fs;
+    if (!fs.Open(filePath, (knobDirectIo ? TraceFileWriter::Sink::DIRECT : TraceFileWriter::Sink::BUFFERED)))
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not create file " + filePath);
+        return false;
+    }
 
-            Store(bblId, fs);       // Store BBL ID
-            Store(execMask, fs);    // Store dynamic execution mask
+    // Address payloads are passed to the writer by reference, the trace remains valid until the file is closed
+    MemTraceSerializer    serializer(_memAccessInfo->Layout(), knobTraceFormat, knobTraceIndex);
+    MemTraceDispatchStats stats;
+    Stopwatch             bucketStopwatch;
+    stats.numThreads    = serializer.BucketByThread(trace.Segments(), threadTraceRecords);
+    stats.bucketSeconds = bucketStopwatch.Seconds();
+    Stopwatch             storeStopwatch;
+    serializer.StoreBuckets(threadTraceRecords, fs);
+    bool isOk = fs.Close();
+    stats.storeSeconds  = storeStopwatch.Seconds();
+    if (!isOk)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not write file " + filePath);
+    }
+    _storedBytes += fs.BytesWritten();
+    _writeMicroseconds += (uint64_t)(fs.WriteSeconds() * 1e6);
 
-            // Store address paylads
-            if (record.size > alignedHeaderSize)
-            {
-                fs.write((const char*)(record.header) + alignedHeaderSize, record.size - alignedHeaderSize);
-            }
+    if (knobStats)
+    {
+        const vector<uint64_t>& threadBegin = threadTraceRecords.threadBegin;
+        uint64_t                begin       = 0;
+        for (uint64_t end : threadBegin)
+        {
+            stats.maxThreadRecords = std::max(stats.maxThreadRecords, end - begin);
+            begin = end;
         }
+        stats.kernel        = _kernel->Name();
+        stats.dispatch      = trace.Index();
+        stats.writeSeconds  = fs.WriteSeconds();
+        stats.numRecords    = threadTraceRecords.records.size();
+        stats.bytesWritten  = fs.BytesWritten();
+        ToolStats().AddDispatch(stats);
     }
+    return isOk;
 }
 
-void MemoryTracePostProcessor::StoreMemAccessInfo(std::ofstream& fs)
+bool MemoryTracePostProcessor::StoreRawTraceFile(const MemTraceDispatch& trace, const string& dispatchDir) const
 {
-    // Store static information about memory accesses in BBLs
-    uint32_t numBbls = _memAccessInfo->NumMemBbls();
-    Store(numBbls, fs);                                 // Store the number of BBLs that access memory
+    string          filePath = JoinPath(dispatchDir, _rawTraceFileName);
+    TraceFileWriter fs;
+    if (!fs.Open(filePath))
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not create file " + filePath);
+        return false;
+    }
+    StoreRawDispatch(_memAccessInfo->Layout(), trace.Segments(), trace.IsTrimmed(), fs);
+    bool isOk = fs.Close();
+    if (!isOk)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not write file " + filePath);
+    }
+    return isOk;
+}
 
-    for (const auto& entry : _memAccessInfo->GetMemAccessMap())
+void MemoryTracePostProcessor::ReportWriteThroughput()
+{
+    uint64_t storedBytes = _storedBytes;
+    if (!knobStats || (storedBytes == 0))
     {
-        uint32_t                bblId               = entry.first;
-        const BblMemAccessInfo& bblInfo             = entry.second;
-        uint32_t                numMemInstructions  = (uint32_t)bblInfo.MemInstructions().size();
+        return;
+    }
+    double storedMb     = (double)storedBytes / (1024 * 1024);
+    double writeSeconds = (double)_writeMicroseconds / 1e6;
+    char   throughput[128];
+    snprintf(throughput, sizeof(throughput), "%.1f MB of traces in %.3f s (%.1f MB/s)", storedMb, writeSeconds,
+             (writeSeconds > 0) ? storedMb / writeSeconds : 0.0);
+    GTPIN_WARNING("MEMORYTRACE: Stored " + string(throughput));
+}
 
-        Store(bblId, fs);                               // Store BBL ID
-        Store(numMemInstructions, fs);                  // Store the number of memory instructions in BBL
-        for (const auto& memIns : bblInfo.MemInstructions())
-        {
-            PackedMemIns packedMemIns(memIns);
-            Store(packedMemIns, fs);                    // Store the memory instruction descriptor
-        }
+bool MemoryTracePostProcessor::StoreConflictProfile(const MemTraceConflictProfile& conflictProfile)
+{
+    if (conflictProfile.NumDispatches() == 0)
+    {
+        return true; // The kernel has not been profiled
+    }
+
+    string   filePath = JoinPath(_kernelDir, _conflictsFileName);
+    ofstream fs(filePath);
+    if (!fs)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not create file " + filePath);
+        return false;
     }
+    WriteJson(conflictProfile.Histograms().Results(), fs);
+    return true;
 }
 
-void MemoryTracePostProcessor::StoreGlobalTid(uint32_t gtid, std::ofstream& fs)
+bool MemoryTracePostProcessor::StoreSampling() const
 {
-    const GtStateRegAccessor& sra = _kernel->GenModel().StateRegAccessor();
-    uint32_t sr0 = sra.SetGlobalTid(0, gtid);
+    const MemTraceSampling& sampling = _kernel->Sampling();
+    if (!sampling.IsEnabled() || (sampling.numTracedDispatches == 0))
+    {
+        return true;
+    }
 
-    auto storeSr0Field = [&](const ScatteredBitFieldU32& sbf)
+    string   filePath = JoinPath(_kernelDir, _samplingFileName);
+    ofstream fs(filePath);
+    if (!fs)
     {
-        uint32_t val = (sbf.IsEmpty() ? UINT32_MAX : sbf.GetValue(sr0));
-        Store(val, fs);
-    };
+        GTPIN_WARNING("MEMORYTRACE: Could not create file " + filePath);
+        return false;
+    }
+    sampling.Write(fs);
+    return true;
+}
 
-    storeSr0Field(sra.SliceIdField());
-    storeSr0Field(sra.DualSubSliceIdField());
-    storeSr0Field(sra.SubSliceIdField());
-    storeSr0Field(sra.EuIdField());
-    storeSr0Field(sra.ThreadSlotField());
+bool MemoryTracePostProcessor::StoreAsm() const
+{
+    string   filePath = JoinPath(_kernelDir, _asmFileName);
+    ofstream fs(filePath);
+    if (!fs)
+    {
+        GTPIN_WARNING("MEMORYTRACE: Could not create file " + filePath);
+        return false;
+    }
+    fs << _kernel->AsmText();
+    return true;
 }
 
-MemoryTracePostProcessor::PackedMemIns::PackedMemIns(const MemIns& memIns)
+PackedMemIns::PackedMemIns(const MemIns& memIns)
 {
     offset              = memIns.offset;
     isWrite             = memIns.msg.IsWrite();
@@ -618,7 +1467,8 @@ EXPORT_C_FUNC void GTPin_Entry(int argc, const char *argv[])
     }
     else
     {
-        GTPIN_ASSERT_MSG((knobPhase == 2), "MEMORYTRACE: Invalid phase value. Should be 1 or 2, provided " + std::to_string(knobPhase));
+        GTPIN_ASSERT_MSG((knobPhase == 0) || (knobPhase == 2),
+                         "MEMORYTRACE: Invalid phase value. Should be 0, 1 or 2, provided " + std::to_string(knobPhase));
         MemTrace::Instance()->Register(gtpinCore);
         atexit(MemTrace::OnFini);
     }
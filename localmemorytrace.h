@@ -0,0 +1,538 @@
+/*========================== begin_copyright_notice ============================
+Copyright (C) 2018-2021 Intel Corporation
+
+SPDX-License-Identifier: MIT
+============================= end_copyright_notice ===========================*/
+
+/*!
+ * @file Localmemorytrace tool definitions
+ */
+
+#ifndef LOCALMEMORYTRACE_H_
+#define LOCALMEMORYTRACE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtpin_api.h"
+#include "gtpin_tool_utils.h"
+#include "gen_send_decoder.h"
+#include "kernel_weight.h"
+#include "kernel_filter.h"
+#include "memtrace_format.h"
+#include "bank_conflicts.h"
+#include "dispatch_trace.h"
+#include "hotspots.h"
+#include "source_report.h"
+#include "task_pool.h"
+#include "trace_file_writer.h"
+#include "trace_sampling.h"
+#include "trace_stats.h"
+
+using namespace gtpin;
+
+/* ============================================================================================= */
+// Struct MemIns
+/* ============================================================================================= */
+/*!
+ * Descriptor of a memory instruction
+ */
+struct MemIns
+{
+    InsId       id;         ///< Instruction ID
+    uint32_t    offset;     ///< Instruction offset
+    DcSendMsg   msg;        ///< Decoded SEND message
+};
+
+/* ============================================================================================= */
+// Struct PackedMemIns
+/* ============================================================================================= */
+/*!
+ * Packed memory instruction descriptor, as stored in the trace file
+ */
+struct PackedMemIns : public MemTracePackedMemIns
+{
+    explicit PackedMemIns(const MemIns& memIns);
+};
+
+/* ============================================================================================= */
+// Class BblMemAccessInfo
+/* ============================================================================================= */
+/*!
+ * Static information about SLM accesses in a basic block
+ */
+class BblMemAccessInfo
+{
+public:
+    BblMemAccessInfo() = default;
+    BblMemAccessInfo(const IGtKernelInstrument& kernelInstrument, const IGtBbl& bbl) { Build(kernelInstrument, bbl); }
+
+    /// Collect SLM access instructions in the specified BBL
+    BblMemAccessInfo& Build(const IGtKernelInstrument& kernelInstrument, const IGtBbl& bbl);
+
+    bool                        IsEmpty()           const { return _memInstructions.empty(); }
+    uint32_t                    RecordSize()        const { return _recordSize; }       ///< Size of the trace record
+    const std::vector<MemIns>&  MemInstructions()   const { return _memInstructions; }
+
+private:
+    std::vector<MemIns> _memInstructions;   ///< SLM access instructions in the BBL
+    uint32_t            _recordSize = 0;    ///< Size of the trace record generated by the BBL
+};
+
+/* ============================================================================================= */
+// Class KernelMemAccessInfo
+/* ============================================================================================= */
+/*!
+ * Static information about SLM accesses in a kernel
+ */
+class KernelMemAccessInfo
+{
+public:
+    using MemAccessMap = std::map<BblId, BblMemAccessInfo>;
+
+    /// Collect SLM access instructions in the specified kernel
+    KernelMemAccessInfo& Build(const IGtKernelInstrument& kernelInstrument);
+
+    /// @return Information about the specified BBL, or nullptr if the BBL does not access SLM
+    const BblMemAccessInfo* GetBblInfo(BblId bblId) const;
+
+    /// @return Size of the trace record generated by the specified BBL, or 0 if the BBL does not access SLM
+    uint32_t RecordSize(BblId bblId) const { return _layout.RecordSize(bblId); }
+
+    /// @return Static information required to process raw traces of the kernel independently of GTPin
+    const MemTraceKernelLayout& Layout() const { return _layout; }
+
+    const MemAccessMap& GetMemAccessMap()   const { return _memAccessMap; }
+    uint32_t            NumMemBbls()        const { return (uint32_t)_memAccessMap.size(); }
+    uint32_t            MaxRecordSize()     const { return _maxRecordSize; }
+
+private:
+    /// Build the mapping of HW thread identifiers (sr0) to global thread IDs and their fields
+    void BuildThreadMap(const IGtGenModel& genModel);
+
+private:
+    MemAccessMap            _memAccessMap;          ///< BBL ID -> static information about SLM accesses in the BBL
+    MemTraceKernelLayout    _layout;                ///< Layout of raw trace records and threads of the kernel
+    uint32_t                _maxRecordSize = 0;     ///< Max size of the trace record in the kernel
+};
+
+/* ============================================================================================= */
+// Class MemTraceDispatch
+/* ============================================================================================= */
+/*!
+ * Memory trace collected in a kernel dispatch. The trace is copied from the profile buffer in fixed-size segments
+ * of complete records, so that large traces do not require a single contiguous allocation
+ */
+class MemTraceDispatch
+{
+public:
+    /// Storage of trace segments
+    using Buffers = std::vector<std::vector<uint8_t>>;
+
+    explicit MemTraceDispatch(const IGtKernelDispatch& kernelDispatch) { kernelDispatch.GetExecDescriptor(_kernelExecDesc); }
+
+    /*!
+     * Read the trace from the profile buffer. Records are delimited by the layout of the kernel
+     * @param threadFilter  Hardware threads whose records are kept. Records of other threads are dropped
+     */
+    bool ReadTrace(const GtProfileTrace& traceAccessor, const IGtProfileBuffer& profileBuffer,
+                   const MemTraceKernelLayout& layout, const MemTraceThreadFilter& threadFilter);
+
+    /// Use storage of the specified buffers for trace segments, to avoid reallocation
+    void AdoptBuffers(Buffers&& buffers) { _buffers = std::move(buffers); _segments.clear(); }
+
+    /// Release storage of the trace for reuse
+    Buffers ReleaseBuffers() { _segments.clear(); return std::move(_buffers); }
+
+    /// Set the index of the traced dispatch of the kernel, counted from 0
+    void SetIndex(uint64_t index) { _index = index; }
+
+    bool                        IsEmpty()           const { return _segments.empty(); }
+    bool                        IsTrimmed()         const { return _isTrimmed; }    ///< Trace buffer overflow detected
+    const MemTraceRawSegments&  Segments()          const { return _segments; }     ///< Segments of complete records
+    uint64_t                    Size()              const { return _traceSize; }    ///< Size of the trace in the profile buffer
+    const GtKernelExecDesc&     KernelExecDesc()    const { return _kernelExecDesc; }
+    uint64_t                    Index()             const { return _index; }        ///< Index of the traced dispatch
+    uint64_t                    BytesRead()         const { return _bytesRead; }    ///< Bytes copied from the profile buffer
+    double                      ReadSeconds()       const { return _readSeconds; }  ///< Time spent in ReadTrace()
+
+private:
+    GtKernelExecDesc        _kernelExecDesc;        ///< Kernel execution descriptor
+    Buffers                 _buffers;               ///< Storage of segments, including unused buffers
+    MemTraceRawSegments     _segments;              ///< Complete records of the trace in _buffers
+    uint64_t                _traceSize = 0;         ///< Size of the trace in the profile buffer
+    bool                    _isTrimmed = false;     ///< Trace buffer overflow detected
+    uint64_t                _index = 0;             ///< Index of the traced dispatch of the kernel
+    uint64_t                _bytesRead = 0;         ///< Bytes copied from the profile buffer
+    double                  _readSeconds = 0;       ///< Time spent in ReadTrace()
+};
+
+/* ============================================================================================= */
+// Class MemTraceConflictProfile
+/* ============================================================================================= */
+/*!
+ * Online SLM bank conflict analysis of a kernel ("analyze" mode). Records of each dispatch trace are folded into
+ * per-instruction conflict degree histograms as soon as the dispatch completes, so raw traces are not retained
+ */
+class MemTraceConflictProfile
+{
+public:
+    MemTraceConflictProfile(const KernelMemAccessInfo& memAccessInfo, const SlmBankConfig& bankConfig);
+
+    /// Fold records of the specified dispatch trace into the conflict histograms. @return Number of folded records
+    uint64_t AddTrace(const MemTraceDispatch& trace);
+
+    const ConflictHistogramCollector&   Histograms()    const { return _histograms; }
+    uint32_t                            NumDispatches() const { return _numDispatches; }
+
+private:
+    const MemTraceKernelLayout&     _layout;                ///< Layout of raw trace records of the kernel
+    ConflictHistogramCollector      _histograms;            ///< Per-instruction conflict degree histograms
+    uint32_t                        _numDispatches = 0;     ///< Number of analyzed dispatches
+};
+
+/* ============================================================================================= */
+// Class MemTraceKernel
+/* ============================================================================================= */
+/*!
+ * Kernel data: static SLM access information, trace accessor and traces of all kernel dispatches
+ */
+class MemTraceKernel
+{
+public:
+    explicit MemTraceKernel(const IGtKernelInstrument& kernelInstrument);
+
+    /// Create a new MemTraceDispatch object and read the trace of the specified kernel dispatch into this object
+    MemTraceDispatch& AddMemTrace(IGtKernelDispatch& kernelDispatch);
+
+    /*!
+     * Read the trace of the specified kernel dispatch into a new MemTraceDispatch object that is not retained by the kernel
+     * @param kernelDispatch  Kernel dispatch
+     * @param buffers         Storage to be reused for the trace
+     * @return The trace, or nullptr if the profile buffer could not be read
+     */
+    std::unique_ptr<MemTraceDispatch> ReadMemTrace(IGtKernelDispatch& kernelDispatch, MemTraceDispatch::Buffers&& buffers);
+
+    /// Read the trace of the specified kernel dispatch, fold it into the conflict profile and release it
+    void AnalyzeMemTrace(IGtKernelDispatch& kernelDispatch);
+
+    /// Dump the kernel's assembly text
+    void DumpAsm() const;
+
+    /*!
+     * @return Trace size required for the kernel, as observed in this run, or 0 if the kernel has not been profiled.
+     *         If a trace overflowed its buffer, the actual size is unknown, and the doubled capacity is returned
+     */
+    uint64_t RequiredTraceSize() const;
+
+    bool                            IsEnabled()         const { return (_memAccessInfo.NumMemBbls() != 0); }
+    const std::string&              Name()              const { return _name; }
+    const std::string&              ExtendedName()      const { return _extName; }
+    const std::string&              AsmText()           const { return _asmText; }
+    GtGpuPlatform                   Platform()          const { return _platform; }
+    const IGtGenModel&              GenModel()          const { return *_genModel; }
+    const GtProfileTrace&           TraceAccessor()     const { return _traceAccessor; }
+    const KernelMemAccessInfo&      GetMemAccessInfo()  const { return _memAccessInfo; }
+    const std::list<MemTraceDispatch>& GetTraces()      const { return _traces; }
+    const MemTraceConflictProfile*  ConflictProfile()   const { return _conflictProfile.get(); }
+    bool                            IsTrimmed()         const { return _isTrimmed; }    ///< Trace buffer overflow detected
+    uint32_t                        TraceCapacity()     const { return _traceCapacity; }///< Capacity of the trace buffer
+    uint64_t                        MaxTraceSize()      const { return _maxTraceSize; } ///< Max size of dispatch traces
+    const MemTraceSampling&         Sampling()          const { return _sampling; }     ///< Sampling of the kernel's traces
+    uint32_t                        Sr0SampleMask()     const { return _sr0SampleMask; }///< sr0.0 bits of sampled threads
+    uint32_t                        Sr0SampleValue()    const { return _sr0SampleValue; }///< Value of Sr0SampleMask() bits
+
+    /// @return Index of the next dispatch of the kernel. Dispatches are counted from 0
+    uint64_t NextDispatchIndex() { return _numDispatches++; }
+
+    /// Count the dispatch selected by the dispatch range. @return true if the dispatch is traced by the sampling
+    bool SampleDispatch();
+
+private:
+    /*!
+     * Account the size of the dispatch trace read from the profile buffer, assign the index of the traced dispatch
+     * and record statistics of reading the trace
+     */
+    void CountTrace(MemTraceDispatch& trace);
+
+    std::string                 _name;              ///< Kernel name
+    std::string                 _extName;           ///< Extended kernel name
+    GtGpuPlatform               _platform;          ///< Kernel's platform
+    GtGenModelId                _genId;             ///< Kernel's Gen model ID
+    const IGtGenModel*          _genModel;          ///< Kernel's Gen model
+    std::string                 _asmText;           ///< Kernel's assembly text
+    KernelMemAccessInfo         _memAccessInfo;     ///< Static information about SLM accesses in the kernel
+    GtProfileTrace              _traceAccessor;     ///< Trace accessor
+    uint32_t                    _traceCapacity;     ///< Capacity of the trace buffer
+    uint64_t                    _maxTraceSize = 0;  ///< Max size of dispatch traces
+    bool                        _isTrimmed = false; ///< Trace buffer overflow detected in any dispatch
+    uint64_t                    _numDispatches = 0; ///< Number of dispatches of the kernel
+    MemTraceSampling            _sampling;          ///< Sampling parameters, dispatch and thread counts
+    uint32_t                    _sr0SampleMask = 0; ///< Threads with (sr0.0 & mask) == value are traced. 0 - all threads
+    uint32_t                    _sr0SampleValue = 0;///< Value of the masked sr0.0 bits of traced threads
+    std::list<MemTraceDispatch> _traces;            ///< Traces collected in kernel dispatches
+    std::unique_ptr<MemTraceConflictProfile> _conflictProfile;  ///< Conflict profile ("analyze" mode only)
+};
+
+/* ============================================================================================= */
+// Class MemTraceWriter
+/* ============================================================================================= */
+/*!
+ * Background writer of dispatch traces ("stream" mode). Traces are handed over to the writer as soon as
+ * dispatches complete and stored in files by a dedicated thread. The queue of pending traces is bounded:
+ * Push() blocks while the queue is full, and buffers of stored traces are recycled through a pool,
+ * so the host memory is limited to a few dispatch traces
+ */
+class MemTraceWriter
+{
+public:
+    MemTraceWriter(const IGtCore& gtpinCore, uint32_t maxQueuedTraces);
+    ~MemTraceWriter() { Stop(); }
+
+    /// @return Buffers for the next trace. The buffers of a written trace are taken from the pool, if available
+    MemTraceDispatch::Buffers AcquireBuffers();
+
+    /// Queue the trace for writing. Blocks while the queue is full
+    void Push(const MemTraceKernel& kernel, std::unique_ptr<MemTraceDispatch> trace);
+
+    /// Write all queued traces and stop the writer thread
+    void Stop();
+
+private:
+    MemTraceWriter(const MemTraceWriter&) = delete;
+    MemTraceWriter& operator = (const MemTraceWriter&) = delete;
+
+    /// Main function of the writer thread
+    void Run();
+
+    /// Trace queued for writing
+    struct QueuedTrace
+    {
+        const MemTraceKernel*               kernel;     ///< Kernel that produced the trace
+        std::unique_ptr<MemTraceDispatch>   trace;      ///< Dispatch trace
+    };
+
+private:
+    const IGtCore&                      _gtpinCore;             ///< GTPin core
+    uint32_t                            _maxQueuedTraces;       ///< Capacity of the queue
+    std::deque<QueuedTrace>             _queue;                 ///< Traces pending to be written
+    std::vector<MemTraceDispatch::Buffers> _bufferPool;         ///< Buffers of written traces available for reuse
+    std::mutex                          _mutex;                 ///< Protects _queue, _bufferPool and _isStopped
+    std::condition_variable             _queueNotEmpty;         ///< Signaled when a trace is queued or the writer stops
+    std::condition_variable             _queueNotFull;          ///< Signaled when a trace is taken from the queue
+    bool                                _isStopped = false;     ///< The writer has been requested to stop
+    std::thread                         _thread;                ///< Writer thread
+};
+
+/* ============================================================================================= */
+// Class MemTrace
+/* ============================================================================================= */
+/*!
+ * Implementation of the IGtTool interface for the Localmemorytrace tool
+ */
+class MemTrace : public IGtTool
+{
+public:
+    /// Implementation of the IGtTool interface
+    const char* Name() const { return "localmemorytrace"; }
+    uint32_t ApiVersion() const { return GTPIN_API_VERSION; }
+
+    void OnKernelBuild(IGtKernelInstrument& instrumentor);
+    void OnKernelRun(IGtKernelDispatch& dispatcher);
+    void OnKernelComplete(IGtKernelDispatch& dispatcher);
+
+    /// Register the tool with the GTPin core
+    bool Register(IGtCore* gtpinCore);
+
+    static MemTrace* Instance();    ///< @return Single instance of this class
+    static void OnFini();           ///< Callback function registered with atexit()
+
+private:
+    MemTrace() = default;
+    MemTrace(const MemTrace&) = delete;
+    MemTrace& operator = (const MemTrace&) = delete;
+
+    /// Instrument the specified basic block
+    bool InstrumentBbl(IGtKernelInstrument& instrumentor, const IGtBbl& bbl, const MemTraceKernel& memTraceKernel);
+
+    /// Generate code that allocates a new record in the trace and stores the record header
+    void StoreRecordHeader(GtGenProcedure& proc, const IGtGenCoder& coder, const IGtBbl& bbl,
+                           const MemTraceKernel& memTraceKernel, uint32_t recordSize);
+
+    /// Generate code that stores the specified range of GRF registers in the trace
+    void StoreRegRange(GtGenProcedure& proc, const IGtGenCoder& coder, uint32_t firstRegNum, uint32_t numRegs);
+
+    /// Store trace sizes observed in this run in the trace size cache (single-pass mode)
+    void UpdateTraceSizeCache() const;
+
+    /// Store the ranking of SLM hotspots of all analyzed kernels by estimated stall cycles ("analyze" mode)
+    void StoreHotspots() const;
+
+    /// Store statistics of the tool in the current directory ("stats" mode)
+    void StoreStats() const;
+
+private:
+    std::map<GtKernelId, MemTraceKernel>    _kernels;               ///< Collection of kernels and their traces
+    IGtCore*                                _gtpinCore = nullptr;   ///< GTPin core
+    std::unique_ptr<MemTraceWriter>         _writer;                ///< Background trace writer ("stream" mode only)
+
+    GtReg   _addrReg;       ///< Virtual register that holds the address within the trace buffer
+    GtReg   _dataReg;       ///< Virtual register that holds the record header
+    GtReg   _offsetReg;     ///< Virtual register that holds the offset within the trace buffer
+
+    static const char* _hotspotsFileName;   ///< Name of the SLM hotspot ranking file ("analyze" mode)
+    static const char* _statsJsonFileName;  ///< Name of the JSON file of statistics of the tool ("stats" mode)
+    static const char* _statsCsvFileName;   ///< Name of the CSV file of statistics of the tool ("stats" mode)
+};
+
+/* ============================================================================================= */
+// Class MemoryTracePreProcessor
+/* ============================================================================================= */
+/*!
+ * Pre-processing phase: computes the trace size required for each kernel
+ */
+class MemoryTracePreProcessor : public KernelWeight
+{
+public:
+    static MemoryTracePreProcessor* Instance();     ///< @return Single instance of this class
+    static void OnFini();                           ///< Callback function registered with atexit()
+
+    /// @return Trace size computed for the specified kernel in the pre-processing phase, or 0 if unknown
+    uint64_t TraceSize(const std::string& extKernelName) const;
+
+    /// @return Number of executions of each BBL of the specified kernel counted in the pre-processing phase,
+    ///         or an empty vector if unknown
+    BblExecutionCounts BblFrequencies(const std::string& extKernelName) const;
+
+private:
+    MemoryTracePreProcessor();
+    MemoryTracePreProcessor(const MemoryTracePreProcessor&) = delete;
+    MemoryTracePreProcessor& operator = (const MemoryTracePreProcessor&) = delete;
+
+    /// Implementation of the KernelWeight interface
+    uint32_t GetBblWeight(IGtKernelInstrument& kernelInstrument, const IGtBbl& bbl) const override;
+    void AggregateDispatchCounters(KernelWeightCounters& kc, KernelWeightCounters dc) const override;
+
+    /// Implementation of the IGtTool interface. Only kernels and dispatches selected for tracing are profiled
+    void OnKernelBuild(IGtKernelInstrument& instrumentor) override;
+    void OnKernelRun(IGtKernelDispatch& dispatcher) override;
+
+private:
+    static const char* _kernelPreProcessFileName;   ///< File that stores per-kernel pre-processing data
+    static const char* _dispatchPreProcessFileName; ///< File that stores per-dispatch pre-processing data
+
+    std::map<GtKernelId, uint64_t> _numDispatches;  ///< Kernel selected for tracing -> number of its dispatches
+};
+
+/* ============================================================================================= */
+// Class TraceSizeCache
+/* ============================================================================================= */
+/*!
+ * Persistent cache of trace sizes required by kernels, keyed by the extended kernel name. The cache is stored
+ * in a text file and updated after each run, so that the single-pass mode sizes trace buffers without running
+ * the pre-processing phase
+ */
+class TraceSizeCache
+{
+public:
+    static TraceSizeCache* Instance();     ///< @return Single instance of this class, loaded from the cache file
+
+    /// @return Cached trace size of the specified kernel, or 0 if unknown
+    uint64_t TraceSize(const std::string& extKernelName) const;
+
+    /// Raise the cached trace size of the specified kernel to traceSize
+    void Update(const std::string& extKernelName, uint64_t traceSize);
+
+    /// Store the cache in the cache file. The file is replaced atomically
+    bool Store() const;
+
+private:
+    TraceSizeCache();
+    TraceSizeCache(const TraceSizeCache&) = delete;
+    TraceSizeCache& operator = (const TraceSizeCache&) = delete;
+
+private:
+    std::string                     _path;          ///< Path to the cache file
+    std::map<std::string, uint64_t> _traceSizes;    ///< Extended kernel name -> trace size
+};
+
+/* ============================================================================================= */
+// Class MemoryTracePostProcessor
+/* ============================================================================================= */
+/*!
+ * Post-processing phase: stores traces collected in kernel dispatches in files
+ */
+class MemoryTracePostProcessor
+{
+public:
+    /// Trace records grouped by threads, reused across traces (see MemTraceSerializer::Scratch)
+    using ThreadTraceRecords = MemTraceSerializer::Scratch;
+
+    MemoryTracePostProcessor(const IGtCore& gtpinCore, const MemTraceKernel& memTraceKernel);
+
+    /// Store traces of all kernel dispatches
+    bool operator()();
+
+    /// Store the trace of the specified kernel dispatch
+    bool Store(const MemTraceDispatch& trace);
+
+    /*!
+     * Submit tasks that store traces of all kernel dispatches to the specified pool. Each task stores one dispatch
+     * trace file using the scratch data of the worker that runs it, and the produced files are identical to the ones
+     * stored by operator(). The object must not be destroyed until all submitted tasks are complete
+     * @param pool           Task pool
+     * @param workerScratch  Per-worker scratch data, one element per worker of the pool
+     */
+    bool Schedule(TaskPool& pool, std::vector<ThreadTraceRecords>& workerScratch);
+
+    /// Report the total size of stored trace files and the write throughput if --stats is specified
+    static void ReportWriteThroughput();
+
+private:
+    /// Store the conflict profile of the kernel collected in the "analyze" mode
+    bool StoreConflictProfile(const MemTraceConflictProfile& conflictProfile);
+
+    /// Store the sampling parameters of the kernel's traces in the kernel directory, if the traces are sampled
+    bool StoreSampling() const;
+
+    /// Store the assembly text of the kernel in the kernel directory, for reports without the source
+    bool StoreAsm() const;
+
+    /// Create the directory of the kernel dispatch and return its path
+    std::string MakeDispatchDir(const MemTraceDispatch& trace) const;
+
+    /// Store the trace of a kernel dispatch in the file within the dispatch directory
+    bool StoreDispatch(const MemTraceDispatch& trace);
+
+    /// Store the trace of a kernel dispatch in the specified dispatch directory, using the specified scratch data
+    bool StoreTraceFile(const MemTraceDispatch& trace, const std::string& dispatchDir, ThreadTraceRecords& threadTraceRecords) const;
+
+    /// Store the raw trace of a kernel dispatch in the raw dispatch capture file within the dispatch directory
+    bool StoreRawTraceFile(const MemTraceDispatch& trace, const std::string& dispatchDir) const;
+
+private:
+    static const char* _traceFileName;              ///< Name of the trace file
+    static const char* _rawTraceFileName;           ///< Name of the raw dispatch capture file
+    static const char* _conflictsFileName;          ///< Name of the conflict profile file
+    static const char* _samplingFileName;           ///< Name of the sampling parameters file
+    static const char* _asmFileName;                ///< Name of the assembly text file
+
+    static std::atomic<uint64_t> _storedBytes;      ///< Total size of stored trace files
+    static std::atomic<uint64_t> _writeMicroseconds;///< Total time spent in writing trace files
+
+    const MemTraceKernel*           _kernel;                ///< Kernel whose traces are stored
+    const KernelMemAccessInfo*      _memAccessInfo;         ///< Static information about SLM accesses in the kernel
+    std::string                     _kernelDir;             ///< Directory that stores the kernel's traces
+    ThreadTraceRecords              _threadTraceRecords;    ///< Trace records grouped by threads (serial processing)
+};
+
+#endif
@@ -1,4 +1,8 @@
 import argparse
+import json
+import os
+import shlex
+import sys
 import profiler
 import reporter
 from datetime import datetime
@@ -7,20 +11,52 @@ from datetime import datetime
 parser = argparse.ArgumentParser(description="The Tool for analyzing conflicts in GPU local memory banks")
 parser.add_argument("-gtpin", required=True, type=str, \
     help="Absolute or relative path to Intel GTPin (path to Profiler directory)")
-parser.add_argument("-pti", required=True, type=str, \
-    help="Absolute or relative path to Intel PTI")
+parser.add_argument("-pti", required=False, type=str, \
+    help="Absolute or relative path to Intel PTI. Without PTI, the report shows the assembly of the kernel")
 parser.add_argument("-app", required=True, type=str, \
     help="Absolute or relative path to application")
 parser.add_argument("-args", required=False, type=str, \
     help="Arguments for application")
-parser.add_argument("-kernel", required=True, type=str, \
-    help="Kernel name that needs to be traced")
+parser.add_argument("-kernel", required=False, type=str, \
+    help="Kernel name that needs to be traced. Required without -batch")
 parser.add_argument("-nb", "--number-banks", required=True, type=int, \
     help="Number of locac memory banks")
+parser.add_argument("-model", required=False, type=str, default="auto", \
+    help="SLM bank model of the online and offline analysis: auto (the model of the platform), dword, gen9, xe-hpc")
 parser.add_argument("-op", "--output-path", required=True, type=str, \
     help="Absolute or relative path where the result will be written")
+parser.add_argument("-online", action="store_true", \
+    help="Analyze bank conflicts while the application runs instead of storing full traces")
+parser.add_argument("-single-pass", action="store_true", \
+    help="Run the application once, sizing trace buffers by the trace size cache of previous runs")
+parser.add_argument("-dispatches", required=False, type=str, \
+    help="Range of traced dispatches of the kernel, counted from 0 (for example 10-20)")
+parser.add_argument("-compress", action="store_true", \
+    help="Store traces in the compact delta/varint encoded format (version 2)")
+parser.add_argument("-columnar", action="store_true", \
+    help="Store traces in the columnar format (version 3), which analyses map into memory")
+parser.add_argument("-sample-dispatches", required=False, type=int, \
+    help="Percentage of dispatches of the kernel that are traced (for example 10)")
+parser.add_argument("-batch", action="store_true", \
+    help="Trace all kernels (or the kernels matching -kernel) and rank SLM hotspots of all of them")
+parser.add_argument("-top", required=False, type=int, default=0, \
+    help="Max number of instructions and BBLs in the ranking of the batch mode, 0 - all")
+parser.add_argument("-profile", required=False, type=str, \
+    help="Store the conflict profile of all kernels in the file (batch mode)")
+parser.add_argument("-compare", required=False, type=str, \
+    help="Compare the conflict profile stored by -profile with the base profile of a previous run (batch mode)")
+parser.add_argument("-cache", required=False, type=str, \
+    help="Directory of cached analyses of trace files, reused by repeated analyses of the same traces (batch mode)")
 
 args = parser.parse_args()
+if not args.batch and not args.kernel:
+    parser.error("-kernel is required without -batch")
+if args.batch and args.online:
+    parser.error("-batch analyzes stored traces and cannot be combined with -online")
+if not args.batch and (args.profile or args.compare or args.cache):
+    parser.error("-profile, -compare and -cache require -batch")
+if args.compare and not args.profile:
+    parser.error("-compare requires -profile")
 path_gtpin = args.gtpin
 path_pti = args.pti
 path_app = args.app
@@ -31,16 +67,81 @@ else:
 
 kernel_name = args.kernel
 number_banks = args.number_banks
+bank_model = args.model
 path_op = args.output_path
 
-profiler.run_memorytrace(path_gtpin, 1, path_app, app_args)
+# Only the target kernel is instrumented, other kernels run uninstrumented. The batch mode traces all kernels
+# unless -kernel is specified.
+# Tool arguments pass through the shell, which must not expand glob patterns of the kernel filter
+filter_args = ""
+if kernel_name:
+    filter_args = "--kernel_filter " + shlex.quote(kernel_name)
+if args.dispatches:
+    filter_args += " --dispatch_range " + shlex.quote(args.dispatches)
+if args.sample_dispatches:
+    filter_args += " --sample_dispatch_percent " + str(args.sample_dispatches)
 
-profiler.run_memorytrace(path_gtpin, 2, path_app, app_args)
+# The pre-processing run is skipped in the single-pass mode
+if args.single_pass:
+    phase = 0
+else:
+    profiler.run_memorytrace(path_gtpin, 1, path_app, app_args, filter_args)
+    phase = 2
+
+if args.online:
+    profiler.run_memorytrace(path_gtpin, phase, path_app, app_args, filter_args + " --analyze --bank_model " + shlex.quote(bank_model) +
+                             " --num_banks " + str(number_banks))
+else:
+    # The thread index lets slm_bank_analyzer read traces of threads in parallel
+    trace_args = filter_args + " --stream --trace_index"
+    if args.compress:
+        trace_args += " --trace_format 2"
+    elif args.columnar:
+        trace_args += " --trace_format 3"
+    profiler.run_memorytrace(path_gtpin, phase, path_app, app_args, trace_args)
+
+if args.batch:
+    # Hotspots of all traced kernels, ranked by estimated stall cycles
+    result = profiler.run_batch_analyzer(path_gtpin, number_banks, top = args.top, profile_path = args.profile or "",
+                                         cache_dir = args.cache or "", bank_model = bank_model)
+    if not isinstance(result, dict):
+        sys.exit(1)
+    os.makedirs(path_op, exist_ok = True)
+    with open(os.path.join(path_op, "slm_hotspots.json"), "w") as fout:
+        json.dump(result, fout, indent = 2)
+
+    if args.compare:
+        diff = profiler.compare_profiles(path_gtpin, args.compare, args.profile)
+        if not isinstance(diff, dict):
+            sys.exit(1)
+        with open(os.path.join(path_op, "slm_compare.json"), "w") as fout:
+            json.dump(diff, fout, indent = 2)
+        if diff["regressed"]:
+            print("SLM bank conflicts regressed against " + args.compare + ", see slm_compare.json")
+            sys.exit(2)
+    sys.exit(0)
 
 #profiler.uncompress_memtrace(path_gtpin, kernel_name)
 
 #result = profiler.analyze_memtrace_result(number_banks, kernel_name)
 
-source_asm = profiler.build_and_run_cl_debug_info(path_pti, path_app, path_op, app_args)
+if args.online:
+    result = profiler.load_bank_conflicts(kernel_name)
+else:
+    result = profiler.run_bank_analyzer(path_gtpin, number_banks, kernel_name, bank_model = bank_model)
+
+if path_pti:
+    source_asm = profiler.build_and_run_cl_debug_info(path_pti, path_app, path_op, app_args)
+else:
+    source_asm = profiler.find_kernel_asm(kernel_name)
 
-#reporter.create_report(source_asm, path_op, kernel_name, result)
+# The native report is paginated; the Python report is used if slm_report is not built
+if isinstance(result, dict) and isinstance(source_asm, str):
+    pages = reporter.create_native_report(path_gtpin, source_asm, path_op, kernel_name, result, asm_only = not path_pti)
+    if not isinstance(pages, list):
+        if path_pti:
+            reporter.create_report(source_asm, path_op, kernel_name, result)
+        else:
+            # The Python report needs the source of the PTI cl_debug_info sample
+            print("Error: the report of the kernel assembly requires slm_report. Build it (phase 2) or specify -pti")
+            sys.exit(1)
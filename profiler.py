@@ -1,4 +1,28 @@
+import json
 import os
+import subprocess
+
+# Function for finding the directory of traces generated on phase 2
+# trace_dir: absolute or relative path to generated on phase 2 directory GTPIN_PROFILE_LOCALMEMORYTRACE*
+#  can be empty: the GTPIN_PROFILE_LOCALMEMORYTRACE directory with the largest number in the current directory is used
+# Returns the absolute path to the trace directory, or an empty string if it doesn't exist
+def find_trace_dir(trace_dir = ""):
+    prefix = "GTPIN_PROFILE_LOCALMEMORYTRACE"
+    if trace_dir != "":
+        if not os.path.exists(trace_dir) or trace_dir.find(prefix) == -1:
+            print("Path to trace directory doesn't correct")
+            return ""
+        return os.path.abspath(trace_dir)
+
+    number = -1
+    for dir in os.listdir(os.path.abspath(os.curdir)):
+        suffix = dir[len(prefix):]
+        if dir.startswith(prefix) and suffix.isdigit() and int(suffix) > number:
+            number = int(suffix)
+    if number < 0:
+        print("Trace directory " + prefix + "* doesn't exist in the current directory")
+        return ""
+    return os.path.join(os.path.abspath(os.curdir), prefix + str(number))
 
 # Function for running Intel GTPin Memorytrace tool
 # path_gtpin: absolute or relative path to Intel GTPin (path to Profiler directory)
@@ -7,7 +31,8 @@ import os
 #   2 - trace gathering phase. A phase in which the actual trace is collected.
 # path_app: absolute or relative path to application
 # app_args: agruments to application
-def run_memorytrace(path_gtpin, phase, path_app, app_args = ""):
+# tool_args: additional arguments to the localmemorytrace tool
+def run_memorytrace(path_gtpin, phase, path_app, app_args = "", tool_args = ""):
     if not os.path.exists(path_gtpin) or \
         os.path.split(os.path.abspath(path_gtpin))[-1] != "Profilers":
         print("Path to Intel GTPin doesn't correct")
@@ -15,8 +40,8 @@ def run_memorytrace(path_gtpin, phase, path_app, app_args = ""):
     if not os.path.exists(path_app):
         print("Path to application doesn't correct")
         return -2
-    if not (phase == 1 or phase == 2):
-        print("Phase doesn't correct. It must be 1 or 2")
+    if not (phase == 0 or phase == 1 or phase == 2):
+        print("Phase doesn't correct. It must be 0, 1 or 2")
         return -3
 
     script_dir = os.path.abspath(os.curdir)
@@ -24,7 +49,7 @@ def run_memorytrace(path_gtpin, phase, path_app, app_args = ""):
     tool_path = os.path.join(abs_path_gtpin, "Examples", "build", "localmemorytrace.so")
     if not os.path.exists(tool_path):
         print("Build localmemorytrace tool")
-        command = "cp localmemorytrace.cpp CMakeLists.txt " + os.path.join(abs_path_gtpin, "Examples")
+        command = "cp -r localmemorytrace.cpp localmemorytrace.h analyzer CMakeLists.txt " + os.path.join(abs_path_gtpin, "Examples")
         print(">> " + command)
         os.system(command)
 
@@ -46,7 +71,7 @@ def run_memorytrace(path_gtpin, phase, path_app, app_args = ""):
         os.chdir(script_dir)
     
     print("Phase", phase)
-    command = os.path.join(abs_path_gtpin, "Bin", "gtpin") + " -t " + os.path.join(os.path.abspath(path_gtpin), "Examples", "build", "localmemorytrace.so") + " --phase " + str(phase) + " -- " + path_app + " " + app_args
+    command = os.path.join(abs_path_gtpin, "Bin", "gtpin") + " -t " + os.path.join(os.path.abspath(path_gtpin), "Examples", "build", "localmemorytrace.so") + " --phase " + str(phase) + " " + tool_args + " -- " + path_app + " " + app_args
     print(">>", command)
     os.system(os.path.abspath(command))
     
@@ -65,18 +90,9 @@ def uncompress_memtrace(path_gtpin, kernel_name, trace_dir = ""):
         print("Path to Intel GTPin doesn't correct")
         return -1
 
-    if trace_dir != "" and (not os.path.exists(trace_dir) or \
-        trace_dir.find("GTPIN_PROFILE_LOCALMEMORYTRACE")) == -1:
-        print("Path to trace directory doens't correct")
-        return -2
-    
+    trace_dir = find_trace_dir(trace_dir)
     if trace_dir == "":
-        number = 0
-        for dir in os.listdir(os.path.abspath(os.curdir)):
-            if dir.find("GTPIN_PROFILE_LOCALMEMORYTRACE") != -1:
-                if int(dir[30:]) > number:
-                    number = int(dir[30:])
-        trace_dir = os.path.join(os.path.abspath(os.curdir), "GTPIN_PROFILE_LOCALMEMORYTRACE" + str(number))
+        return -2
     
     path_trace = os.path.join(os.path.abspath(trace_dir), "Session_Final", kernel_name)
     if not os.path.exists(path_trace):
@@ -136,27 +152,25 @@ def build_and_run_cl_debug_info(path_pti, path_app, path_op, app_args = ""):
 # kernel_name: name of kernel
 # trace_dir: absolute or relative path to generated on phase 2 directory GTPIN_PROFILE_LOCALMEMORYTRACE*
 #  can be empty: when was used later GTPIN_PROFILE_LOCALMEMORYTRACE directory
-def analyze_memtrace_result(num_banks, kernel_name, trace_dir = ""):
-    if trace_dir != "" and (not os.path.exists(trace_dir) or \
-        trace_dir.find("GTPIN_PROFILE_LOCALMEMORYTRACE")) == -1:
-        print("Path to trace directory doens't correct")
-        return -2
-    
+# weighted: weight patterns by the number of their occurrences
+#   False - each distinct pattern is counted once
+def analyze_memtrace_result(num_banks, kernel_name, trace_dir = "", weighted = True):
+    trace_dir = find_trace_dir(trace_dir)
     if trace_dir == "":
-        number = 0
-        for dir in os.listdir(os.path.abspath(os.curdir)):
-            if dir.find("GTPIN_PROFILE_LOCALMEMORYTRACE") != -1:
-                 if int(dir[30:]) > number:
-                    number = int(dir[30:])
-        trace_dir = os.path.join(os.path.abspath(os.curdir), "GTPIN_PROFILE_LOCALMEMORYTRACE" + str(number))
+        return -2
     
     path_trace = os.path.join(os.path.abspath(trace_dir), "Session_Final", kernel_name)
     if not os.path.exists(path_trace):
         print("Kernel name doesn't correct")
         return -3
     
-    all_patterns = []  # [ [send-offset address address ... ] [send-offset address address ... ] ... ]
-    
+    all_patterns = {}  # { (send-offset, address, address, ...) : occurrences }
+
+    def add_pattern(pattern):
+        if pattern.count(pattern[1]) != len(pattern) - 1:  # Not broadcast
+            key = tuple(pattern)
+            all_patterns[key] = all_patterns.get(key, 0) + 1
+
     for dir in os.listdir(path_trace):
         print("|- Directory: " + dir)
         for file in os.listdir(os.path.join(path_trace, dir)):
@@ -177,43 +191,35 @@ def analyze_memtrace_result(num_banks, kernel_name, trace_dir = ""):
                             if pattern[0] == send_offset:
                                 pattern.append(address)
                             else:
-                                if pattern.count(pattern[1]) != len(pattern) - 1:  # Not broadcast
-                                    if all_patterns.count(pattern) == 0:
-                                        all_patterns.append(pattern)
+                                add_pattern(pattern)
 
                                 pattern = []
                                 pattern.append(send_offset)
                                 pattern.append(address)
                                 
-                if pattern.count(pattern[1]) != len(pattern) - 1: # Not broadcast
-                    if all_patterns.count(pattern) == 0:
-                        all_patterns.append(pattern)
+                if pattern != []:
+                    add_pattern(pattern)
+                fin.close()
     
-    conflicts = []  # [ [send-offset power] [send-offset power] ...]
-    for pattern in all_patterns:
+    conflicts = {}  # { (send-offset, power) : count }
+    for pattern, occurrences in all_patterns.items():
         # Transform from addresses to banks
-        send_offset = pattern.pop(0)
-        for i in range(len(pattern)):
-            pattern[i] = (pattern[i] // 4) % num_banks
-    
-        count = 0
-        for i in range(len(pattern)):
-            count = max(count, pattern.count(pattern[i]))
+        send_offset = pattern[0]
+        banks = {}  # { bank : number of accesses }
+        for address in pattern[1:]:
+            bank = (address // 4) % num_banks
+            banks[bank] = banks.get(bank, 0) + 1
         
+        count = max(banks.values())
         if count == 1:
-            conflicts.append([kernel_name, send_offset, 0])
-        else:
-            conflicts.append([kernel_name, send_offset, count])
+            count = 0
+
+        conflict = (send_offset, count)
+        conflicts[conflict] = conflicts.get(conflict, 0) + (occurrences if weighted else 1)
 
     results = {}  # { send-offset : [ [power count] ... ] }
-    for conflict in conflicts:
-        result = conflict[1]
-        count = [conflict[2], conflicts.count(conflict)]
-
-        if results.get(result) == None:
-            results[result] = [count]
-        elif results.get(result).count(count) == 0:
-            results[result].append(count)
+    for (send_offset, power), count in conflicts.items():
+        results.setdefault(send_offset, []).append([power, count])
     
     for result in results:
         length = 0
@@ -224,3 +230,161 @@ def analyze_memtrace_result(num_banks, kernel_name, trace_dir = ""):
     
     print(results)
     return results
+
+# Function for analyze Intel GTPin Memorytrace tool result with the native slm_bank_analyzer
+# Reads memorytrace_compressed.bin files directly, without uncompressing them into text files
+# path_gtpin: absolute or relative path to Intel GTPin (path to Profiler directory)
+# num_banks: number of local memory banks
+# kernel_name: name of kernel
+# trace_dir: absolute or relative path to generated on phase 2 directory GTPIN_PROFILE_LOCALMEMORYTRACE*
+#  can be empty: when was used later GTPIN_PROFILE_LOCALMEMORYTRACE directory
+# weighted: weight patterns by the number of their occurrences
+#   False - each distinct pattern is counted once
+# bank_model: SLM bank model of the weighted mode, the same as --bank_model of the localmemorytrace tool in the analyze mode
+#   auto - the model of the platform, selected by the GRF size of the trace
+# Trace files with the thread index are analyzed by all hardware threads in the weighted mode
+def run_bank_analyzer(path_gtpin, num_banks, kernel_name, trace_dir = "", weighted = True, bank_model = "auto"):
+    analyzer_path = os.path.join(os.path.abspath(path_gtpin), "Examples", "build", "slm_bank_analyzer")
+    if not os.path.exists(analyzer_path):
+        print("slm_bank_analyzer doesn't exist. Run phase 2 to build it")
+        return -1
+
+    trace_dir = find_trace_dir(trace_dir)
+    if trace_dir == "":
+        return -2
+
+    path_trace = os.path.join(os.path.abspath(trace_dir), "Session_Final", kernel_name)
+    if not os.path.exists(path_trace):
+        print("Kernel name doesn't correct")
+        return -3
+
+    trace_files = []
+    for dir in os.listdir(path_trace):
+        trace_file = os.path.join(path_trace, dir, "memorytrace_compressed.bin")
+        if os.path.exists(trace_file):
+            print("|- Directory: " + dir)
+            trace_files.append(trace_file)
+
+    command = [analyzer_path, "-nb", str(num_banks)]
+    if not weighted:
+        command.append("-unique")
+    else:
+        command += ["-model", bank_model, "-threads", "0"]
+    # Sampled traces are scaled to full-run estimates by their sampling parameters
+    sampling_file = os.path.join(path_trace, "memorytrace_sampling.txt")
+    if os.path.exists(sampling_file):
+        command += ["-sampling", sampling_file]
+    command += trace_files
+    print(">>", " ".join(command))
+    output = subprocess.run(command, stdout=subprocess.PIPE, universal_newlines=True)
+    if output.returncode != 0:
+        print("slm_bank_analyzer failed")
+        return -4
+
+    results = {}  # { send-offset : [ [power percent] ... ] }
+    for send_offset, counts in json.loads(output.stdout).items():
+        results[int(send_offset)] = counts
+
+    print(results)
+    return results
+
+# Function for load SLM bank conflicts analyzed by the localmemorytrace tool in the analyze mode (--analyze)
+# kernel_name: name of kernel
+# trace_dir: absolute or relative path to generated on phase 2 directory GTPIN_PROFILE_LOCALMEMORYTRACE*
+#  can be empty: when was used later GTPIN_PROFILE_LOCALMEMORYTRACE directory
+def load_bank_conflicts(kernel_name, trace_dir = ""):
+    trace_dir = find_trace_dir(trace_dir)
+    if trace_dir == "":
+        return -2
+
+    path_conflicts = os.path.join(os.path.abspath(trace_dir), "Session_Final", kernel_name, "memorytrace_conflicts.json")
+    if not os.path.exists(path_conflicts):
+        print("Kernel name doesn't correct")
+        return -3
+
+    results = {}  # { send-offset : [ [power percent] ... ] }
+    with open(path_conflicts, "r") as fin:
+        for send_offset, counts in json.load(fin).items():
+            results[int(send_offset)] = counts
+
+    print(results)
+    return results
+
+# Function for finding the assembly of the kernel stored by the localmemorytrace tool, used for reports without Intel PTI
+# kernel_name: name of kernel
+# trace_dir: absolute or relative path to generated on phase 2 directory GTPIN_PROFILE_LOCALMEMORYTRACE*
+#  can be empty: when was used later GTPIN_PROFILE_LOCALMEMORYTRACE directory
+def find_kernel_asm(kernel_name, trace_dir = ""):
+    trace_dir = find_trace_dir(trace_dir)
+    if trace_dir == "":
+        return -2
+
+    path_asm = os.path.join(os.path.abspath(trace_dir), "Session_Final", kernel_name, "memorytrace_asm.txt")
+    if not os.path.exists(path_asm):
+        print("Kernel name doesn't correct")
+        return -3
+    return path_asm
+
+# Function for analyze traces of all kernels of the profile directory with the native slm_bank_analyzer
+# Kernel and dispatch directories are discovered by the analyzer, and trace files are analyzed by all hardware threads
+# path_gtpin: absolute or relative path to Intel GTPin (path to Profiler directory)
+# num_banks: number of local memory banks
+# trace_dir: absolute or relative path to generated on phase 2 directory GTPIN_PROFILE_LOCALMEMORYTRACE*
+#  can be empty: when was used later GTPIN_PROFILE_LOCALMEMORYTRACE directory
+# top: max number of instructions and BBLs in the ranking, 0 - all
+# profile_path: path of the conflict profile of all kernels to be stored for slm_compare, can be empty: not stored
+# cache_dir: directory of cached analyses of trace files, can be empty: trace files are always analyzed
+# bank_model: SLM bank model, the same as --bank_model of the localmemorytrace tool in the analyze mode
+#   auto - the model of the platform, selected by the GRF size of the trace
+# Returns the ranking of SLM hotspots of all kernels: { "kernels": [...], "bbls": [...], "instructions": [...] }
+def run_batch_analyzer(path_gtpin, num_banks, trace_dir = "", top = 0, profile_path = "", cache_dir = "", bank_model = "auto"):
+    analyzer_path = os.path.join(os.path.abspath(path_gtpin), "Examples", "build", "slm_bank_analyzer")
+    if not os.path.exists(analyzer_path):
+        print("slm_bank_analyzer doesn't exist. Run phase 2 to build it")
+        return -1
+
+    trace_dir = find_trace_dir(trace_dir)
+    if trace_dir == "":
+        return -2
+
+    command = [analyzer_path, "-nb", str(num_banks), "-model", bank_model, "-threads", "0", "-top", str(top),
+               "-dir", os.path.abspath(trace_dir)]
+    if profile_path != "":
+        command[1:1] = ["-profile", os.path.abspath(profile_path)]
+    if cache_dir != "":
+        command[1:1] = ["-cache", os.path.abspath(cache_dir)]
+    print(">>", " ".join(command))
+    output = subprocess.run(command, stdout=subprocess.PIPE, universal_newlines=True)
+    if output.returncode != 0:
+        print("slm_bank_analyzer failed")
+        return -4
+
+    return json.loads(output.stdout)
+
+# Function for compare conflict profiles of two runs with the native slm_compare
+# path_gtpin: absolute or relative path to Intel GTPin (path to Profiler directory)
+# base_profile: conflict profile of the base run, stored by slm_bank_analyzer -profile (profile_path of run_batch_analyzer)
+# new_profile: conflict profile of the compared run
+# threshold: growth of stall cycles per SLM access of a kernel, in percent, reported as a regression
+# ins_threshold: growth of stall cycles per execution of an instruction, in percent, reported as a regression, 0 - not checked
+# Returns per-kernel and per-instruction changes: { "regressed": bool, "kernels": [...], "instructions": [...] }
+def compare_profiles(path_gtpin, base_profile, new_profile, threshold = 5, ins_threshold = 0):
+    compare_path = os.path.join(os.path.abspath(path_gtpin), "Examples", "build", "slm_compare")
+    if not os.path.exists(compare_path):
+        print("slm_compare doesn't exist. Run phase 2 to build it")
+        return -1
+
+    for profile in (base_profile, new_profile):
+        if not os.path.exists(profile):
+            print("Conflict profile " + profile + " doesn't exist")
+            return -2
+
+    command = [compare_path, "-threshold", str(threshold), "-ins-threshold", str(ins_threshold),
+               os.path.abspath(base_profile), os.path.abspath(new_profile)]
+    print(">>", " ".join(command))
+    output = subprocess.run(command, stdout=subprocess.PIPE, universal_newlines=True)
+    if output.returncode not in (0, 2):
+        print("slm_compare failed")
+        return -4
+
+    return json.loads(output.stdout)
@@ -1,4 +1,43 @@
+import json
 import os
+import subprocess
+
+# Function for creating the report with the native slm_report tool
+# Source lines and assembly are indexed once, and the report is split into pages of lines_per_page lines
+# path_gtpin: absolute or relative path to Intel GTPin (path to Profiler directory)
+# source_asm: output of the cl_debug_info sample of PTI, or memorytrace_asm.txt of the kernel without PTI
+# path_op: absolute or relative path where the report will be written
+# kernel_name: name of kernel
+# conflicts: { send-offset : [ [power percent] ... ] }
+# asm_only: source_asm is the assembly of the kernel without source lines
+# Returns paths of pages of the report
+def create_native_report(path_gtpin, source_asm, path_op, kernel_name, conflicts, asm_only = False, lines_per_page = 1000):
+    report_path = os.path.join(os.path.abspath(path_gtpin), "Examples", "build", "slm_report")
+    if not os.path.exists(report_path):
+        print("slm_report doesn't exist. Run phase 2 to build it")
+        return -1
+    if not os.path.exists(source_asm):
+        print("Source asm file doesn't exist")
+        return -2
+
+    abs_path_op = os.path.abspath(path_op)
+    if not os.path.exists(abs_path_op):
+        print("Result path doesn't exist. Create dir...")
+        print(">> mkdir", abs_path_op)
+        os.makedirs(abs_path_op)
+
+    conflicts_path = os.path.join(abs_path_op, "conflicts_" + kernel_name + ".json")
+    with open(conflicts_path, "w") as fout:
+        json.dump({str(offset): counts for offset, counts in conflicts.items()}, fout)
+
+    command = [report_path, "-asm" if asm_only else "-source", source_asm, "-conflicts", conflicts_path, \
+               "-kernel", kernel_name, "-page", str(lines_per_page), "-o", abs_path_op]
+    print(">>", " ".join(command))
+    output = subprocess.run(command, stdout=subprocess.PIPE, universal_newlines=True)
+    if output.returncode != 0:
+        print("slm_report failed")
+        return -3
+    return output.stdout.split()
 
 def create_report(source_asm, path_op, kernel_name, conflicts):
     if not os.path.exists(source_asm):